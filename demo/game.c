@@ -8,9 +8,12 @@
 #include "asset.h"
 #include "asset_cache.h"
 #include "collision.h"
+#include "collision_group.h"
+#include "contact_queue.h"
 #include "forces.h"
 #include "list.h"
 #include "sdl_wrapper.h"
+#include "timestep.h"
 #include "body.h"
 #include "color.h"
 #include <SDL2/SDL_mixer.h>
@@ -30,6 +33,7 @@ const vector_t MAX = {1000, 500}; // Maximum world coordinates
 const double PANEL_WIDTH = MAX.x * 0.85;
 const double PANEL_HEIGHT = MAX.y * 0.75;
 const double OFFSCREEN_X_REMOVAL_THRESHOLD = -50.0; // Remove objects past this threshold
+const double OFFSCREEN_STRIP_WIDTH = 200.0; // Width of the strip left of the threshold searched for bodies to remove; wider than any body moves in one step
 vector_t DUMMY_VEC = {0, 0};
 const double SCREEN_SCALE_1 = 0.3;
 const double SCREEN_SCALE_2 = 0.1;
@@ -42,6 +46,10 @@ const double FLOOR_SPRITE_HEIGHT = 50.0;
 static const double DEFAULT_THRUST_ACCEL = 1600; // Upward acceleration from thrust
 static const double GRAVITY_ACCEL = -1000; // Downward acceleration due to gravity
 const double UNIT_WEIGHT = 1.0;           // Default weight for some bodies
+const double BROAD_PHASE_CELL_SIZE = 100; // Grid cell size for collision culling
+const size_t REGION_QUERY_INIT_CAPACITY = 32; // Bodies expected in one region query
+const double SIMULATION_STEP = 1.0 / 120; // Length of each fixed simulation step, in seconds
+const size_t MAX_STEPS_PER_FRAME = 8; // Steps simulated at most per frame; slower frames slow the game down
 
 //Character
 const double CHARACTER_HEIGHT = 70;
@@ -52,7 +60,6 @@ const color_t CHARACTER_COLOR = (color_t){0.1, 0.9, 0.2};
 
 //Coin
 const double COIN_RADIUS = 15;
-const size_t COIN_NUM_POINTS = 12;
 const double COIN_SPAWN_INTERVAL = 3.0;
 const size_t COIN_NUM_MAX = 12;
 const size_t COIN_NUM_MIN = 4;
@@ -247,6 +254,31 @@ typedef enum {
   POWER_DISTANCE
 } power_type_t;
 
+/**
+ * @brief The fixed rectangle sizes the game spawns, each with a shape prototype held for the whole game.
+ */
+typedef enum {
+  CHARACTER_SHAPE,
+  OBSTACLE_SHAPE,
+  ALERT_SHAPE,
+  VERTICAL_LASER_SHAPE,
+  HORIZONTAL_LASER_SHAPE,
+  HEAT_SEEKING_ROCKET_SHAPE,
+  POWERUP_SHAPE,
+  SHURIKEN_SHAPE,
+  BACKGROUND_SHAPE,
+  FLOOR_SHAPE,
+  NUM_GAME_SHAPES
+} game_shape_t;
+
+/**
+ * @brief A buffer for region query results, kept between queries so they do not allocate.
+ */
+typedef struct {
+  body_t **found;
+  size_t capacity;
+} region_query_t;
+
 struct state {
   body_t *character;
   body_t *background_body1;
@@ -254,12 +286,25 @@ struct state {
   body_t *floor_body_1;
   body_t *floor_body_2;
   scene_t *scene;
+  // The character, and the hazards and pickups it is tested against
+  collision_group_t *character_group;
+  collision_group_t *target_group;
+  // Contacts between the groups, handled after each scene tick
+  contact_queue_t *contacts;
+  // Splits frame time into fixed simulation steps
+  timestep_t *timestep;
+  // Reused by every step's search for off-screen bodies
+  region_query_t offscreen_query;
+  // One reference to each game_shape_t's prototype, so spawning never rebuilds one
+  shape_prototype_t *shapes[NUM_GAME_SHAPES];
+  // The character, backgrounds and floors as first built, restored on restart
+  scene_snapshot_t *initial_level;
 
   double time_since_last;
   double time_since_last_powerup_spawn;
   bool   alert_shown;          
   double next_bug_y;          
-  body_t *alert_body;
+  body_handle_t alert_handle; // The upcoming obstacle's alert, while it is shown
   double shield_timer;
   double time_since_last_shuriken;
   
@@ -330,6 +375,10 @@ struct state {
   double total_game_time_seconds;
   body_t *distance_text_ui_body;
   body_t *time_text_ui_body;
+  // The text assets on the UI text bodies, updated in place each step
+  text_asset_t *score_text_asset;
+  text_asset_t *distance_text_asset;
+  text_asset_t *time_text_asset;
   
   size_t score_str_len;
   size_t dist_str_len;
@@ -349,151 +398,141 @@ double rand_double(double low, double high) {
 }
 
 /**
- * @brief Removes a body from the scene by its pointer.
- * @param scene The scene from which to remove the body.
- * @param body_to_remove A pointer to the body to remove.
+ * @brief Finds the bodies overlapping a region of the world.
+ * @param scene The scene to search.
+ * @param region The region to search.
+ * @param query The buffer to fill with the bodies found, grown if they do not fit.
+ * @return The number of bodies found.
  */
-void scene_remove_body_by_ptr(scene_t *scene, body_t *body) {
-  size_t n = scene_bodies(scene);
-  for (size_t i = 0; i < n; i++) {
-    if (scene_get_body(scene, i) == body) {
-      scene_remove_body(scene, i);
-      return;
-    }
+size_t query_region(scene_t *scene, aabb_t region, region_query_t *query) {
+  size_t count = scene_query_aabb(scene, region, query->found, query->capacity);
+  if (count > query->capacity) {
+    query->capacity = count;
+    query->found = realloc(query->found, sizeof(body_t *) * query->capacity);
+    assert(query->found);
+    count = scene_query_aabb(scene, region, query->found, query->capacity);
   }
+  return count;
 }
 
 /**
- * @brief Removes body from scene and asset list
+ * @brief Gets the shape prototype of a rectangle centered on the origin. The caller holds a reference to it.
+ * @param width The width of the rectangle.
+ * @param height The height of the rectangle.
+ * @return The prototype, to be released with shape_prototype_release.
  */
-void remove_body_and_asset(scene_t *scene, body_t *body) {
-  asset_remove_body(body);
-  scene_remove_body_by_ptr(scene, body);
+shape_prototype_t *get_rectangle_prototype(double width, double height) {
+  vector_t corners[RECTANGLE_POINTS] = {
+    {-width / 2.0, -height / 2.0},
+    { width / 2.0, -height / 2.0},
+    { width / 2.0,  height / 2.0},
+    {-width / 2.0,  height / 2.0}
+  };
+  return shape_prototype_get(corners, RECTANGLE_POINTS);
 }
 
 /**
- * @brief General abstracted function for creating all game objects with rectangular bodies. Called by object specific functions.
+ * @brief Takes a reference to the prototype of every fixed size the game spawns, kept until release_game_shapes.
+ * @param state A pointer to the current game state.
  */
-body_t *make_rectangle_body(double width, double height, body_info_type_t type) {
-  list_t *shape = list_init(RECTANGLE_POINTS, free);
-
-  vector_t *v1 = malloc(sizeof(vector_t));
-  *v1 = (vector_t){0,0};
-  list_add(shape, v1);
-  vector_t *v2 = malloc(sizeof(vector_t));
-  *v2 = (vector_t){width,0};
-  list_add(shape, v2);
-  vector_t *v3 = malloc(sizeof(vector_t));
-  *v3 = (vector_t){width, height};
-  list_add(shape, v3);
-  vector_t *v4 = malloc(sizeof(vector_t));
-  *v4 = (vector_t){0,height};
-  list_add(shape, v4);
+void hold_game_shapes(state_t *state) {
+  state->shapes[CHARACTER_SHAPE] = get_rectangle_prototype(CHARACTER_WIDTH, CHARACTER_HEIGHT);
+  state->shapes[OBSTACLE_SHAPE] = get_rectangle_prototype(OBSTACLE_WIDTH, OBSTACLE_HEIGHT);
+  state->shapes[ALERT_SHAPE] = get_rectangle_prototype(ALERT_SPRITE_WIDTH, ALERT_SPRITE_HEIGHT);
+  state->shapes[VERTICAL_LASER_SHAPE] = get_rectangle_prototype(VERTICAL_LASER_WIDTH, VERTICAL_LASER_HEIGHT);
+  state->shapes[HORIZONTAL_LASER_SHAPE] = get_rectangle_prototype(HORIZONTAL_LASER_WIDTH, HORIZONTAL_LASER_HEIGHT);
+  state->shapes[HEAT_SEEKING_ROCKET_SHAPE] = get_rectangle_prototype(HEAT_SEEKING_ROCKET_WIDTH, HEAT_SEEKING_ROCKET_HEIGHT);
+  state->shapes[POWERUP_SHAPE] = get_rectangle_prototype(POWERUP_WIDTH, POWERUP_HEIGHT);
+  state->shapes[SHURIKEN_SHAPE] = get_rectangle_prototype(SHURIKEN_SIZE, SHURIKEN_SIZE);
+  state->shapes[BACKGROUND_SHAPE] = get_rectangle_prototype(MAX.x, MAX.y);
+  state->shapes[FLOOR_SHAPE] = get_rectangle_prototype(MAX.x, FLOOR_SPRITE_HEIGHT);
+}
 
-  body_info_type_t *info = malloc(sizeof(body_info_type_t));
+/**
+ * @brief Drops the references taken by hold_game_shapes.
+ * @param state A pointer to the current game state.
+ */
+void release_game_shapes(state_t *state) {
+  for (size_t i = 0; i < NUM_GAME_SHAPES; i++) {
+    shape_prototype_release(state->shapes[i]);
+  }
+}
+
+/**
+ * @brief General abstracted function for creating all game objects with rectangular bodies. Called by object specific functions.
+ * @param shape The prototype of the body's rectangle; every body of the same size shares one instead of its own vertices.
+ * @param type The type of game object, stored as the body's info and tag.
+ * @param color The color of the body.
+ */
+body_t *make_rectangle_body(shape_prototype_t *shape, body_info_type_t type, color_t color) {
+  body_info_type_t *info = body_info_alloc(sizeof(body_info_type_t));
   *info = type;
 
-  body_t *body = body_init_with_info(shape, UNIT_WEIGHT, PLACEHOLDER_COLOR, info, free);
+  body_t *body = body_init_from_prototype(shape, UNIT_WEIGHT, color, info, body_info_free);
+  body_set_tag(body, type);
   return body;
 }
 
-body_t *make_character_body(double width, double height) {
-  return make_rectangle_body(width, height, CHARACTER);
+body_t *make_character_body(state_t *state) {
+  return make_rectangle_body(state->shapes[CHARACTER_SHAPE], CHARACTER, PLACEHOLDER_COLOR);
 }
 
-body_t *make_obstacle_body(size_t w, size_t h, vector_t center) {
-  body_t *obstacle = make_rectangle_body(w, h, OBSTACLE);
+body_t *make_obstacle_body(shape_prototype_t *shape, vector_t center) {
+  body_t *obstacle = make_rectangle_body(shape, OBSTACLE, PLACEHOLDER_COLOR);
   body_set_centroid(obstacle, center);
   return obstacle;
 }
 
-body_t *make_vertical_laser_body(vector_t center) {
-  body_t *laser_v = make_rectangle_body(VERTICAL_LASER_WIDTH, VERTICAL_LASER_HEIGHT, VERTICAL_LASER);
+body_t *make_vertical_laser_body(state_t *state, vector_t center) {
+  body_t *laser_v = make_rectangle_body(state->shapes[VERTICAL_LASER_SHAPE], VERTICAL_LASER, PLACEHOLDER_COLOR);
   body_set_centroid(laser_v, center);
   return laser_v;
 }
 
-body_t *make_horizontal_laser_body(vector_t center) {
- body_t *laser_h = make_rectangle_body(HORIZONTAL_LASER_WIDTH, HORIZONTAL_LASER_HEIGHT, HORIZONTAL_LASER);
+body_t *make_horizontal_laser_body(state_t *state, vector_t center) {
+ body_t *laser_h = make_rectangle_body(state->shapes[HORIZONTAL_LASER_SHAPE], HORIZONTAL_LASER, PLACEHOLDER_COLOR);
   body_set_centroid(laser_h, center);
   return laser_h;
 }
 
-body_t *make_heat_seeking_rocket_body(vector_t center) {
-  body_t *hs_rocket = make_rectangle_body(HEAT_SEEKING_ROCKET_WIDTH, HEAT_SEEKING_ROCKET_HEIGHT, HEAT_SEEK_ROCKET);
+body_t *make_heat_seeking_rocket_body(state_t *state, vector_t center) {
+  body_t *hs_rocket = make_rectangle_body(state->shapes[HEAT_SEEKING_ROCKET_SHAPE], HEAT_SEEK_ROCKET, PLACEHOLDER_COLOR);
   body_set_centroid(hs_rocket, center);
   return hs_rocket;
 }
 
-body_t *make_powerup_body(vector_t center) {
-  body_t *pu = make_rectangle_body(POWERUP_WIDTH, POWERUP_HEIGHT, POWERUP);
+body_t *make_powerup_body(state_t *state, vector_t center) {
+  body_t *pu = make_rectangle_body(state->shapes[POWERUP_SHAPE], POWERUP, PLACEHOLDER_COLOR);
   body_set_centroid(pu, center);
   return pu;
 }
 
-body_t *make_shuriken_body(vector_t center) {
-  list_t *pts = list_init(RECTANGLE_POINTS, free);
-  vector_t corners[RECTANGLE_POINTS] = {
-    { -SHURIKEN_SIZE/2, -SHURIKEN_SIZE/2 },
-    {  SHURIKEN_SIZE/2, -SHURIKEN_SIZE/2 },
-    {  SHURIKEN_SIZE/2,  SHURIKEN_SIZE/2 },
-    { -SHURIKEN_SIZE/2,  SHURIKEN_SIZE/2 }
-  };
-  for (int i = 0; i < RECTANGLE_POINTS; i++) {
-    vector_t *p = malloc(sizeof(*p));
-    *p = corners[i];
-    list_add(pts, p);
-  }
-  body_info_type_t *info = malloc(sizeof(body_info_type_t));
-  *info = SHURIKEN;
-  body_t *shuriken = body_init_with_info(pts, UNIT_WEIGHT, (color_t){1,1,1}, info, free);
+body_t *make_shuriken_body(state_t *state, vector_t center) {
+  body_t *shuriken = make_rectangle_body(state->shapes[SHURIKEN_SHAPE], SHURIKEN, (color_t){1,1,1});
   body_set_centroid(shuriken, center);
   return shuriken;
 }
 
-body_t *make_background_body(scene_t *scene, const char *img_path, vector_t center, double width, double height) {
-  list_t *body_list = list_init(RECTANGLE_POINTS, free);
-
-  vector_t *v1 = malloc(sizeof(vector_t)); 
-  *v1 = (vector_t){-width / 2.0, -height / 2.0}; 
-  list_add(body_list, v1);
-  vector_t *v2 = malloc(sizeof(vector_t)); 
-  *v2 = (vector_t){ width / 2.0, -height / 2.0}; 
-  list_add(body_list, v2);
-  vector_t *v3 = malloc(sizeof(vector_t)); 
-  *v3 = (vector_t){ width / 2.0,  height / 2.0}; 
-  list_add(body_list, v3);
-  vector_t *v4 = malloc(sizeof(vector_t)); 
-  *v4 = (vector_t){-width / 2.0,  height / 2.0}; 
-  list_add(body_list, v4);
-
-  body_info_type_t *info = malloc(sizeof(body_info_type_t));
-  *info = BACKGROUND;
-  body_t *background_body = body_init_with_info(body_list, UNIT_WEIGHT, (color_t){0,0,0}, info, free);
+body_t *make_background_body(state_t *state, const char *img_path, vector_t center, game_shape_t shape) {
+  body_t *background_body = make_rectangle_body(state->shapes[shape], BACKGROUND, (color_t){0,0,0});
   
   body_set_centroid(background_body, center);
   body_set_velocity(background_body, BACKGROUND_VEL);
-  scene_add_body(scene, background_body);
+  // Backgrounds and floors only scroll, so they skip force integration
+  body_set_motion(background_body, BODY_KINEMATIC);
+  scene_add_body(state->scene, background_body);
   asset_make_image_with_body(img_path, background_body);
 
   return background_body;
 }
 
 body_t *make_coin_body(vector_t center) {
-  list_t *coin_points = list_init(COIN_NUM_POINTS, free);
-  
-  for (size_t i=0; i<COIN_NUM_POINTS; i++) {
-    double angle = TWO_PI * i / COIN_NUM_POINTS;
-    vector_t *v = malloc(sizeof(vector_t));
-    *v = (vector_t) {COIN_RADIUS * cos(angle), COIN_RADIUS * sin(angle)};
-    list_add(coin_points, v);
-  }
-
-  body_info_type_t *info = malloc(sizeof(body_info_type_t));
+  body_info_type_t *info = body_info_alloc(sizeof(body_info_type_t));
   *info = COIN;
   
-  body_t *coin_body = body_init_with_info(coin_points, UNIT_WEIGHT, PLACEHOLDER_COLOR, info, free);
-  body_set_centroid(coin_body, center);
+  body_t *coin_body = body_init_circle(center, COIN_RADIUS, UNIT_WEIGHT,
+                                       PLACEHOLDER_COLOR, info, body_info_free);
+  body_set_tag(coin_body, COIN);
   
   return coin_body;
 }
@@ -502,14 +541,10 @@ body_t *make_coin_body(vector_t center) {
 //                             QUIZ AND UI FUNCTIONS                          //
 //----------------------------------------------------------------------------//
 
-void queue_body_for_removal(scene_t *scene, body_t *b) {
-  asset_remove_body(b); 
-  body_remove(b);                       
-}
-
 void remove_all_text_assets_for_body(body_t *b) {
   list_t *assets = asset_get_asset_list();
-  for (size_t i = 0; i < list_size(assets); i++) {
+  // Walk backwards, so removing an asset never skips the one after it
+  for (size_t i = list_size(assets); i-- > 0; ) {
     asset_t *a = list_get(assets, i);
     if (a->type == ASSET_TEXT) {
       text_asset_t *txt = (text_asset_t *)a;
@@ -517,7 +552,6 @@ void remove_all_text_assets_for_body(body_t *b) {
         free(txt->text);                   
         asset_t *removed = list_remove(assets, i);
         asset_destroy(removed);            
-        continue;
       }
     }
   }
@@ -541,26 +575,26 @@ list_t *rect_for_text(const char *font_path, int pt_size, char *text) {
 void hide_quiz(state_t *state) {
   if (state->quiz_question_text_body) {
     remove_all_text_assets_for_body(state->quiz_question_text_body);
-    queue_body_for_removal(state->scene, state->quiz_question_text_body);
+    body_remove(state->quiz_question_text_body);
     state->quiz_question_text_body = NULL;
   }
 
   if (state->quiz_panel_body) {
-    queue_body_for_removal(state->scene, state->quiz_panel_body);
+    body_remove(state->quiz_panel_body);
     state->quiz_panel_body = NULL;
   }
 
   if (state->quiz_option_text_bodies) {
     for (size_t i = 0; i < list_size(state->quiz_option_text_bodies); i++) {
       body_t *curr_body = (body_t *)list_get(state->quiz_option_text_bodies, i);
-      queue_body_for_removal(state->scene, curr_body);
+      body_remove(curr_body);
     }
     while(list_size(state->quiz_option_text_bodies) > 0) {
       list_remove(state->quiz_option_text_bodies, 0);
     }
   }
   if (state->quiz_timer_text_body) {
-    queue_body_for_removal(state->scene, state->quiz_timer_text_body);
+    body_remove(state->quiz_timer_text_body);
     state->quiz_timer_text_body = NULL;
   }
 }
@@ -592,6 +626,7 @@ void display_current_question(state_t *state) {
   state->quiz_panel_body = body_init(panel_pts, PANEL_WEIGHT, UI_PANEL_COLOR);
   asset_make_image_with_body(PANEL_PATH, state->quiz_panel_body);
   body_set_centroid(state->quiz_panel_body, panel_ctr);
+  body_set_motion(state->quiz_panel_body, BODY_STATIC);
   scene_add_body(state->scene, state->quiz_panel_body);
   
   // quiz question
@@ -600,6 +635,7 @@ void display_current_question(state_t *state) {
 
   
   body_set_centroid(state->quiz_question_text_body,(vector_t){ panel_ctr.x, panel_ctr.y + panel_h*SCREEN_SCALE_1});
+  body_set_motion(state->quiz_question_text_body, BODY_STATIC);
   scene_add_body(state->scene, state->quiz_question_text_body);
   char *heap_copy = strdup(quiz->question_text);
   asset_make_text_with_body(quiz->font_path, state->quiz_question_text_body, heap_copy, UI_TEXT_COLOR);
@@ -616,6 +652,7 @@ void display_current_question(state_t *state) {
     list_t *opt_pts = rect_for_text(quiz->font_path, QUIZ_FONT_SZ_OPTION, opt_text);
     body_t *opt_body = body_init(opt_pts, PANEL_WEIGHT, UI_TEXT_COLOR);
     body_set_centroid(opt_body,(vector_t){ panel_ctr.x,start_y - i*option_step });
+    body_set_motion(opt_body, BODY_STATIC);
     scene_add_body(state->scene, opt_body);
     asset_make_text_with_body(quiz->font_path,opt_body,opt_text,UI_TEXT_COLOR);
     list_add(state->quiz_option_text_bodies, opt_body);
@@ -628,6 +665,7 @@ void display_current_question(state_t *state) {
   vector_t timer_pos = (vector_t){ panel_ctr.x + panel_w/2 - PANEL_SCALE, panel_ctr.y + panel_h/2 - (PANEL_SCALE/2) };
   state->quiz_timer_text_body = body_init(tshape, PANEL_WEIGHT, UI_TEXT_COLOR);
   body_set_centroid(state->quiz_timer_text_body, timer_pos);
+  body_set_motion(state->quiz_timer_text_body, BODY_STATIC);
   scene_add_body(state->scene, state->quiz_timer_text_body);
   asset_make_text_with_body(FONT_PATH, state->quiz_timer_text_body, timer_str, UI_TEXT_COLOR);
 
@@ -638,19 +676,29 @@ void display_current_question(state_t *state) {
 //----------------------------------------------------------------------------//
 
 void display_game_over(state_t *state) {
-  scene_free(state->scene);
-  state->scene = scene_init();
+  // Clear the scene in place so a restart can restore the level snapshot,
+  // which keeps the level bodies until then
+  for (size_t i = 0; i < scene_bodies(state->scene); i++) {
+    body_remove(scene_get_body(state->scene, i));
+  }
 
-  // clear every asset so nothing refers to a freed body
+  // clear every asset so nothing refers to a removed body
+  free(state->time_text_asset->text);
+  free(state->distance_text_asset->text);
+  free(state->score_text_asset->text);
+  state->time_text_asset = NULL;
+  state->distance_text_asset = NULL;
+  state->score_text_asset = NULL;
   list_t *assets = asset_get_asset_list();
   while (list_size(assets) > 0) {
-    asset_t *a = list_remove(assets, 0);
+    asset_t *a = list_remove(assets, list_size(assets) - 1);
     asset_destroy(a);
   }
   
   // full‐screen 8-bit background
-  body_t *bg = make_rectangle_body(MAX.x, MAX.y, UI);
+  body_t *bg = make_rectangle_body(state->shapes[BACKGROUND_SHAPE], UI, PLACEHOLDER_COLOR);
   body_set_centroid(bg, (vector_t){MAX.x/2, MAX.y/2});
+  body_set_motion(bg, BODY_STATIC);
   scene_add_body(state->scene, bg);
   asset_make_image_with_body("assets/images/game_over_screen.png", bg);
 
@@ -661,6 +709,7 @@ void display_game_over(state_t *state) {
                                    malloc(sizeof(body_info_type_t)), free);
   *(body_info_type_t *)body_get_info(b1) = UI;
   body_set_centroid(b1, (vector_t){ MAX.x/2, MAX.y * 0.30 });
+  body_set_motion(b1, BODY_STATIC);
   scene_add_body(state->scene, b1);
   asset_make_text_with_body(FONT_PATH, b1, strdup(msg), UI_TEXT_COLOR);
 
@@ -673,6 +722,7 @@ void display_game_over(state_t *state) {
   body_t *b2 = body_init_with_info(pts2, UNIT_WEIGHT, PLACEHOLDER_COLOR, malloc(sizeof(body_info_type_t)), free);
   *(body_info_type_t *)body_get_info(b2) = UI;
   body_set_centroid(b2, (vector_t){ MAX.x/2, MAX.y * 0.45 });
+  body_set_motion(b2, BODY_STATIC);
   scene_add_body(state->scene, b2);
   asset_make_text_with_body(FONT_PATH, b2, stats, UI_TEXT_COLOR);
 
@@ -682,6 +732,7 @@ void display_game_over(state_t *state) {
   body_t *b3 = body_init_with_info(pts3, UNIT_WEIGHT, PLACEHOLDER_COLOR, malloc(sizeof(body_info_type_t)), free);
   *(body_info_type_t *)body_get_info(b3) = UI;
   body_set_centroid(b3, (vector_t){ MAX.x/2, MAX.y * 0.60 });
+  body_set_motion(b3, BODY_STATIC);
   scene_add_body(state->scene, b3);
   asset_make_text_with_body(FONT_PATH, b3, strdup(prompt), UI_TEXT_COLOR);
 
@@ -707,25 +758,28 @@ void make_ui_component_bodies(state_t *state) {
   *info_time = UI;
   state->time_text_ui_body = body_init_with_info(time_pts, UNIT_WEIGHT, PLACEHOLDER_COLOR, info_time, free);
   body_set_centroid(state->time_text_ui_body, TIME_TEXT_POS);
+  body_set_motion(state->time_text_ui_body, BODY_STATIC);
 
   list_t *dist_pts = rect_for_text(FONT_PATH, DIST_FONT_SIZE, dist_text);
   body_info_type_t *info_dist = malloc(sizeof(body_info_type_t));
   *info_dist = UI;
   state->distance_text_ui_body = body_init_with_info(dist_pts, UNIT_WEIGHT, PLACEHOLDER_COLOR, info_dist, free);
   body_set_centroid(state->distance_text_ui_body, DISTANCE_TEXT_POS);
+  body_set_motion(state->distance_text_ui_body, BODY_STATIC);
 
   list_t *score_pts = rect_for_text(FONT_PATH, SCORE_FONT_SIZE, score_text);
   body_info_type_t *info_score = malloc(sizeof(body_info_type_t));
   *info_score = UI;
   state->score_text_ui_body = body_init_with_info(score_pts, UNIT_WEIGHT, PLACEHOLDER_COLOR, info_score, free);
   body_set_centroid(state->score_text_ui_body, SCORE_TEXT_POS);
+  body_set_motion(state->score_text_ui_body, BODY_STATIC);
 
   scene_add_body(state->scene, state->score_text_ui_body);
   scene_add_body(state->scene, state->distance_text_ui_body);
   scene_add_body(state->scene, state->time_text_ui_body);
-  asset_make_text_with_body(FONT_PATH, state->time_text_ui_body, strdup(time_text), UI_TEXT_COLOR);
-  asset_make_text_with_body(FONT_PATH, state->distance_text_ui_body, strdup(dist_text), UI_TEXT_COLOR);
-  asset_make_text_with_body(FONT_PATH, state->score_text_ui_body, strdup(score_text), UI_TEXT_COLOR);
+  state->time_text_asset = asset_make_text_with_body(FONT_PATH, state->time_text_ui_body, strdup(time_text), UI_TEXT_COLOR);
+  state->distance_text_asset = asset_make_text_with_body(FONT_PATH, state->distance_text_ui_body, strdup(dist_text), UI_TEXT_COLOR);
+  state->score_text_asset = asset_make_text_with_body(FONT_PATH, state->score_text_ui_body, strdup(score_text), UI_TEXT_COLOR);
 
   //make coin icon
   SDL_Rect coin_ui_rect = {
@@ -737,15 +791,55 @@ void make_ui_component_bodies(state_t *state) {
   asset_make_image(COIN_PATHS[0], coin_ui_rect);
 } 
 
-void reset_game(state_t *state) {
-  asset_cache_destroy();
-  asset_cache_init();
-  /* clear scene */
-  for (size_t i = scene_bodies(state->scene); i-- > 0; ) {
-    body_t *b = scene_get_body(state->scene, i);
-    remove_body_and_asset(state->scene, b);
+/**
+ * @brief Returns whether an asset is one of the UI texts, which are drawn after every other asset.
+ */
+bool is_ui_text_asset(state_t *state, asset_t *asset) {
+  return asset == (asset_t *)state->time_text_asset ||
+         asset == (asset_t *)state->distance_text_asset ||
+         asset == (asset_t *)state->score_text_asset;
+}
+
+/**
+ * @brief Shows new text on one of the UI text bodies by editing its text asset in place, so the asset list is not searched or shifted.
+ * The body is only rebuilt, with a new asset, when the text grows longer than any it has shown.
+ * @param state The game state.
+ * @param body The UI text body, replaced if it is rebuilt.
+ * @param asset The text asset on the body, replaced if the body is rebuilt.
+ * @param str_len The length of the longest text the body has shown.
+ * @param text The text to show; it is copied.
+ * @param font_size The font size the text is drawn at.
+ * @param position Where the body is centered.
+ */
+void update_ui_text(state_t *state, body_t **body, text_asset_t **asset, size_t *str_len, char *text, size_t font_size, vector_t position) {
+  if (strcmp((*asset)->text, text) == 0) {
+    return;
+  }
+  free((*asset)->text);
+  size_t new_len = strlen(text);
+  if (new_len <= *str_len) {
+    (*asset)->text = strdup(text);
+    return;
   }
 
+  // The old asset is hidden along with its body, and the sweep that destroys it never reads its text
+  (*asset)->text = NULL;
+  body_remove(*body);
+  list_t *pts = rect_for_text(FONT_PATH, font_size, text);
+  body_info_type_t *info = malloc(sizeof(body_info_type_t));
+  *info = UI;
+  *body = body_init_with_info(pts, UNIT_WEIGHT, PLACEHOLDER_COLOR, info, free);
+  body_set_centroid(*body, position);
+  body_set_motion(*body, BODY_STATIC);
+  scene_add_body(state->scene, *body);
+  *asset = asset_make_text_with_body(FONT_PATH, *body, strdup(text), UI_TEXT_COLOR);
+  *str_len = new_len;
+}
+
+void reset_game(state_t *state) {
+  /* put the level back the way it was first built; everything spawned since is removed along with its assets */
+  scene_restore(state->scene, state->initial_level);
+
   /* reset timers, flags & counters */
   state->score = 0;
   state->distance_traveled_meters = 0;
@@ -753,7 +847,7 @@ void reset_game(state_t *state) {
   state->time_since_last = 0;
   state->time_since_last_powerup_spawn = 0;
   state->alert_shown = false;
-  state->alert_body = NULL;
+  state->alert_handle = BODY_HANDLE_NONE;
   state->shield_timer = 0;
   state->time_since_last_shuriken = 0;
   state->coin_frame_index = 0;
@@ -778,6 +872,7 @@ void reset_game(state_t *state) {
   state->speed_boost_timer = 0.0;
   state->obstacle_slow_timer = 0.0;
   state->pending_power = POWER_SHIELD;
+  timestep_reset(state->timestep);
 
   /* reset quiz state */
   state->current_question_data = NULL;
@@ -797,44 +892,25 @@ void reset_game(state_t *state) {
   state->current_game_mode = GAME_MODE_PLAYING;
   state->thrust_accel = DEFAULT_THRUST_ACCEL;
 
-  state->character = NULL;
-  state->background_body1 = NULL;
-  state->background_body2 = NULL;
-  state->floor_body_1 = NULL;
-  state->floor_body_2 = NULL;
-  state->alert_body = NULL;
+  state->alert_handle = BODY_HANDLE_NONE;
   state->quiz_panel_body = NULL;
   state->quiz_question_text_body = NULL;
   state->quiz_timer_text_body = NULL;
   state->score_text_ui_body = NULL;
   state->distance_text_ui_body = NULL;
   state->time_text_ui_body = NULL;
+  state->score_text_asset = NULL;
+  state->distance_text_asset = NULL;
+  state->time_text_asset = NULL;
   BACKGROUND_VEL = CONSTANT_VEL_BACKGROUND;
 
-  /* recreate character */
-  body_t *character = make_character_body(CHARACTER_WIDTH, CHARACTER_HEIGHT);
-  body_set_centroid(character, RESET_POS);
-  state->character = character;
-  scene_add_body(state->scene, character);
-  asset_make_image_with_body(NORMAL_CHARACTER_PATH, character);
-
-  /* recreate background & floor */
-  vector_t bg1_ctr = { MAX.x/2, MAX.y/2 };
-  state->background_body1 = make_background_body(
-    state->scene, BACKGROUND_PATH, bg1_ctr, MAX.x, MAX.y
-  );
-  vector_t bg2_ctr = { MAX.x/2 + MAX.x, MAX.y/2 };
-  state->background_body2 = make_background_body(
-    state->scene, BACKGROUND_PATH, bg2_ctr, MAX.x, MAX.y
-  );
-  vector_t fl1_ctr = { MAX.x/2, FLOOR_SPRITE_HEIGHT/2 };
-  state->floor_body_1 = make_background_body(
-    state->scene, FLOOR_PATH, fl1_ctr, MAX.x, FLOOR_SPRITE_HEIGHT
-  );
-  vector_t fl2_ctr = { MAX.x/2 + MAX.x, FLOOR_SPRITE_HEIGHT/2 };
-  state->floor_body_2 = make_background_body(
-    state->scene, FLOOR_PATH, fl2_ctr, MAX.x, FLOOR_SPRITE_HEIGHT
-  );
+  /* the character, backgrounds and floors were restored, but game over took away their sprites and the character's group */
+  asset_make_image_with_body(BACKGROUND_PATH, state->background_body1);
+  asset_make_image_with_body(BACKGROUND_PATH, state->background_body2);
+  asset_make_image_with_body(FLOOR_PATH, state->floor_body_1);
+  asset_make_image_with_body(FLOOR_PATH, state->floor_body_2);
+  asset_make_image_with_body(NORMAL_CHARACTER_PATH, state->character);
+  collision_group_add(state->character_group, state->character);
 
   make_ui_component_bodies(state);
 }
@@ -873,6 +949,7 @@ void play_sfx(Mix_Chunk *sfx_chunk, bool isCoin) {
  */
 void reset_user(body_t *body) { 
   body_set_centroid(body, RESET_POS); 
+  body_reset_interpolation(body);
 }
 
  // if speed-boost is active, slow rockets by the same multiplier
@@ -880,12 +957,80 @@ static double rocket_horiz_speed_for(state_t *state) {
   return ROCKET_HORIZONTAL_SPEED * (state->speed_boost_active ? MULTIPLIER_VEL : 1.0);
 }
 
+/**
+ * @brief Bounces a powerup off the top of the screen and the floor. Called on every POWERUP body.
+ */
+void bounce_powerup(body_t *b, void *aux) {
+  vector_t pos = body_get_centroid(b);
+  vector_t vel = body_get_velocity(b);
+
+  double top_limit = MAX.y - POWERUP_HEIGHT/2.0;
+  double bot_limit = MIN.y + FLOOR_SPRITE_HEIGHT + POWERUP_HEIGHT/2.0;
+
+  if (pos.y >= top_limit && vel.y > 0) {
+    vel.y = -vel.y;
+    body_set_velocity(b, vel);
+  }
+  else if (pos.y <= bot_limit && vel.y < 0) {
+    vel.y = -vel.y;
+    body_set_velocity(b, vel);
+  }
+}
+
+/**
+ * @brief Spins a shuriken for one step. Called on every SHURIKEN body.
+ * @param aux A pointer to the step's dt.
+ */
+void spin_shuriken(body_t *b, void *aux) {
+  double dt = *(double *)aux;
+  double old_angle = body_get_rotation(b);
+  body_set_rotation(b, old_angle + SHURIKEN_ROT_SPEED * dt);
+}
+
+/**
+ * @brief What steer_rocket() needs to home rockets in on the player for one step.
+ */
+typedef struct {
+  state_t *state;
+  vector_t target; // The player's center
+  double dt;
+} rocket_steering_t;
+
+/**
+ * @brief Turns a heat seeking rocket towards the player. Called on every HEAT_SEEK_ROCKET body.
+ * @param aux A pointer to a rocket_steering_t.
+ */
+void steer_rocket(body_t *rocket, void *aux) {
+  rocket_steering_t *steering = aux;
+  vector_t rocket_pos = body_get_centroid(rocket);
+  vector_t current_rocket_vel = body_get_velocity(rocket);
+  double new_vy = current_rocket_vel.y;
+  if (rocket_pos.x > steering->target.x) { 
+    double dy_to_player = steering->target.y - rocket_pos.y;
+
+    // Adjust vertical velocity towards the player
+    if (dy_to_player > 0) {
+        new_vy += ROCKET_VERTICAL_ADJUST_RATE * steering->dt;
+    } else if (dy_to_player < 0) {
+        new_vy -= ROCKET_VERTICAL_ADJUST_RATE * steering->dt;
+    }
+
+    // Clamp vertical speed
+    if (new_vy > ROCKET_MAX_VERTICAL_SPEED) {
+        new_vy = ROCKET_MAX_VERTICAL_SPEED;
+    } else if (new_vy < -ROCKET_MAX_VERTICAL_SPEED) {
+        new_vy = -ROCKET_MAX_VERTICAL_SPEED;
+    }
+  }
+
+  body_set_velocity(rocket, (vector_t){rocket_horiz_speed_for(steering->state), new_vy});
+}
+
 void player_obstacle_collision_handler(body_t *body1, body_t *body2, vector_t axis, void *aux,
                         double force_const) {
   state_t *state = (state_t *)aux;
   if(state->shielded){
-    scene_remove_body_by_ptr(state->scene, body2);
-    asset_remove_body(body2);
+    body_remove(body2);
     return;
   } else {
     if (state->sfx_gameover) {
@@ -906,8 +1051,7 @@ void power_up_collected_handler(body_t *character, body_t *powerup_item, vector_
   int choice = rand() % NUM_POWER_TYPES;
   state->pending_power = (power_type_t)choice;
   state->has_pending_power = true;
-  asset_remove_body(powerup_item);
-  scene_remove_body_by_ptr(state->scene, powerup_item);
+  body_remove(powerup_item);
   state->current_game_mode = GAME_MODE_QUIZ;
   state->quiz_time_remaining = QUIZ_TIME_INIT;
   int question_idx = rand() % (int)QUIZ_BANK_LEN;
@@ -924,7 +1068,65 @@ void coin_collected_handler(body_t *character, body_t *coin, vector_t axis, void
   }else{
     play_sfx(state->sfx_coin_collect_two, true);
   }
-  remove_body_and_asset(state->scene, coin);
+  body_remove(coin);
+}
+
+/**
+ * @brief Handles every new contact found by the group contact pass.
+ * The character is the only member of the first group, so it is always body1.
+ */
+void character_collision_handler(body_t *character, body_t *other, vector_t axis, void *aux,
+                                 double force_const) {
+  body_info_type_t *info = body_get_info(other);
+  switch (*info) {
+    case COIN:
+      coin_collected_handler(character, other, axis, aux, force_const);
+      break;
+    case POWERUP:
+      power_up_collected_handler(character, other, axis, aux, force_const);
+      break;
+    default:
+      player_obstacle_collision_handler(character, other, axis, aux, force_const);
+      break;
+  }
+}
+
+/**
+ * @brief Reacts to a contact event once the scene tick that found it is over.
+ * Only contacts that just began matter to the game.
+ * @param event The contact event from the group contact pass.
+ * @param aux A pointer to the current game state.
+ */
+void handle_contact_event(contact_event_t event, void *aux) {
+  if (event.type == CONTACT_BEGIN) {
+    character_collision_handler(event.body1, event.body2, event.axis, aux, 0);
+  }
+}
+
+/**
+ * @brief Creates an empty scene with the broad phase and the group contact pass set up.
+ * @param state A pointer to the current game state.
+ */
+void init_game_scene(state_t *state) {
+  state->scene = scene_init();
+  scene_enable_spatial_hash(state->scene, BROAD_PHASE_CELL_SIZE);
+  state->character_group = collision_group_init();
+  state->target_group = collision_group_init();
+  state->contacts = contact_queue_init();
+  // Only contacts that begin matter to the game, so skip the stay events
+  create_group_contact_events(state->scene, state->character_group,
+                              state->target_group, state->contacts, false);
+}
+
+/**
+ * @brief Frees the scene, collision groups and contact queue made by init_game_scene.
+ * @param state A pointer to the current game state.
+ */
+void free_game_scene(state_t *state) {
+  scene_free(state->scene);
+  collision_group_free(state->character_group);
+  collision_group_free(state->target_group);
+  contact_queue_free(state->contacts);
 }
 
 //----------------------------------------------------------------------------//
@@ -939,9 +1141,9 @@ void coin_collected_handler(body_t *character, body_t *coin, vector_t axis, void
 void spawn_alert(state_t *state) {
   vector_t character_pos = body_get_centroid(state->character);
   vector_t alert_initial_center = {MAX.x - 20, character_pos.y};
-  state->alert_body = make_obstacle_body(ALERT_SPRITE_WIDTH, ALERT_SPRITE_HEIGHT, alert_initial_center);
-  scene_add_body(state->scene, state->alert_body);
-  asset_make_image_with_body(ALERT_PATH, state->alert_body);
+  body_t *alert_body = make_obstacle_body(state->shapes[ALERT_SHAPE], alert_initial_center);
+  state->alert_handle = scene_add_body(state->scene, alert_body);
+  asset_make_image_with_body(ALERT_PATH, alert_body);
   if (state && state->sfx_alert) {
     play_sfx(state->sfx_alert, false);
   }
@@ -953,53 +1155,38 @@ void spawn_alert(state_t *state) {
  */
 void spawn_obstacle(state_t *state) {
   double w = OBSTACLE_WIDTH; 
-  double h = OBSTACLE_HEIGHT;
   vector_t center = { MAX.x + w/2.0, state->next_bug_y };
-  body_t *ob = make_obstacle_body(w, h, center);
+  body_t *ob = make_obstacle_body(state->shapes[OBSTACLE_SHAPE], center);
   body_set_velocity(ob, (vector_t){ -BASE_OBJ_VEL.x*20, 0 });
   scene_add_body(state->scene, ob);
   //upon collision we need to make a game over screen instead of just moving to start pos
-  create_collision(state->scene,
-                   state->character,
-                   ob,
-                   player_obstacle_collision_handler,
-                   state,
-                   0, 
-                   NULL);
+  //obstacles are fast enough to skip past the character in one tick, so sweep them
+  create_swept_collision(state->scene,
+                         state->character,
+                         ob,
+                         player_obstacle_collision_handler,
+                         state,
+                         0,
+                         NULL);
 
   asset_make_image_with_body(MOVING_OBSTACLE_PATH, ob);
 }
 
 void spawn_vertical_laser(state_t *state, double y_pos) {
   vector_t center = {MAX.x + VERTICAL_LASER_WIDTH/2.0, y_pos};
-  body_t *vl = make_vertical_laser_body(center);
+  body_t *vl = make_vertical_laser_body(state, center);
   body_set_velocity(vl, BACKGROUND_VEL);
   scene_add_body(state->scene, vl);
-
-  create_collision(state->scene,
-                   state->character,
-                   vl,
-                   player_obstacle_collision_handler,
-                   state,
-                   0, 
-                   NULL);
+  collision_group_add(state->target_group, vl);
   asset_make_image_with_body(LASER_VERTICAL_PATHS[0], vl);
 }
 
 void spawn_horizontal_laser(state_t *state, double y_pos) {
   vector_t center = {MAX.x + HORIZONTAL_LASER_WIDTH/2.0, y_pos};
-  body_t *vh = make_horizontal_laser_body(center);
+  body_t *vh = make_horizontal_laser_body(state, center);
   body_set_velocity(vh, BACKGROUND_VEL);
   scene_add_body(state->scene, vh);
-
-  create_collision(state->scene,
-                   state->character,
-                   vh,
-                   player_obstacle_collision_handler,
-                   state,
-                   0, 
-                   NULL);
-                   
+  collision_group_add(state->target_group, vh);
   asset_make_image_with_body(LASER_HORIZONTAL_PATHS[0], vh);
 }
 void spawn_shuriken(state_t *state) {
@@ -1008,33 +1195,28 @@ void spawn_shuriken(state_t *state) {
     MAX.y - 30
   );
   vector_t center = { MAX.x + 30, y };
-  body_t *sh = make_shuriken_body(center);
+  body_t *sh = make_shuriken_body(state, center);
   body_set_velocity(sh, BACKGROUND_VEL);
   scene_add_body(state->scene, sh);
-  create_collision(state->scene,
-                   state->character,
-                   sh,
-                   player_obstacle_collision_handler,
-                   state,
-                   0, NULL);
+  collision_group_add(state->target_group, sh);
   asset_make_image_with_body(SHURIKEN_PATH, sh);
 }
 
 
 void spawn_heat_seeking_rocket(state_t *state) {
   vector_t spawn_pos = (vector_t){.x = MAX.x + HEAT_SEEKING_ROCKET_WIDTH, state->next_bug_y};
-  body_t *rocket = make_heat_seeking_rocket_body(spawn_pos);
+  body_t *rocket = make_heat_seeking_rocket_body(state, spawn_pos);
 
   body_set_velocity(rocket, (vector_t){rocket_horiz_speed_for(state), 0});
   scene_add_body(state->scene, rocket);
 
-  create_collision(state->scene,
-                   state->character,
-                   rocket,
-                   player_obstacle_collision_handler,
-                   state,
-                   0, 
-                   NULL);
+  create_swept_collision(state->scene,
+                         state->character,
+                         rocket,
+                         player_obstacle_collision_handler,
+                         state,
+                         0,
+                         NULL);
 
   asset_make_image_with_body(HEAT_SEEKING_ROCKET_PATHS[0], rocket);
 }
@@ -1048,7 +1230,7 @@ void spawn_powerup(state_t *state) {
                         MAX.y - POWERUP_HEIGHT/2);
   vector_t center = { MAX.x + POWERUP_WIDTH/2, y };
   
-  body_t *pu = make_powerup_body(center); 
+  body_t *pu = make_powerup_body(state, center); 
   double sign = (rand() % 2 == 0) ? +1.0 : -1.0;
   vector_t initial_vel = (vector_t){
     .x = BACKGROUND_VEL.x, 
@@ -1056,14 +1238,9 @@ void spawn_powerup(state_t *state) {
   };
   body_set_velocity(pu, initial_vel);
   scene_add_body(state->scene, pu);
+  collision_group_add(state->target_group, pu);
 
   asset_make_image_with_body(GENERIC_POWERUP, pu);
-  create_collision(state->scene,
-                     state->character,  
-                     pu,            
-                     (collision_handler_t) power_up_collected_handler,
-                     state,
-                     0, NULL);
 
   if (state->sfx_powerup_spawn) {
     Mix_Volume(POWERUP_SFX_CHANNEL, MIX_MAX_VOLUME / 20);
@@ -1079,9 +1256,8 @@ void spawn_coin(state_t *state, vector_t position) {
   body_t *coin = make_coin_body(position);
   body_set_velocity(coin, BACKGROUND_VEL);
   scene_add_body(state->scene, coin);
+  collision_group_add(state->target_group, coin);
   asset_make_image_with_body(COIN_PATHS[state->coin_frame_index], coin);
-  
-  create_collision(state->scene, state->character, coin, coin_collected_handler, state, 0, NULL);
 }
 
 //----------------------------------------------------------------------------//
@@ -1201,7 +1377,11 @@ state_t *emscripten_init() {
   state->quiz_option_text_bodies = list_init(LIST_INIT_CAPACITY, NULL); 
   state->quiz_timer_text_body = NULL;
   
-  state->scene = scene_init();
+  init_game_scene(state);
+  state->timestep = timestep_init(SIMULATION_STEP, MAX_STEPS_PER_FRAME);
+  state->offscreen_query.capacity = REGION_QUERY_INIT_CAPACITY;
+  state->offscreen_query.found = malloc(sizeof(body_t *) * REGION_QUERY_INIT_CAPACITY);
+  assert(state->offscreen_query.found);
   state->character_velocity = (vector_t){0,0};
 
   // Character state variables
@@ -1224,7 +1404,7 @@ state_t *emscripten_init() {
 
   //Alert state variables
   state->alert_shown = false;
-  state->alert_body = NULL;
+  state->alert_handle = BODY_HANDLE_NONE;
 
   // Coin state variables
   state->coin_frame_index = 0;
@@ -1238,6 +1418,9 @@ state_t *emscripten_init() {
   state->time_text_ui_body = NULL;
   state->score_text_ui_body = NULL;
   state->distance_text_ui_body = NULL;
+  state->time_text_asset = NULL;
+  state->score_text_asset = NULL;
+  state->distance_text_asset = NULL;
   state->dist_str_len = 2;
   state->time_str_len = 3;
   state->score_str_len = 4;
@@ -1257,30 +1440,36 @@ state_t *emscripten_init() {
   state->last_character_shielded_running_animation_change = 0;
   
   
+  hold_game_shapes(state);
+
   // Character
-  body_t *character = make_character_body(CHARACTER_WIDTH, CHARACTER_HEIGHT);
+  body_t *character = make_character_body(state);
   body_set_centroid(character, RESET_POS);
   state->character = character;
   scene_add_body(state->scene, character);
+  collision_group_add(state->character_group, character);
 
   // Background and Floor
   vector_t background_center_1 = {MAX.x / 2, MAX.y / 2};
-  body_t *background_1 = make_background_body(state->scene, BACKGROUND_PATH, background_center_1, MAX.x, MAX.y);
+  body_t *background_1 = make_background_body(state, BACKGROUND_PATH, background_center_1, BACKGROUND_SHAPE);
   state->background_body1 = background_1;
 
 
   vector_t background_center_2 = {MAX.x / 2 + MAX.x, MAX.y / 2};
-  body_t *background_2 = make_background_body(state->scene, BACKGROUND_PATH, background_center_2, MAX.x, MAX.y);
+  body_t *background_2 = make_background_body(state, BACKGROUND_PATH, background_center_2, BACKGROUND_SHAPE);
   state->background_body2 = background_2;
   
   vector_t floor_center_1 = {MAX.x / 2, FLOOR_SPRITE_HEIGHT / 2};
-  state->floor_body_1 = make_background_body(state->scene, FLOOR_PATH, floor_center_1, MAX.x, FLOOR_SPRITE_HEIGHT);
+  state->floor_body_1 = make_background_body(state, FLOOR_PATH, floor_center_1, FLOOR_SHAPE);
 
   vector_t floor_center_2 = {MAX.x / 2 + MAX.x, FLOOR_SPRITE_HEIGHT / 2};
-  state->floor_body_2 = make_background_body(state->scene, FLOOR_PATH, floor_center_2, MAX.x, FLOOR_SPRITE_HEIGHT);
+  state->floor_body_2 = make_background_body(state, FLOOR_PATH, floor_center_2, FLOOR_SHAPE);
 
   asset_make_image_with_body(NORMAL_CHARACTER_PATH, character);
 
+  // Restarting puts the level back to this point
+  state->initial_level = scene_snapshot(state->scene);
+
   // Setup Key Handler
   sdl_on_key((key_handler_t)on_key);
 
@@ -1310,536 +1499,453 @@ state_t *emscripten_init() {
 }
 
 
-bool emscripten_main(state_t *state) {
-
-  if (state->current_game_mode == GAME_MODE_GAMEOVER && !state->game_over_shown) {
-    display_game_over(state);   
-    state->game_over_shown = true;
-  }
+/**
+ * @brief Advances the game by one fixed-length simulation step while playing:
+ * ticks the scene, moves the character and runs every timer and spawner.
+ * @param dt The length of the step, in seconds.
+ */
+static void step_game(state_t *state, double dt) {
+  // ***** SCENE UPDATE *****
+  scene_tick(state->scene, dt);
+  contact_queue_drain(state->contacts, handle_contact_event, state);
+  
+  // ***** CHARACTER MOVEMENT *****
+  body_t *character = scene_get_body(state->scene, 0);
+  vector_t old_center   = body_get_centroid(character);
 
-  if (state->current_game_mode == GAME_MODE_GAMEOVER) {
-    // render only
-    sdl_clear();
-    sdl_render_scene(state->scene);
-    for (size_t i = 0; i < list_size(asset_get_asset_list()); i++)
-      asset_render(list_get(asset_get_asset_list(), i));
-    sdl_show();
-    return false;
+  if (state->thrusting) {
+    state->character_velocity.y += DEFAULT_THRUST_ACCEL * dt;
+    
+  } else {
+    state->character_velocity.y += GRAVITY_ACCEL * dt;
   }
 
+  vector_t displacement = vec_multiply(dt, state->character_velocity);
+  vector_t new_center   = vec_add(old_center, displacement);
 
+  //vertical boundaries
+  if (new_center.y <= GROUND_Y) {
+    new_center.y = GROUND_Y;
+    state->character_velocity.y = 0;
+  }
+  if (new_center.y + CHARACTER_HEIGHT / 2.0 > MAX.y) {
+    new_center.y = MAX.y - CHARACTER_HEIGHT / 2.0;
+    state->character_velocity.y = 0;
+  }
 
-  double dt = time_since_last_tick();
-
-  if (state->current_game_mode == GAME_MODE_PLAYING) {
-
-    // ***** SCENE UPDATE *****
-    scene_tick(state->scene, dt);
-    
-    // ***** CHARACTER MOVEMENT *****
-    body_t *character = scene_get_body(state->scene, 0);
-    vector_t old_center   = body_get_centroid(character);
+  //horizontal boundaries
+  double half_w = CHARACTER_WIDTH / 2.0;
+  if (new_center.x < MIN.x + half_w) new_center.x = MIN.x + half_w;
+  if (new_center.x > MAX.x - half_w) new_center.x = MAX.x - half_w;
 
-    if (state->thrusting) {
-      state->character_velocity.y += DEFAULT_THRUST_ACCEL * dt;
-      
+  body_set_centroid(character, new_center);
+  
+  //character sprite change based on thrust or not
+  if (!state->thrusting && state->is_flame && state->character_velocity.y <= 0) {
+    asset_remove_body(character);
+    if (state->shielded) {
+      asset_make_image_with_body(PROTECTIVE_SHIELD, character);
     } else {
-      state->character_velocity.y += GRAVITY_ACCEL * dt;
+      asset_make_image_with_body(NORMAL_CHARACTER_PATH, character);
     }
+    state->is_flame = false;
+  }
 
-    vector_t displacement = vec_multiply(dt, state->character_velocity);
-    vector_t new_center   = vec_add(old_center, displacement);
-
-    //vertical boundaries
-    if (new_center.y <= GROUND_Y) {
-      new_center.y = GROUND_Y;
-      state->character_velocity.y = 0;
-    }
-    if (new_center.y + CHARACTER_HEIGHT / 2.0 > MAX.y) {
-      new_center.y = MAX.y - CHARACTER_HEIGHT / 2.0;
-      state->character_velocity.y = 0;
+  // ***** RUNNING SOUND LOGIC *****
+  bool character_on_ground = (body_get_centroid(state->character).y <= GROUND_Y + 5);
+  if (character_on_ground && !state->is_flame) {
+    if (!state->is_running_sfx) {
+      Mix_Volume(RUNNING_SFX_CHANNEL, MIX_MAX_VOLUME);
+      Mix_PlayChannel(RUNNING_SFX_CHANNEL, state->sfx_running_loop, -1);
+      state->is_running_sfx = true;
     }
+  } else {
+    Mix_HaltChannel(RUNNING_SFX_CHANNEL);
+    state->is_running_sfx = false;
+  }
 
-    //horizontal boundaries
-    double half_w = CHARACTER_WIDTH / 2.0;
-    if (new_center.x < MIN.x + half_w) new_center.x = MIN.x + half_w;
-    if (new_center.x > MAX.x - half_w) new_center.x = MAX.x - half_w;
+  // ***** POWERUP LOGIC *****
+  scene_for_each_tagged(state->scene, POWERUP, bounce_powerup, NULL);
 
-    body_set_centroid(character, new_center);
-    
-    //character sprite change based on thrust or not
-    if (!state->thrusting && state->is_flame && state->character_velocity.y <= 0) {
+  if(state->shielded){
+    state->shield_timer+=dt;
+    if(state->shield_timer>=POWERUP_DURATION){
+      state->shielded=false;
+      state->shield_timer=0.0;
       asset_remove_body(character);
-      if (state->shielded) {
-        asset_make_image_with_body(PROTECTIVE_SHIELD, character);
-      } else {
+      if(state->is_flame){
+        asset_make_image_with_body(FLAME_CHARACTER_PATH, character);
+      }else{
         asset_make_image_with_body(NORMAL_CHARACTER_PATH, character);
       }
-      state->is_flame = false;
     }
-
-    // ***** RUNNING SOUND LOGIC *****
-    bool character_on_ground = (body_get_centroid(state->character).y <= GROUND_Y + 5);
-    if (character_on_ground && !state->is_flame) {
-      if (!state->is_running_sfx) {
-        Mix_Volume(RUNNING_SFX_CHANNEL, MIX_MAX_VOLUME);
-        Mix_PlayChannel(RUNNING_SFX_CHANNEL, state->sfx_running_loop, -1);
-        state->is_running_sfx = true;
-      }
-    } else {
-      Mix_HaltChannel(RUNNING_SFX_CHANNEL);
-      state->is_running_sfx = false;
+  }
+  if (state->speed_boost_active) {
+    state->speed_boost_timer += dt;
+    if (state->speed_boost_timer >= POWERUP_DURATION) {
+      state->speed_boost_active = false;
+      state->speed_boost_timer = 0.0;
+      state->thrust_accel = DEFAULT_THRUST_ACCEL;
     }
-
-    // ***** POWERUP LOGIC *****
-    size_t n_bodies = scene_bodies(state->scene);
-    for (size_t i = 0; i < n_bodies; i++) {
-      body_t *b = scene_get_body(state->scene, i);
-      if (!b) continue;
-
-      body_info_type_t *info = (body_info_type_t *)body_get_info(b);
-      if (info && *info == POWERUP) {
-        vector_t pos = body_get_centroid(b);
-        vector_t vel = body_get_velocity(b);
-
-        double top_limit = MAX.y - POWERUP_HEIGHT/2.0;
-        double bot_limit = MIN.y + FLOOR_SPRITE_HEIGHT + POWERUP_HEIGHT/2.0;
-
-        if (pos.y >= top_limit && vel.y > 0) {
-          vel.y = -vel.y;
-          body_set_velocity(b, vel);
-        }
-        else if (pos.y <= bot_limit && vel.y < 0) {
-          vel.y = -vel.y;
-          body_set_velocity(b, vel);
-        }
-      }
+  }
+  if (state->obstacle_slow_active) {
+    state->obstacle_slow_timer += dt;
+    if (state->obstacle_slow_timer >= POWERUP_DURATION) {
+      BACKGROUND_VEL=CONSTANT_VEL_BACKGROUND;
+      state->obstacle_slow_active = false;
+      state->obstacle_slow_timer = 0.0;
+      body_set_velocity(state->background_body1, BACKGROUND_VEL);
+      body_set_velocity(state->background_body2, BACKGROUND_VEL);
+      body_set_velocity(state->floor_body_1, BACKGROUND_VEL);
+      body_set_velocity(state->floor_body_2, BACKGROUND_VEL);
     }
+  }
+  if (!state->obstacle_slow_active) {
+  state->time_since_last += dt;
+  state->time_since_last_powerup_spawn += dt;
+  }
+ 
 
-    if(state->shielded){
-      state->shield_timer+=dt;
-      if(state->shield_timer>=POWERUP_DURATION){
-        state->shielded=false;
-        state->shield_timer=0.0;
-        asset_remove_body(character);
-        if(state->is_flame){
-          asset_make_image_with_body(FLAME_CHARACTER_PATH, character);
-        }else{
-          asset_make_image_with_body(NORMAL_CHARACTER_PATH, character);
-        }
-      }
-    }
-    if (state->speed_boost_active) {
-      state->speed_boost_timer += dt;
-      if (state->speed_boost_timer >= POWERUP_DURATION) {
-        state->speed_boost_active = false;
-        state->speed_boost_timer = 0.0;
-        state->thrust_accel = DEFAULT_THRUST_ACCEL;
-      }
-    }
-    if (state->obstacle_slow_active) {
-      state->obstacle_slow_timer += dt;
-      if (state->obstacle_slow_timer >= POWERUP_DURATION) {
-        BACKGROUND_VEL=CONSTANT_VEL_BACKGROUND;
-        state->obstacle_slow_active = false;
-        state->obstacle_slow_timer = 0.0;
-        body_set_velocity(state->background_body1, BACKGROUND_VEL);
-        body_set_velocity(state->background_body2, BACKGROUND_VEL);
-        body_set_velocity(state->floor_body_1, BACKGROUND_VEL);
-        body_set_velocity(state->floor_body_2, BACKGROUND_VEL);
-      }
-    }
-    if (!state->obstacle_slow_active) {
-    state->time_since_last += dt;
-    state->time_since_last_powerup_spawn += dt;
-    }
-   
 
+  // ***** ANIMATIONS *****
+  list_t *all_assets = asset_get_asset_list();
 
-    // ***** ANIMATIONS *****
-    list_t *all_assets = asset_get_asset_list();
+  state->last_coin_animation_change += dt;
+  state->last_laser_animation_change += dt;
+  state->last_hs_rocket_animation_change += dt;
+  state->last_character_running_animation_change += dt;
 
-    state->last_coin_animation_change += dt;
-    state->last_laser_animation_change += dt;
-    state->last_hs_rocket_animation_change += dt;
-    state->last_character_running_animation_change += dt;
+  // laser will only spawn when there is no powerup on the screen to prevent impossible powerups
+  bool is_powerup = scene_count_tagged(state->scene, POWERUP) > 0;
+  bool update_coin_anim = (state->last_coin_animation_change >= COIN_ANIMATION_INTERVAL);
+  bool update_laser_anim = (state->last_laser_animation_change >= LASER_ANIMATION_INTERVAL);
+  bool update_hs_rocket_anim = (state->last_hs_rocket_animation_change >= HEAT_SEEKING_ROCKET_ANIMATION_INTERVAL);
+  bool update_character_anim = (state->last_character_running_animation_change >= CHARACTER_RUNNING_ANIMATION_INTERVAL);
+  
+  SDL_Texture *next_coin_texture;
+  if (update_coin_anim) {
+    state->last_coin_animation_change -= COIN_ANIMATION_INTERVAL;
+    state->coin_frame_index = (state->coin_frame_index+1) % NUM_COIN_ANIM_FRAMES;
+    const char *next_coin_path = COIN_PATHS[state->coin_frame_index];
+    next_coin_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_coin_path);
+  }
 
-    bool is_powerup = false; // laser will only spawn when there is no powerup asset on the screen to prevent impossible powerups
-    bool update_coin_anim = (state->last_coin_animation_change >= COIN_ANIMATION_INTERVAL);
-    bool update_laser_anim = (state->last_laser_animation_change >= LASER_ANIMATION_INTERVAL);
-    bool update_hs_rocket_anim = (state->last_hs_rocket_animation_change >= HEAT_SEEKING_ROCKET_ANIMATION_INTERVAL);
-    bool update_character_anim = (state->last_character_running_animation_change >= CHARACTER_RUNNING_ANIMATION_INTERVAL);
-    
-    SDL_Texture *next_coin_texture;
-    if (update_coin_anim) {
-      state->last_coin_animation_change -= COIN_ANIMATION_INTERVAL;
-      state->coin_frame_index = (state->coin_frame_index+1) % NUM_COIN_ANIM_FRAMES;
-      const char *next_coin_path = COIN_PATHS[state->coin_frame_index];
-      next_coin_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_coin_path);
-    }
+  SDL_Texture *next_vl_texture;
+  SDL_Texture *next_hl_texture;
+  if (update_laser_anim) {
+    state->last_laser_animation_change -= LASER_ANIMATION_INTERVAL;
+    state->laser_frame_index = (state->laser_frame_index + 1) % NUM_LASER_ANIM_FRAMES;
+    const char *next_vertical_laser_anim_path = LASER_VERTICAL_PATHS[state->laser_frame_index];
+    const char *next_horizontal_laser_anim_path = LASER_HORIZONTAL_PATHS[state->laser_frame_index];
+    next_vl_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_vertical_laser_anim_path);
+    next_hl_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_horizontal_laser_anim_path);
+  }
 
-    SDL_Texture *next_vl_texture;
-    SDL_Texture *next_hl_texture;
-    if (update_laser_anim) {
-      state->last_laser_animation_change -= LASER_ANIMATION_INTERVAL;
-      state->laser_frame_index = (state->laser_frame_index + 1) % NUM_LASER_ANIM_FRAMES;
-      const char *next_vertical_laser_anim_path = LASER_VERTICAL_PATHS[state->laser_frame_index];
-      const char *next_horizontal_laser_anim_path = LASER_HORIZONTAL_PATHS[state->laser_frame_index];
-      next_vl_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_vertical_laser_anim_path);
-      next_hl_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_horizontal_laser_anim_path);
-    }
+  SDL_Texture *next_hs_rocket_texture;
+  if (update_hs_rocket_anim) {
+    state->last_hs_rocket_animation_change -= HEAT_SEEKING_ROCKET_ANIMATION_INTERVAL;
+    state->hs_rocket_frame_index = (state->hs_rocket_frame_index + 1) % NUM_HEAT_SEEKING_ROCKET_ANIM_FRAMES;
+    const char *next_hs_rocket_path = HEAT_SEEKING_ROCKET_PATHS[state->hs_rocket_frame_index];
+    next_hs_rocket_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_hs_rocket_path);
+  }
 
-    SDL_Texture *next_hs_rocket_texture;
-    if (update_hs_rocket_anim) {
-      state->last_hs_rocket_animation_change -= HEAT_SEEKING_ROCKET_ANIMATION_INTERVAL;
-      state->hs_rocket_frame_index = (state->hs_rocket_frame_index + 1) % NUM_HEAT_SEEKING_ROCKET_ANIM_FRAMES;
-      const char *next_hs_rocket_path = HEAT_SEEKING_ROCKET_PATHS[state->hs_rocket_frame_index];
-      next_hs_rocket_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_hs_rocket_path);
-    }
+  SDL_Texture *next_character_running_texture;
+  SDL_Texture *next_character_shielded_running_texture;
+  if (update_character_anim) {
+    state->last_character_running_animation_change -= CHARACTER_RUNNING_ANIMATION_INTERVAL;
+    state->character_running_frame_index = (state->character_running_frame_index + 1) % NUM_CHARACTER_RUNNING_ANIM_FRAMES;
+    const char *next_character_running_path = CHARACTER_RUNNING_PATHS[state->character_running_frame_index];
+    next_character_running_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_character_running_path);
+
+    state->last_character_shielded_running_animation_change -= CHARACTER_RUNNING_ANIMATION_INTERVAL;
+    state->character_shielded_running_frame_index = 
+        (state->character_shielded_running_frame_index + 1) % NUM_CHARACTER_SHIELDED_RUNNING_ANIM_FRAMES;
+    const char *next_path = CHARACTER_SHIELDED_RUNNING_PATHS[state->character_shielded_running_frame_index];
+    next_character_shielded_running_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_path);
+  }
 
-    SDL_Texture *next_character_running_texture;
-    SDL_Texture *next_character_shielded_running_texture;
-    if (update_character_anim) {
-      state->last_character_running_animation_change -= CHARACTER_RUNNING_ANIMATION_INTERVAL;
-      state->character_running_frame_index = (state->character_running_frame_index + 1) % NUM_CHARACTER_RUNNING_ANIM_FRAMES;
-      const char *next_character_running_path = CHARACTER_RUNNING_PATHS[state->character_running_frame_index];
-      next_character_running_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_character_running_path);
-
-      state->last_character_shielded_running_animation_change -= CHARACTER_RUNNING_ANIMATION_INTERVAL;
-      state->character_shielded_running_frame_index = 
-          (state->character_shielded_running_frame_index + 1) % NUM_CHARACTER_SHIELDED_RUNNING_ANIM_FRAMES;
-      const char *next_path = CHARACTER_SHIELDED_RUNNING_PATHS[state->character_shielded_running_frame_index];
-      next_character_shielded_running_texture = asset_cache_obj_get_or_create(ASSET_IMAGE, next_path);
-    }
+  scene_for_each_tagged(state->scene, SHURIKEN, spin_shuriken, &dt);
 
-    for (size_t i = 0; i < scene_bodies(state->scene); i++) {
-      body_t *b = scene_get_body(state->scene, i);
-      body_info_type_t *info = body_get_info(b);
-      if (info && *info == SHURIKEN) {
-        double old_angle = body_get_rotation(b);
-        body_set_rotation(b, old_angle + SHURIKEN_ROT_SPEED * dt);
-      }
-    }
+  if (update_coin_anim || update_laser_anim || update_hs_rocket_anim || update_character_anim) {
+    for (size_t i=0; i<list_size(all_assets); i++) {
+      asset_t *curr = (asset_t *)list_get(all_assets, i);
+      if (curr->type == ASSET_IMAGE) {
 
-    if (update_coin_anim || update_laser_anim || update_hs_rocket_anim || update_character_anim) {
-      for (size_t i=0; i<list_size(all_assets); i++) {
-        asset_t *curr = (asset_t *)list_get(all_assets, i);
-        if (curr->type == ASSET_IMAGE) {
-  
-          image_asset_t *img_curr = (image_asset_t *)curr;
-          if (img_curr->body == NULL) continue;
+        image_asset_t *img_curr = (image_asset_t *)curr;
+        if (img_curr->body == NULL) continue;
 
-          body_info_type_t *body_info = (body_info_type_t *) body_get_info(img_curr->body);
+        body_info_type_t *body_info = (body_info_type_t *) body_get_info(img_curr->body);
 
-          if (update_laser_anim) {
-            if (body_info && *body_info == VERTICAL_LASER) {
-              img_curr->texture = next_vl_texture;
-            } else if (body_info && *body_info == HORIZONTAL_LASER) {
-              img_curr->texture = next_hl_texture;
-            }
-            if (body_info && *body_info == POWERUP) {
-              is_powerup = true;
-            }
+        if (update_laser_anim) {
+          if (body_info && *body_info == VERTICAL_LASER) {
+            img_curr->texture = next_vl_texture;
+          } else if (body_info && *body_info == HORIZONTAL_LASER) {
+            img_curr->texture = next_hl_texture;
           }
-          if (update_coin_anim) {
-            if (body_info && *body_info == COIN) {
-              img_curr->texture = next_coin_texture;
-            }
+        }
+        if (update_coin_anim) {
+          if (body_info && *body_info == COIN) {
+            img_curr->texture = next_coin_texture;
           }
-          if (update_hs_rocket_anim) {
-            if (body_info && *body_info == HEAT_SEEK_ROCKET) {
-              img_curr->texture = next_hs_rocket_texture;
-            }
+        }
+        if (update_hs_rocket_anim) {
+          if (body_info && *body_info == HEAT_SEEK_ROCKET) {
+            img_curr->texture = next_hs_rocket_texture;
           }
-          if (update_character_anim) {
-            if (body_info && *body_info == CHARACTER) {
-              if (state->is_running_sfx) {
-                img_curr->texture = state->shielded ? next_character_shielded_running_texture : next_character_running_texture;
-              }
+        }
+        if (update_character_anim) {
+          if (body_info && *body_info == CHARACTER) {
+            if (state->is_running_sfx) {
+              img_curr->texture = state->shielded ? next_character_shielded_running_texture : next_character_running_texture;
             }
           }
         }
       }
     }
+  }
 
-    // ***** LASER SPAWNING *****
-    state->last_laser_spawn_time += dt;
-    if (!is_powerup && state->last_laser_spawn_time >= LASER_SPAWN_INTERVAL + rand_double(0.0, 3.0)) { //some randomness in spawning intervals
-      size_t rand_orientation = rand() % 2;
-      if (rand_orientation == 0) { //prevent coin collisions
-        //spawn vertical laser with bounded ypos
-        double y_min = MIN.y + FLOOR_SPRITE_HEIGHT + VERTICAL_LASER_HEIGHT / 2.0;
-        double y_max = MAX.y - VERTICAL_LASER_HEIGHT/2.0;
-        double y_pos = rand_double(y_min, y_max);
-        spawn_vertical_laser(state, y_pos);
-      } else {
-        //spawn horizontal laser with bounded ypos
-        double y_min = MIN.y + FLOOR_SPRITE_HEIGHT + HORIZONTAL_LASER_HEIGHT / 2.0;
-        double y_max = MAX.y - HORIZONTAL_LASER_HEIGHT/2.0;
-        double y_pos = rand_double(y_min, y_max);
-        spawn_horizontal_laser(state, y_pos);
-      }
-      state->last_laser_spawn_time = 0.0;
-      //play laser music if not already playing
-      if (!Mix_Playing(LASER_SFX_CHANNEL)) {
-        Mix_PlayChannel(LASER_SFX_CHANNEL, state->sfx_laser_loop, -1);
-      }
+  // ***** LASER SPAWNING *****
+  state->last_laser_spawn_time += dt;
+  if (!is_powerup && state->last_laser_spawn_time >= LASER_SPAWN_INTERVAL + rand_double(0.0, 3.0)) { //some randomness in spawning intervals
+    size_t rand_orientation = rand() % 2;
+    if (rand_orientation == 0) { //prevent coin collisions
+      //spawn vertical laser with bounded ypos
+      double y_min = MIN.y + FLOOR_SPRITE_HEIGHT + VERTICAL_LASER_HEIGHT / 2.0;
+      double y_max = MAX.y - VERTICAL_LASER_HEIGHT/2.0;
+      double y_pos = rand_double(y_min, y_max);
+      spawn_vertical_laser(state, y_pos);
+    } else {
+      //spawn horizontal laser with bounded ypos
+      double y_min = MIN.y + FLOOR_SPRITE_HEIGHT + HORIZONTAL_LASER_HEIGHT / 2.0;
+      double y_max = MAX.y - HORIZONTAL_LASER_HEIGHT/2.0;
+      double y_pos = rand_double(y_min, y_max);
+      spawn_horizontal_laser(state, y_pos);
     }
+    state->last_laser_spawn_time = 0.0;
+    //play laser music if not already playing
+    if (!Mix_Playing(LASER_SFX_CHANNEL)) {
+      Mix_PlayChannel(LASER_SFX_CHANNEL, state->sfx_laser_loop, -1);
+    }
+  }
 
-    // ***** COIN SPAWNING *****
-    state->last_coin_spawn_time += dt;
-    if (state->last_coin_spawn_time >= COIN_SPAWN_INTERVAL + rand_double(0.0, 1.5)) {
-      size_t rand_pattern = rand();
-      size_t rand_num_coins = (rand() % (COIN_NUM_MAX - COIN_NUM_MIN + 1)) + COIN_NUM_MIN;
+  // ***** COIN SPAWNING *****
+  state->last_coin_spawn_time += dt;
+  if (state->last_coin_spawn_time >= COIN_SPAWN_INTERVAL + rand_double(0.0, 1.5)) {
+    size_t rand_pattern = rand();
+    size_t rand_num_coins = (rand() % (COIN_NUM_MAX - COIN_NUM_MIN + 1)) + COIN_NUM_MIN;
 
-      if (rand_pattern % 3 == 0) {
-        //LINEAR
-        double centerline_y = rand_double(MIN.y + FLOOR_SPRITE_HEIGHT + COIN_RADIUS * 2, MAX.y - COIN_RADIUS * 2);
-        double curr_x = MAX.x + COIN_RADIUS;
+    if (rand_pattern % 3 == 0) {
+      //LINEAR
+      double centerline_y = rand_double(MIN.y + FLOOR_SPRITE_HEIGHT + COIN_RADIUS * 2, MAX.y - COIN_RADIUS * 2);
+      double curr_x = MAX.x + COIN_RADIUS;
 
-        for (size_t i=0; i<rand_num_coins; i++) {
-          spawn_coin(state, (vector_t){.x = curr_x, .y = centerline_y});
-          curr_x += 3 * COIN_RADIUS;
-        }
-      } else if (rand_pattern % 3 == 1) {
-        // RECTANGLE
-        size_t num_rows_rect = (rand() % 2) + 2;
-        size_t num_cols_rect = (rand() % 3) + 2;
-        
-        double spacing_rect = COIN_RADIUS * 3;
-        double pattern_height = num_rows_rect * spacing_rect;
+      for (size_t i=0; i<rand_num_coins; i++) {
+        spawn_coin(state, (vector_t){.x = curr_x, .y = centerline_y});
+        curr_x += 3 * COIN_RADIUS;
+      }
+    } else if (rand_pattern % 3 == 1) {
+      // RECTANGLE
+      size_t num_rows_rect = (rand() % 2) + 2;
+      size_t num_cols_rect = (rand() % 3) + 2;
+      
+      double spacing_rect = COIN_RADIUS * 3;
+      double pattern_height = num_rows_rect * spacing_rect;
 
-        double min_start_y_rect = MIN.y + FLOOR_SPRITE_HEIGHT + COIN_RADIUS;
-        double max_start_y_rect = MAX.y - COIN_RADIUS - pattern_height;
+      double min_start_y_rect = MIN.y + FLOOR_SPRITE_HEIGHT + COIN_RADIUS;
+      double max_start_y_rect = MAX.y - COIN_RADIUS - pattern_height;
 
-        double y_start = rand_double(min_start_y_rect, max_start_y_rect);
-        double x_start = MAX.x + COIN_RADIUS * 2;
+      double y_start = rand_double(min_start_y_rect, max_start_y_rect);
+      double x_start = MAX.x + COIN_RADIUS * 2;
 
-        for (size_t r = 0; r < num_rows_rect; r++) {
-          for (size_t c = 0; c < num_cols_rect; c++) {
-            double c_x = x_start + c * spacing_rect;
-            double c_y = y_start + r * spacing_rect;
+      for (size_t r = 0; r < num_rows_rect; r++) {
+        for (size_t c = 0; c < num_cols_rect; c++) {
+          double c_x = x_start + c * spacing_rect;
+          double c_y = y_start + r * spacing_rect;
 
-            spawn_coin(state, (vector_t){.x = c_x, .y = c_y});
-          }
+          spawn_coin(state, (vector_t){.x = c_x, .y = c_y});
         }
+      }
+    } else {
+      // ZIG ZAG
+      size_t num_coins = (rand() % 5) + 6;
+      double amplitude = rand_double(COIN_RADIUS * COIN_SCALE_1, COIN_RADIUS * COIN_SCALE_2);
+      
+      double min_center_y = MIN.y + FLOOR_SPRITE_HEIGHT + COIN_RADIUS * amplitude;
+      double max_center_y = MAX.y - COIN_RADIUS * amplitude;
+
+      double centerline_y;
+      if (min_center_y >= max_center_y) {
+        centerline_y = (MIN.y + MAX.y) / 2.0;
       } else {
-        // ZIG ZAG
-        size_t num_coins = (rand() % 5) + 6;
-        double amplitude = rand_double(COIN_RADIUS * COIN_SCALE_1, COIN_RADIUS * COIN_SCALE_2);
-        
-        double min_center_y = MIN.y + FLOOR_SPRITE_HEIGHT + COIN_RADIUS * amplitude;
-        double max_center_y = MAX.y - COIN_RADIUS * amplitude;
+        centerline_y = rand_double(min_center_y, max_center_y);
+      }
 
-        double centerline_y;
-        if (min_center_y >= max_center_y) {
-          centerline_y = (MIN.y + MAX.y) / 2.0;
+      double x_start = MAX.x + COIN_RADIUS * 2;
+      double x_spacing = COIN_RADIUS * COIN_SCALE_3;
+
+      for (size_t i=0; i<num_coins; i++) {
+        double curr_x = x_start + i * x_spacing;
+        double coin_y;
+        if (i % 2 == 0) {
+          coin_y = centerline_y + amplitude;
         } else {
-          centerline_y = rand_double(min_center_y, max_center_y);
+          coin_y = centerline_y - amplitude;
         }
+        spawn_coin(state, (vector_t){.x = curr_x, .y = coin_y});
+      }
+    }
 
-        double x_start = MAX.x + COIN_RADIUS * 2;
-        double x_spacing = COIN_RADIUS * COIN_SCALE_3;
+    state->last_coin_spawn_time = 0.0;
+  }
 
-        for (size_t i=0; i<num_coins; i++) {
-          double curr_x = x_start + i * x_spacing;
-          double coin_y;
-          if (i % 2 == 0) {
-            coin_y = centerline_y + amplitude;
-          } else {
-            coin_y = centerline_y - amplitude;
-          }
-          spawn_coin(state, (vector_t){.x = curr_x, .y = coin_y});
-        }
-      }
+  // ***** ALERT, POWERUP AND OBSTACLE SPAWNING *****
+  body_t *alert_body = scene_resolve(state->scene, state->alert_handle);
+  if (alert_body != NULL) {
+    vector_t character_pos = body_get_centroid(character);
+    vector_t alert_current_pos = body_get_centroid(alert_body);
+    body_set_centroid(alert_body, (vector_t){alert_current_pos.x, character_pos.y});
+  }
 
-      state->last_coin_spawn_time = 0.0;
-    }
+  if (!state->alert_shown && state->time_since_last >= ALERT_TRIGGER_OFFSET) {
+    double h = OBSTACLE_HEIGHT;
+    state->next_bug_y = rand_double(MIN.y + FLOOR_SPRITE_HEIGHT + h/2.0, MAX.y - h/2.0);
+    spawn_alert(state);
+    state->alert_shown = true;
+  }
 
-    // ***** ALERT, POWERUP AND OBSTACLE SPAWNING *****
-    if (state->alert_body != NULL) {
-      vector_t character_pos = body_get_centroid(character);
-      vector_t alert_current_pos = body_get_centroid(state->alert_body);
-      body_set_centroid(state->alert_body, (vector_t){alert_current_pos.x, character_pos.y});
+  if (state->time_since_last >= OBSTACLE_SPAWN_INTERVAL) {
+    alert_body = scene_resolve(state->scene, state->alert_handle);
+    if (alert_body) {
+      state->next_bug_y = body_get_centroid(alert_body).y;
+      scene_remove_handle(state->scene, state->alert_handle);
+      state->alert_handle = BODY_HANDLE_NONE;
+    } 
+    if (rand() % 2 == 0) {
+      spawn_heat_seeking_rocket(state);
+    } else {
+      spawn_obstacle(state);
     }
 
-    if (!state->alert_shown && state->time_since_last >= ALERT_TRIGGER_OFFSET) {
-      double h = OBSTACLE_HEIGHT;
-      state->next_bug_y = rand_double(MIN.y + FLOOR_SPRITE_HEIGHT + h/2.0, MAX.y - h/2.0);
-      spawn_alert(state);
-      state->alert_shown = true;
-    }
+    state->time_since_last = 0.0;
+    state->alert_shown = false;
+  }
 
-    if (state->time_since_last >= OBSTACLE_SPAWN_INTERVAL) {
-      if (state->alert_body) {
-        state->next_bug_y = body_get_centroid(state->alert_body).y;
-        scene_remove_body_by_ptr(state->scene, state->alert_body);
-        state->alert_body = NULL;
-      } 
-      if (rand() % 2 == 0) {
-        spawn_heat_seeking_rocket(state);
-      } else {
-        spawn_obstacle(state);
-      }
 
-      state->time_since_last = 0.0;
-      state->alert_shown = false;
-    }
+  state->time_since_last_shuriken += dt;
+  if (state->time_since_last_shuriken >= SHURIKEN_SPAWN_INTERVAL) {
+    spawn_shuriken(state);
+    state->time_since_last_shuriken = 0.0;
+  }
 
+  if (!state->speed_boost_active &&state->time_since_last_powerup_spawn >= POWERUP_SPAWN_INTERVAL) {
+    spawn_powerup(state);
+    state->time_since_last_powerup_spawn = 0.0;
+  }
 
-    state->time_since_last_shuriken += dt;
-    if (state->time_since_last_shuriken >= SHURIKEN_SPAWN_INTERVAL) {
-      spawn_shuriken(state);
-      state->time_since_last_shuriken = 0.0;
-    }
+  // ***** BACKGROUND AND FLOOR SCROLLING AND WRAP *****
+  vector_t background_center_1 = body_get_centroid(state->background_body1);
+  vector_t background_center_2 = body_get_centroid(state->background_body2);
+  vector_t floor_center_1 = body_get_centroid(state->floor_body_1);
+  vector_t floor_center_2 = body_get_centroid(state->floor_body_2);
 
-    if (!state->speed_boost_active &&state->time_since_last_powerup_spawn >= POWERUP_SPAWN_INTERVAL) {
-      spawn_powerup(state);
-      state->time_since_last_powerup_spawn = 0.0;
-    }
+  // Wrapping jumps a whole screen, so it is drawn without interpolation
+  if (background_center_1.x + MAX.x / 2 < MIN.x) {
+    body_set_centroid(state->background_body1, (vector_t) {background_center_2.x + MAX.x, background_center_1.y});
+    body_reset_interpolation(state->background_body1);
+  }
+  if (background_center_2.x + MAX.x / 2 < MIN.x) {
+    body_set_centroid(state->background_body2, (vector_t) {background_center_1.x + MAX.x , background_center_2.y});
+    body_reset_interpolation(state->background_body2);
+  }
+  if (floor_center_1.x + MAX.x / 2.0 < MIN.x) { 
+      body_set_centroid(state->floor_body_1, (vector_t) {floor_center_2.x + MAX.x, floor_center_1.y});
+      body_reset_interpolation(state->floor_body_1);
+  }
+  if (floor_center_2.x + MAX.x / 2.0 < MIN.x) {
+      body_set_centroid(state->floor_body_2, (vector_t) {floor_center_1.x + MAX.x , floor_center_2.y});
+      body_reset_interpolation(state->floor_body_2);
+  }
 
-    // ***** BACKGROUND AND FLOOR SCROLLING AND WRAP *****
-    vector_t background_center_1 = body_get_centroid(state->background_body1);
-    vector_t background_center_2 = body_get_centroid(state->background_body2);
-    vector_t floor_center_1 = body_get_centroid(state->floor_body_1);
-    vector_t floor_center_2 = body_get_centroid(state->floor_body_2);
+  // ***** UPDATE UI ELEMENTS *****
+  state->distance_traveled_meters += dt * METERS_PER_SECOND_TRAVEL_SPEED;
+  state->total_game_time_seconds += dt;
+
+  char time_str[TIMER_SIZE];
+  snprintf(time_str, sizeof(time_str), "%.1lfs", state->total_game_time_seconds);
+  update_ui_text(state, &state->time_text_ui_body, &state->time_text_asset, &state->time_str_len, time_str, TIME_FONT_SIZE, TIME_TEXT_POS);
+
+  char dist_str[TIMER_SIZE];
+  snprintf(dist_str, sizeof(dist_str), "%.0fm", state->distance_traveled_meters);
+  update_ui_text(state, &state->distance_text_ui_body, &state->distance_text_asset, &state->dist_str_len, dist_str, DIST_FONT_SIZE, DISTANCE_TEXT_POS);
+
+  char score_str[TIMER_SIZE];
+  snprintf(score_str, sizeof(score_str), "%04zu", state->score);
+  update_ui_text(state, &state->score_text_ui_body, &state->score_text_asset, &state->score_str_len, score_str, SCORE_FONT_SIZE, SCORE_TEXT_POS);
+
+  // ***** HEAT SEEKING ROCKET TRACKING *****
+  rocket_steering_t steering = {.state = state, .target = body_get_centroid(state->character), .dt = dt};
+  scene_for_each_tagged(state->scene, HEAT_SEEK_ROCKET, steer_rocket, &steering);
+
+  // ***** CLEANUP OFF SCREEN OBJECTS *****
+  // Anything left of the threshold is past the screen. Each step removes what has just
+  // crossed it, so only a strip next to the threshold needs to be searched.
+  double screen_height = MAX.y - MIN.y;
+  aabb_t offscreen = {.min = {OFFSCREEN_X_REMOVAL_THRESHOLD - OFFSCREEN_STRIP_WIDTH, MIN.y - screen_height},
+                      .max = {OFFSCREEN_X_REMOVAL_THRESHOLD, MAX.y + screen_height}};
+  bool laser_on_screen = scene_count_tagged(state->scene, VERTICAL_LASER) > 0 ||
+                         scene_count_tagged(state->scene, HORIZONTAL_LASER) > 0; //for stopping laser sfx
+  size_t num_offscreen = query_region(state->scene, offscreen, &state->offscreen_query);
+  for (size_t i = 0; i < num_offscreen; i++) {
+    body_t *curr_body = state->offscreen_query.found[i];
+    if (curr_body == state->character ||
+        curr_body == state->background_body1 ||
+        curr_body == state->background_body2 ||
+        curr_body == scene_resolve(state->scene, state->alert_handle)) {
+          continue;
+        }
 
-    if (background_center_1.x + MAX.x / 2 < MIN.x) {
-      body_set_centroid(state->background_body1, (vector_t) {background_center_2.x + MAX.x, background_center_1.y});
-    }
-    if (background_center_2.x + MAX.x / 2 < MIN.x) {
-      body_set_centroid(state->background_body2, (vector_t) {background_center_1.x + MAX.x , background_center_2.y});
-    }
-    if (floor_center_1.x + MAX.x / 2.0 < MIN.x) { 
-        body_set_centroid(state->floor_body_1, (vector_t) {floor_center_2.x + MAX.x, floor_center_1.y});
-    }
-    if (floor_center_2.x + MAX.x / 2.0 < MIN.x) {
-        body_set_centroid(state->floor_body_2, (vector_t) {floor_center_1.x + MAX.x , floor_center_2.y});
+    body_info_type_t *info = (body_info_type_t *)body_get_info(curr_body);
+    if (info && (*info == COIN || *info == OBSTACLE || *info == POWERUP || *info == HEAT_SEEK_ROCKET 
+        || *info == HORIZONTAL_LASER || *info == VERTICAL_LASER || *info == SHURIKEN)) {
+      vector_t center = body_get_centroid(curr_body);
+      if (center.x < OFFSCREEN_X_REMOVAL_THRESHOLD) {
+        body_remove(curr_body);
+      }
     }
+  }
 
-    // ***** UPDATE UI ELEMENTS *****
-    state->distance_traveled_meters += dt * METERS_PER_SECOND_TRAVEL_SPEED;
-    state->total_game_time_seconds += dt;
-  
-    remove_all_text_assets_for_body(state->time_text_ui_body);
-    remove_all_text_assets_for_body(state->distance_text_ui_body);
-    remove_all_text_assets_for_body(state->score_text_ui_body);
-  
+  if (!laser_on_screen && Mix_Playing(LASER_SFX_CHANNEL)) {
+    Mix_HaltChannel(LASER_SFX_CHANNEL);
+  }
+}
 
-    char time_str[TIMER_SIZE];
-    snprintf(time_str, sizeof(time_str), "%.1lfs", state->total_game_time_seconds);
-    size_t new_time_len = strlen(time_str);
-    if (new_time_len > state->time_str_len) {
-      remove_all_text_assets_for_body(state->time_text_ui_body);
-      scene_remove_body_by_ptr(state->scene, state->time_text_ui_body);
-      list_t *time_pts = rect_for_text(FONT_PATH, TIME_FONT_SIZE, time_str);
-      body_info_type_t *info_time = malloc(sizeof(body_info_type_t)); *info_time = UI;
-      state->time_text_ui_body = body_init_with_info(time_pts, UNIT_WEIGHT, PLACEHOLDER_COLOR, info_time, free);
-      body_set_centroid(state->time_text_ui_body, TIME_TEXT_POS);
-      scene_add_body(state->scene, state->time_text_ui_body);
-      state->time_str_len = new_time_len;
-    }
-    asset_make_text_with_body(FONT_PATH, state->time_text_ui_body, strdup(time_str), UI_TEXT_COLOR);
-
-    char dist_str[TIMER_SIZE];
-    snprintf(dist_str, sizeof(dist_str), "%.0fm", state->distance_traveled_meters);
-    size_t new_dist_len = strlen(dist_str);
-    if (new_dist_len > state->dist_str_len) {
-      remove_all_text_assets_for_body(state->distance_text_ui_body);
-      scene_remove_body_by_ptr(state->scene, state->distance_text_ui_body);
-      list_t *dist_pts = rect_for_text(FONT_PATH, DIST_FONT_SIZE, dist_str);
-      body_info_type_t *info_dist = malloc(sizeof(body_info_type_t)); *info_dist = UI;
-      state->distance_text_ui_body = body_init_with_info(dist_pts, UNIT_WEIGHT, PLACEHOLDER_COLOR, info_dist, free);
-      body_set_centroid(state->distance_text_ui_body, DISTANCE_TEXT_POS);
-      scene_add_body(state->scene, state->distance_text_ui_body);
-      state->dist_str_len = new_dist_len;
-    }
-    asset_make_text_with_body(FONT_PATH, state->distance_text_ui_body, strdup(dist_str), UI_TEXT_COLOR);
-
-    char score_str[TIMER_SIZE];
-    snprintf(score_str, sizeof(score_str), "%04zu", state->score);
-    size_t new_score_len = strlen(score_str);
-    if (new_score_len > state->score_str_len) {
-      remove_all_text_assets_for_body(state->score_text_ui_body);
-      scene_remove_body_by_ptr(state->scene, state->score_text_ui_body);    
-      list_t *score_pts = rect_for_text(FONT_PATH, SCORE_FONT_SIZE, score_str);
-      body_info_type_t *info_score = malloc(sizeof(body_info_type_t)); *info_score = UI;
-      state->score_text_ui_body = body_init_with_info(score_pts, UNIT_WEIGHT, PLACEHOLDER_COLOR, info_score, free);
-      body_set_centroid(state->score_text_ui_body, SCORE_TEXT_POS);
-      scene_add_body(state->scene, state->score_text_ui_body);
-      state->score_str_len = new_score_len;
-    }
-    asset_make_text_with_body(FONT_PATH, state->score_text_ui_body, strdup(score_str), UI_TEXT_COLOR);
-
-    // ***** HEAT SEEKING ROCKET TRACKING *****
-    vector_t player_center_pos = body_get_centroid(state->character);
-    for (size_t i=0; i<scene_bodies(state->scene); i++) {
-      body_t *curr_body = scene_get_body(state->scene, i);
-      if (curr_body) {
-        body_info_type_t *info = (body_info_type_t *)body_get_info(curr_body);
-        if (info && *info == HEAT_SEEK_ROCKET) {
-          vector_t rocket_pos = body_get_centroid(curr_body);
-          vector_t current_rocket_vel = body_get_velocity(curr_body);
-          double new_vy = current_rocket_vel.y;
-          if (rocket_pos.x > player_center_pos.x) { 
-            double dy_to_player = player_center_pos.y - rocket_pos.y;
-
-            // Adjust vertical velocity towards the player
-            if (dy_to_player > 0) {
-                new_vy += ROCKET_VERTICAL_ADJUST_RATE * dt;
-            } else if (dy_to_player < 0) {
-                new_vy -= ROCKET_VERTICAL_ADJUST_RATE * dt;
-            }
+bool emscripten_main(state_t *state) {
 
-            // Clamp vertical speed
-            if (new_vy > ROCKET_MAX_VERTICAL_SPEED) {
-                new_vy = ROCKET_MAX_VERTICAL_SPEED;
-            } else if (new_vy < -ROCKET_MAX_VERTICAL_SPEED) {
-                new_vy = -ROCKET_MAX_VERTICAL_SPEED;
-            }
-          }
+  if (state->current_game_mode == GAME_MODE_GAMEOVER && !state->game_over_shown) {
+    display_game_over(state);   
+    state->game_over_shown = true;
+  }
 
-          body_set_velocity(curr_body, (vector_t){rocket_horiz_speed_for(state), new_vy});
-        }
-      }
-    }
+  if (state->current_game_mode == GAME_MODE_GAMEOVER) {
+    // render only
+    sdl_clear();
+    sdl_render_scene(state->scene);
+    for (size_t i = 0; i < list_size(asset_get_asset_list()); i++)
+      asset_render(list_get(asset_get_asset_list(), i));
+    sdl_show();
+    return false;
+  }
 
-    // ***** CLEANUP OFF SCREEN OBJECTS *****
-    bool laser_on_screen = false; //for stopping laser sfx
-    size_t num_bodies = scene_bodies(state->scene);
-    if (num_bodies > 0) {
-      for (size_t i = num_bodies; i-- > 0; ) { // PREVENT UNDERFLOW
-        
-        body_t *curr_body = scene_get_body(state->scene, i);
-
-        if (!curr_body) continue;
-        if (curr_body == state->character ||
-            curr_body == state->background_body1 ||
-            curr_body == state->background_body2 ||
-            curr_body == state->alert_body) {
-              continue;
-            }
-        
-        body_info_type_t *info = (body_info_type_t *)body_get_info(curr_body);
-        //stop vertical and horizontal laser sounds
-        if (info && (*info == VERTICAL_LASER || *info == HORIZONTAL_LASER)) {
-          laser_on_screen = true;
-        }
 
-        if (info && (*info == COIN || *info == OBSTACLE || *info == POWERUP || *info == HEAT_SEEK_ROCKET 
-            || *info == HORIZONTAL_LASER || *info == VERTICAL_LASER || *info == SHURIKEN)) {
-          vector_t center = body_get_centroid(curr_body);
-          if (center.x < OFFSCREEN_X_REMOVAL_THRESHOLD) {
-            remove_body_and_asset(state->scene, curr_body);
-          }
-        }
-      }
-    }
 
-    if (!laser_on_screen && Mix_Playing(LASER_SFX_CHANNEL)) {
-      Mix_HaltChannel(LASER_SFX_CHANNEL);
-    }
+  double dt = time_since_last_tick();
 
+  if (state->current_game_mode == GAME_MODE_PLAYING) {
+    // Simulate in fixed steps, stopping early if a step ends the run or opens a quiz
+    size_t steps = timestep_advance(state->timestep, dt);
+    for (size_t i = 0; i < steps && state->current_game_mode == GAME_MODE_PLAYING; i++) {
+      step_game(state, timestep_get_step(state->timestep));
+    }
   } else if (state->current_game_mode == GAME_MODE_QUIZ) {
     state->quiz_time_remaining -= dt;
     if (state->quiz_timer_text_body) {
@@ -1858,15 +1964,25 @@ bool emscripten_main(state_t *state) {
   }
 
   // ***** RENDERING *****
+  // Draw the bodies partway between the last two steps, by the time left over
+  scene_begin_interpolation(state->scene, timestep_get_alpha(state->timestep));
   sdl_clear();
   sdl_render_scene(state->scene);
 
+  // The UI text assets keep their place in the list as they change, so they are drawn last to stay on top
   list_t *assets = asset_get_asset_list();
   for (size_t i = 0; i < list_size(assets); i++) {
-    asset_render(list_get(assets, i));
+    asset_t *asset = list_get(assets, i);
+    if (!is_ui_text_asset(state, asset)) {
+      asset_render(asset);
+    }
   }
+  asset_render((asset_t *)state->time_text_asset);
+  asset_render((asset_t *)state->distance_text_asset);
+  asset_render((asset_t *)state->score_text_asset);
   
   sdl_show();
+  scene_end_interpolation(state->scene);
   return false;
 }
 
@@ -1888,7 +2004,11 @@ void emscripten_free(state_t *state) {
 
   Mix_CloseAudio();
   list_free(asset_get_asset_list());
-  scene_free(state->scene);
+  scene_snapshot_free(state->initial_level);
+  free_game_scene(state);
+  release_game_shapes(state);
+  timestep_free(state->timestep);
+  free(state->offscreen_query.found);
   asset_cache_destroy();
   free(state);
 }
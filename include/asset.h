@@ -43,9 +43,19 @@ typedef struct asset asset_t;
  */
 void asset_make_image(const char *filepath, SDL_Rect bounding_box);
 
-//makes a text asset with a bounding box, so it can have collision
-void asset_make_text_with_body(const char *fontpath, body_t *body,
-                               char *text, color_t color);
+/**
+ * Allocates memory for a text asset with an attached body and adds it to the
+ * internal asset list. When the asset is rendered, the text is drawn in the
+ * body's bounding box.
+ *
+ * @param fontpath the filepath to the font file
+ * @param body the body to render the text on top of
+ * @param text the text to draw; the asset does not take ownership of it
+ * @param color the color of the text
+ * @return the new asset, so its text can be changed in place later
+ */
+text_asset_t *asset_make_text_with_body(const char *fontpath, body_t *body,
+                                        char *text, color_t color);
 /**
  * Allocates memory for an image asset with an attached body and adds it
  * to the internal asset list. When the asset is rendered, the image will be
@@ -91,6 +101,22 @@ list_t *asset_get_asset_list();
  */
 void asset_remove_body(body_t *body);
 
+/**
+ * Notes that a body has been marked for removal, so the next call to
+ * asset_sweep_removed_bodies() destroys its assets. Until then they are
+ * kept in the asset list but not rendered.
+ * Called by body_remove().
+ */
+void asset_schedule_sweep();
+
+/**
+ * Destroys every asset attached to a body marked for removal, in one pass
+ * that keeps the remaining assets in order.
+ * Does nothing if no body has been removed since the last sweep.
+ * Must be called before the removed bodies are freed.
+ */
+void asset_sweep_removed_bodies();
+
 /**
  * Renders the asset to the screen.
  * @param asset the asset to render
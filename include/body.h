@@ -2,17 +2,149 @@
 #define __BODY_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "color.h"
+#include "jobs.h"
 #include "list.h"
+#include "pool.h"
 #include "vector.h"
 
 /**
  * A rigid body constrained to the plane.
- * Implemented as a polygon with uniform density.
+ * Implemented as a convex collider shape with uniform density.
  */
 typedef struct body body_t;
 
+/**
+ * Contiguous storage for the motion state of many bodies: one array each
+ * for centroid, velocity, force, impulse, mass and rotation.
+ * A body added to a store keeps its motion state there, and the body_*
+ * accessors read and write its slot, so a whole store can be integrated
+ * in one pass over the arrays. See body_store_tick().
+ */
+typedef struct body_store body_store_t;
+
+/**
+ * How a body moves when it is ticked.
+ */
+typedef enum {
+  /** Integrated from its forces and impulses; the default */
+  BODY_DYNAMIC,
+  /** Moves at its velocity and ignores forces and impulses */
+  BODY_KINEMATIC,
+  /** Never moves on its own and ignores forces and impulses */
+  BODY_STATIC,
+} body_motion_t;
+
+/**
+ * The part of a body that changes as a scene runs: its motion state,
+ * whether it is asleep and whether it has been removed.
+ * See body_get_state() and body_set_state().
+ */
+typedef struct body_state {
+  vector_t centroid;
+  vector_t velocity;
+  vector_t force;
+  vector_t impulse;
+  double rotation;
+  body_motion_t motion;
+  bool sleeping;
+  bool removed;
+} body_state_t;
+
+/**
+ * An immutable polygon shared by every body built from it.
+ * The prototype holds the vertices relative to their centroid, the edge
+ * normals and the area, so a body built from it only keeps a transform
+ * until its world-space vertices are first read.
+ * Prototypes are reference counted; see shape_prototype_get().
+ */
+typedef struct shape_prototype shape_prototype_t;
+
+/**
+ * The kinds of collider shape a body can have.
+ * Circles and capsules are stored as a core (a center point or a segment)
+ * with a radius around it, so collisions with them need no polygon.
+ */
+typedef enum {
+  /** A convex polygon given by its vertices */
+  SHAPE_POLYGON,
+  /** A disc around a single center point */
+  SHAPE_CIRCLE,
+  /** A segment between two points, thickened by a radius */
+  SHAPE_CAPSULE
+} shape_type_t;
+
+/**
+ * An axis-aligned bounding box in world coordinates.
+ */
+typedef struct aabb {
+  vector_t min;
+  vector_t max;
+} aabb_t;
+
+/**
+ * A read-only view of a body's outline in world coordinates.
+ */
+typedef struct shape_view {
+  /** The vertices in counterclockwise order */
+  const vector_t *vertices;
+  size_t num_vertices;
+} shape_view_t;
+
+/**
+ * The slab pools body memory is drawn from. Bodies, their vertex blocks and
+ * info payloads from body_info_alloc() are recycled through these pools, so
+ * a game that keeps spawning and freeing bodies stops calling the system
+ * allocator once the pools have grown to fit its peak.
+ */
+typedef enum {
+  /** The body structs themselves */
+  BODY_POOL_BODIES,
+  /** Info payloads from body_info_alloc() */
+  BODY_POOL_INFO,
+  /** Vertex blocks for shapes with at most 2 points (circles, capsules) */
+  BODY_POOL_VERTICES_2,
+  /** Vertex blocks for shapes with 3 or 4 vertices */
+  BODY_POOL_VERTICES_4,
+  /** Vertex blocks for shapes with 5 to 8 vertices */
+  BODY_POOL_VERTICES_8,
+  /** Vertex blocks for shapes with 9 to 16 vertices */
+  BODY_POOL_VERTICES_16,
+  /** Vertex blocks for shapes with 17 to 32 vertices; larger shapes are
+      allocated from the system */
+  BODY_POOL_VERTICES_32,
+  /** Vertex blocks for bodies built from shape prototypes with 3 or 4
+      vertices, which hold no local axes of their own */
+  BODY_POOL_PROTOTYPE_VERTICES_4,
+  /** Prototype vertex blocks for 5 to 8 vertices */
+  BODY_POOL_PROTOTYPE_VERTICES_8,
+  /** Prototype vertex blocks for 9 to 16 vertices */
+  BODY_POOL_PROTOTYPE_VERTICES_16,
+  /** Prototype vertex blocks for 17 to 32 vertices */
+  BODY_POOL_PROTOTYPE_VERTICES_32,
+  NUM_BODY_POOLS
+} body_pool_t;
+
+/**
+ * A predicate on bodies, e.g. to select the bodies of one type.
+ *
+ * @param body the body to test
+ * @param aux an auxiliary value that can store parameters or state
+ * @return whether the body is selected
+ */
+typedef bool (*body_filter_t)(body_t *body, void *aux);
+
+/**
+ * Returns whether two bounding boxes overlap or touch.
+ *
+ * @param aabb1 the first box
+ * @param aabb2 the second box
+ * @return false if the boxes are strictly separated along x or y
+ */
+bool aabb_overlaps(aabb_t aabb1, aabb_t aabb2);
+
 /**
  * Initializes a body without any info.
  * Acts like body_init_with_info() where info and info_freer are NULL.
@@ -38,7 +170,135 @@ body_t *body_init_with_info(list_t *shape, double mass, color_t color,
                             void *info, free_func_t info_freer);
 
 /**
- * Gets the current shape of a body.
+ * Allocates memory for a polygon body from an array of vertices.
+ * Acts like body_init_with_info(), but copies the vertices instead of taking
+ * a list, so no list or per-vertex memory is needed.
+ *
+ * @param vertices the vertices of the polygon in counterclockwise order
+ * @param num_vertices the number of vertices
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param color the color of the body, used to draw it on the screen
+ * @param info additional information to associate with the body,
+ *   e.g. its type if the scene has multiple types of bodies
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_polygon(const vector_t *vertices, size_t num_vertices,
+                          double mass, color_t color, void *info,
+                          free_func_t info_freer);
+
+/**
+ * Allocates memory for a body with a circular collider.
+ * The body is initially at rest.
+ * Asserts that the required memory is allocated.
+ *
+ * @param center the center of the circle
+ * @param radius the radius of the circle
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param color the color of the body, used to draw it on the screen
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_circle(vector_t center, double radius, double mass,
+                         color_t color, void *info, free_func_t info_freer);
+
+/**
+ * Allocates memory for a body with a capsule collider: every point within
+ * `radius` of the segment from `start` to `end`.
+ * The body is initially at rest.
+ * Asserts that the required memory is allocated.
+ *
+ * @param start one end of the capsule's core segment
+ * @param end the other end of the capsule's core segment
+ * @param radius the radius around the segment
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param color the color of the body, used to draw it on the screen
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_capsule(vector_t start, vector_t end, double radius,
+                          double mass, color_t color, void *info,
+                          free_func_t info_freer);
+
+/**
+ * Gets the shared prototype for a polygon, creating it if no prototype
+ * with exactly these vertices is in use.
+ * The caller holds a reference, released with shape_prototype_release();
+ * bodies built from the prototype hold their own.
+ *
+ * @param vertices the polygon's vertices in counterclockwise order
+ * @param num_vertices the number of vertices
+ * @return a pointer to the prototype
+ */
+shape_prototype_t *shape_prototype_get(const vector_t *vertices,
+                                       size_t num_vertices);
+
+/**
+ * Releases a reference to a shape prototype,
+ * freeing it once no body or caller holds one.
+ *
+ * @param prototype the pointer to the prototype
+ */
+void shape_prototype_release(shape_prototype_t *prototype);
+
+/**
+ * Gets the number of shape prototypes currently in use.
+ *
+ * @return the number of prototypes with at least one reference
+ */
+size_t shape_prototype_count(void);
+
+/**
+ * Allocates memory for a polygon body that shares a prototype's shape.
+ * The body starts at the centroid of the vertices the prototype was
+ * created from, as body_init_polygon() would place it.
+ * Its own vertices are only allocated when they are first read;
+ * body_get_aabb() of an unrotated body does not need them.
+ *
+ * @param prototype the shape, which the body takes a reference to
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param color the color of the body, used to draw it on the screen
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_from_prototype(shape_prototype_t *prototype, double mass,
+                                 color_t color, void *info,
+                                 free_func_t info_freer);
+
+/**
+ * Gets the kind of collider shape a body has.
+ *
+ * @param body the pointer to the body
+ * @return the body's shape type
+ */
+shape_type_t body_get_shape_type(body_t *body);
+
+/**
+ * Gets the radius around a body's core vertices.
+ *
+ * @param body the pointer to the body
+ * @return the radius of a circle or capsule, or 0 for a polygon
+ */
+double body_get_radius(body_t *body);
+
+/**
+ * Gets the current outline of a body without copying it.
+ * A polygon's view is its vertices, as from body_get_vertices().
+ * Circles and capsules are approximated by a polygon that is cached on the
+ * body: it is built the first time it is requested, shifted when the body
+ * moves, and rebuilt only after the body is rotated.
+ * The vertices stay valid until the body is next moved, rotated or freed.
+ *
+ * @param body the pointer to the body
+ * @return the outline's vertices and their count
+ */
+shape_view_t body_get_shape_view(body_t *body);
+
+/**
+ * Gets a copy of the current outline of a body; see body_get_shape_view().
  * Returns a newly allocated vector list, which must be list_free()d.
  *
  * @param body the pointer to the body
@@ -46,6 +306,69 @@ body_t *body_init_with_info(list_t *shape, double mass, color_t color,
  */
 list_t *body_get_shape(body_t *body);
 
+/**
+ * Gets the number of vertices in a body's shape.
+ * For circles and capsules, these are the core vertices: the center,
+ * or the two ends of the segment. The radius extends around them.
+ *
+ * @param body the pointer to the body
+ * @return the number of vertices
+ */
+size_t body_num_vertices(body_t *body);
+
+/**
+ * Gets one vertex of a body's current shape without copying the shape.
+ * Asserts that the index is valid.
+ *
+ * @param body the pointer to the body
+ * @param index the index of the vertex, in counterclockwise order
+ * @return the position of the vertex
+ */
+vector_t body_get_vertex(body_t *body, size_t index);
+
+/**
+ * Gets a read-only view of a body's current vertices, without copying them.
+ * The array is laid out as consecutive (x, y) pairs, so it can be fed
+ * directly to vectorized kernels such as project_vertices().
+ * It is invalidated when the body is freed.
+ *
+ * @param body the pointer to the body
+ * @return an array of body_num_vertices() vertices in counterclockwise order
+ */
+const vector_t *body_get_vertices(body_t *body);
+
+/**
+ * Gets the number of distinct edge normals of a body's shape.
+ * Parallel edges share a single normal.
+ *
+ * @param body the pointer to the body
+ * @return the number of separating axes to test for this body
+ */
+size_t body_num_axes(body_t *body);
+
+/**
+ * Gets one of a body's unit edge normals in world space.
+ * The normals are computed once when the body is created and are only
+ * rotated, when next read, after body_set_rotation() changes the body's
+ * angle.
+ * Asserts that the index is valid.
+ *
+ * @param body the pointer to the body
+ * @param index the index of the axis
+ * @return a unit vector perpendicular to one of the body's edges
+ */
+vector_t body_get_axis(body_t *body, size_t index);
+
+/**
+ * Gets the smallest axis-aligned box containing a body's current shape.
+ * The box is cached on the body: translating the body shifts it,
+ * and rotating the body recomputes it the next time it is requested.
+ *
+ * @param body the pointer to the body
+ * @return the body's bounding box in world coordinates
+ */
+aabb_t body_get_aabb(body_t *body);
+
 /**
  * Return the info associated with a body.
  *
@@ -82,6 +405,8 @@ vector_t body_get_velocity(body_t *body);
 /**
  * Changes a body's velocity (the time-derivative of its position).
  *
+ * A nonzero velocity wakes up a sleeping body.
+ *
  * @param body the pointer to the body
  * @param v the body's new velocity
  */
@@ -112,6 +437,58 @@ color_t body_get_color(body_t *body);
  */
 void body_set_color(body_t *body, color_t color);
 
+/**
+ * Gets the collision categories a body belongs to, as a bit mask.
+ * Bodies start with no categories.
+ *
+ * @param body the pointer to the body
+ * @return the body's category bits
+ */
+uint32_t body_get_category(body_t *body);
+
+/**
+ * Gets the collision categories a body can collide with, as a bit mask.
+ * Bodies start with an empty mask.
+ *
+ * @param body the pointer to the body
+ * @return the body's collision mask
+ */
+uint32_t body_get_collision_mask(body_t *body);
+
+/**
+ * Sets which collision categories a body belongs to and collides with.
+ * Two bodies are tested by create_filtered_collision() only if each one's
+ * category intersects the other's mask.
+ *
+ * @param body the pointer to the body
+ * @param category the category bits of the body
+ * @param mask the categories the body can collide with
+ */
+void body_set_collision_filter(body_t *body, uint32_t category, uint32_t mask);
+
+/**
+ * The tag of a body that has not been given one.
+ */
+extern const uint32_t BODY_TAG_NONE;
+
+/**
+ * Gets a body's tag, a small integer naming its kind.
+ *
+ * @param body the pointer to the body
+ * @return the tag set with body_set_tag(), or BODY_TAG_NONE
+ */
+uint32_t body_get_tag(body_t *body);
+
+/**
+ * Sets a body's tag, a small integer naming its kind, e.g. an enum value.
+ * Scenes index their bodies by tag (see scene_for_each_tagged()), so the
+ * tag must be set before the body is added to a scene.
+ *
+ * @param body the pointer to the body, not yet added to a scene
+ * @param tag the body's new tag
+ */
+void body_set_tag(body_t *body, uint32_t tag);
+
 /**
  * Gets the rotation angle of a body.
  *
@@ -124,6 +501,8 @@ double body_get_rotation(body_t *body);
  * Changes a body's orientation in the plane.
  * The body is rotated about its center of mass.
  * Note that the angle is *absolute*, not relative to the current orientation.
+ * Only the angle is stored; the vertices and axes are rotated the next time
+ * they are read.
  *
  * @param body the pointer to the body
  * @param angle the body's new angle in radians. Positive is counterclockwise.
@@ -137,12 +516,73 @@ void body_set_rotation(body_t *body, double angle);
  * The body is translated at the *average* of the velocities before
  * and after the tick.
  * Resets the forces and impulses accumulated on the body.
+ * Kinematic bodies just move at their velocity; static and sleeping
+ * bodies do not move.
  *
  * @param body the body to tick
  * @param dt the number of seconds elapsed since the last tick
  */
 void body_tick(body_t *body, double dt);
 
+/**
+ * Changes how a body moves when it is ticked. Bodies start out dynamic.
+ * Making a body static or kinematic discards its accumulated force and
+ * impulse, and any body is woken up by changing its motion class.
+ *
+ * @param body the pointer to the body
+ * @param motion the body's new motion class
+ */
+void body_set_motion(body_t *body, body_motion_t motion);
+
+/**
+ * Gets how a body moves when it is ticked.
+ *
+ * @param body the pointer to the body
+ * @return the body's motion class
+ */
+body_motion_t body_get_motion(body_t *body);
+
+/**
+ * A dynamic body in a store moving slower than this is at rest.
+ */
+extern const double BODY_SLEEP_SPEED;
+
+/**
+ * How many seconds a dynamic body in a store must stay at rest
+ * before it is put to sleep.
+ */
+extern const double BODY_SLEEP_TIME;
+
+/**
+ * Returns whether a dynamic body has been put to sleep.
+ * A dynamic body in a store that stays slower than BODY_SLEEP_SPEED for
+ * BODY_SLEEP_TIME seconds is stopped and skipped by body_store_tick()
+ * until it is woken up by a nonzero force, impulse or velocity,
+ * or by body_wake().
+ *
+ * @param body the pointer to the body
+ * @return whether the body is asleep
+ */
+bool body_is_sleeping(body_t *body);
+
+/**
+ * Wakes a sleeping body up, so it is integrated again.
+ * Does nothing if the body is awake.
+ *
+ * @param body the pointer to the body
+ */
+void body_wake(body_t *body);
+
+/**
+ * Makes a body's current centroid and rotation its previous pose too,
+ * so an interpolated frame (see body_store_begin_interpolation()) shows it
+ * where it is rather than partway along a jump, like wrapping around the
+ * screen. Does nothing if the body is not in a store.
+ *
+ * @param body the pointer to the body
+ */
+void body_reset_interpolation(body_t *body);
+
 /**
  * Returns the mass of a body.
  *
@@ -154,6 +594,7 @@ double body_get_mass(body_t *body);
 /**
  * Applies a force to a body over the current tick.
  * If multiple forces are applied in the same tick, they are added.
+ * Ignored by static and kinematic bodies; wakes up a sleeping body.
  * Does not change the body's position or velocity; see body_tick().
  *
  * @param body the pointer to the body
@@ -166,6 +607,7 @@ void body_add_force(body_t *body, vector_t force);
  * An impulse causes an instantaneous change in velocity,
  * which is useful for modeling collisions.
  * If multiple impulses are applied in the same tick, they are added.
+ * Ignored by static and kinematic bodies; wakes up a sleeping body.
  * Does not change the body's position or velocity; see body_tick().
  *
  * @param body the pointer to the body
@@ -183,6 +625,9 @@ void body_reset(body_t *body);
 /**
  * Marks a body for removal--future calls to body_is_removed() will return
  * `true`. Does not free the body.
+ * The body also leaves every collision group it belongs to, and pending
+ * contact events involving it are dropped. Its assets stop being rendered
+ * and are destroyed when the scene frees the body.
  * If the body is already marked for removal,
  * does nothing.
  *
@@ -200,11 +645,156 @@ void body_remove(body_t *body);
  */
 bool body_is_removed(body_t *body);
 
+/**
+ * Gets the part of a body that changes as a scene runs, to put it back
+ * later with body_set_state().
+ *
+ * @param body the pointer to the body
+ * @return the body's current state
+ */
+body_state_t body_get_state(body_t *body);
+
+/**
+ * Puts a body back in a state returned by body_get_state().
+ * Clearing the removal mark does not put the body back in the collision
+ * groups, assets and contact queues body_remove() took it out of.
+ *
+ * @param body the pointer to the body
+ * @param state the state to put the body in
+ */
+void body_set_state(body_t *body, const body_state_t *state);
+
 /**
  * Frees memory allocated for a body.
+ * Removes it from its body store first, if it is in one.
  *
  * @param body the pointer to the body
  */
 void body_free(body_t *body);
 
+/**
+ * Allocates a small info payload from a pool instead of the system.
+ * Pass body_info_free() as the body's info freer to recycle it.
+ * Asserts that the size fits a pool block.
+ *
+ * @param size the size of the payload in bytes; at most 32
+ * @return a pointer to uninitialized memory for the payload
+ */
+void *body_info_alloc(size_t size);
+
+/**
+ * Returns an info payload from body_info_alloc() to its pool.
+ * Does nothing if the info is NULL.
+ *
+ * @param info the payload to free
+ */
+void body_info_free(void *info);
+
+/**
+ * Gets the occupancy statistics of one of the body pools.
+ *
+ * @param kind which pool to inspect
+ * @return the pool's current statistics
+ */
+pool_stats_t body_get_pool_stats(body_pool_t kind);
+
+/**
+ * Allocates memory for an empty body store.
+ * Asserts that the required memory is allocated.
+ *
+ * @return a pointer to the newly allocated store
+ */
+body_store_t *body_store_init(void);
+
+/**
+ * Moves a body's motion state into a store.
+ * Asserts that the body is not already in a store.
+ * Does not take ownership of the body.
+ *
+ * @param store the pointer to the store
+ * @param body the body to add
+ */
+void body_store_add(body_store_t *store, body_t *body);
+
+/**
+ * Moves a body's motion state out of its store and back into the body.
+ * The last body in the store takes over the freed slot.
+ * Does nothing if the body is not in a store.
+ *
+ * @param body the body to remove
+ */
+void body_store_remove(body_t *body);
+
+/**
+ * Gets the number of bodies in a store.
+ *
+ * @param store the pointer to the store
+ * @return the number of bodies added and not removed
+ */
+size_t body_store_size(body_store_t *store);
+
+/**
+ * Ticks every body in a store, exactly as body_tick() would.
+ * The store keeps awake dynamic bodies, kinematic bodies, and static and
+ * sleeping bodies in separate ranges of its arrays, so it integrates the
+ * first range in one loop, moves the second at constant velocity and
+ * skips the rest. Then it puts dynamic bodies that have been at rest for
+ * BODY_SLEEP_TIME to sleep.
+ *
+ * @param store the pointer to the store
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_store_tick(body_store_t *store, double dt);
+
+/**
+ * Ticks every body in a store like body_store_tick(), integrating the
+ * awake and kinematic ranges in chunks on a job pool.
+ * The results are identical to body_store_tick().
+ *
+ * @param store the pointer to the store
+ * @param dt the number of seconds elapsed since the last tick
+ * @param pool the job pool to run the chunks on,
+ *   or NULL to tick on the calling thread
+ */
+void body_store_tick_with_jobs(body_store_t *store, double dt,
+                               job_pool_t *pool);
+
+/**
+ * Records each body's centroid and rotation in a store as its previous
+ * pose, to interpolate from once the store has been ticked.
+ * Bodies added later start with their pose at the time they were added.
+ *
+ * @param store the pointer to the store
+ */
+void body_store_save_poses(body_store_t *store);
+
+/**
+ * Moves each body in a store partway from its previous pose (see
+ * body_store_save_poses()) to its current one, to draw a frame that falls
+ * between two ticks. Centroids and rotations are interpolated linearly.
+ * The bodies must not be ticked, added or removed until
+ * body_store_end_interpolation() puts them back.
+ *
+ * @param store the pointer to the store
+ * @param alpha how far to move each body, from 0 (its previous pose)
+ *   to 1 (its current pose)
+ */
+void body_store_begin_interpolation(body_store_t *store, double alpha);
+
+/**
+ * Puts each body in a store back in the pose it was in before
+ * body_store_begin_interpolation() was called.
+ *
+ * @param store the pointer to the store
+ */
+void body_store_end_interpolation(body_store_t *store);
+
+/**
+ * Frees memory allocated for a body store.
+ * Bodies still in it keep their motion state and are not freed.
+ *
+ * @param store the pointer to the store
+ */
+void body_store_free(body_store_t *store);
+
 #endif // #ifndef __BODY_H__
\ No newline at end of file
@@ -20,6 +20,12 @@ typedef struct {
    * If collided is false, this value is undefined.
    */
   vector_t axis;
+  /**
+   * For a swept collision, the fraction of the tick, in [0, 1], at which
+   * the shapes first touched (see swept_collision_info_t).
+   * Tests at a single instant, like find_collision(), leave it at 0.
+   */
+  double time;
 } collision_info_t;
 
 /**
@@ -32,4 +38,146 @@ typedef struct {
  */
 collision_info_t find_collision(body_t *body1, body_t *body2);
 
+/**
+ * A buffer find_collisions_batch() keeps a subject's projections in when
+ * the subject has too many axes to keep them on the stack.
+ * Zero-initialize it before its first use, reuse it between batches, and
+ * release it with collision_scratch_free().
+ */
+typedef struct {
+  vector_t *projections;
+  size_t capacity;
+} collision_scratch_t;
+
+/**
+ * Computes the status of the collisions between one body and many others.
+ * Each result is the same as find_collision(subject, others[i]), but the
+ * subject's bounding box and its projections onto its own axes are only
+ * computed once for the whole batch.
+ * Makes no heap allocations unless the subject is a polygon with more than
+ * 32 axes, and then only to grow `scratch`.
+ *
+ * @param subject the body tested against every other body
+ * @param others an array of the other bodies
+ * @param num_others the number of other bodies
+ * @param out an array of `num_others` results, filled in the same order
+ *   as `others`
+ * @param scratch a buffer for a subject with many axes, or NULL to
+ *   allocate one for this call if it is needed
+ */
+void find_collisions_batch(body_t *subject, body_t **others, size_t num_others,
+                           collision_info_t *out,
+                           collision_scratch_t *scratch);
+
+/**
+ * Frees the memory held by a collision scratch buffer and empties it.
+ * Does not free the collision_scratch_t itself.
+ *
+ * @param scratch the scratch buffer
+ */
+void collision_scratch_free(collision_scratch_t *scratch);
+
+/**
+ * Remembers the axis that separated a pair of shapes the last time they were
+ * tested. Shapes usually stay apart along the same axis for many ticks,
+ * so testing it first lets most checks skip the full SAT loop.
+ * Zero-initialize it (or set valid to false) before the first test.
+ */
+typedef struct {
+  /** Whether axis holds a separating axis from an earlier test */
+  bool valid;
+  /** The unit axis that last separated the shapes */
+  vector_t axis;
+} axis_cache_t;
+
+/**
+ * Counts the separating-axis cache lookups made by find_collision_cached().
+ */
+typedef struct {
+  /** Tests where the cached axis still separated the shapes */
+  size_t hits;
+  /** Tests that fell through to the full SAT loop */
+  size_t misses;
+} axis_cache_stats_t;
+
+/**
+ * Computes the status of the collision between two bodies like
+ * find_collision(), but first tests the axis that separated them last time.
+ * The cache is updated with the new separating axis, or cleared if the
+ * bodies collide.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param cache the separating axis cache for this pair of bodies
+ * @return whether the shapes are colliding, and if so, the collision axis
+ */
+collision_info_t find_collision_cached(body_t *body1, body_t *body2,
+                                       axis_cache_t *cache);
+
+/**
+ * Returns the number of cache hits and misses in find_collision_cached()
+ * since the program started or the counters were last reset.
+ *
+ * @return the hit and miss counts
+ */
+axis_cache_stats_t collision_get_axis_cache_stats(void);
+
+/**
+ * Resets the counters returned by collision_get_axis_cache_stats() to 0.
+ */
+void collision_reset_axis_cache_stats(void);
+
+/**
+ * Represents the status of a collision between two shapes moving in straight
+ * lines over a tick.
+ */
+typedef struct {
+  /** Whether the two shapes touch at any point during the motion */
+  bool collided;
+  /**
+   * If the shapes collide, the separating axis they first touch along.
+   * If collided is false, this value is undefined.
+   */
+  vector_t axis;
+  /**
+   * If the shapes collide, the earliest fraction of the motion, in [0, 1],
+   * at which they touch. 0 means they already overlapped at the start.
+   */
+  double time;
+} swept_collision_info_t;
+
+/**
+ * Computes the earliest contact between two bodies over a tick in which each
+ * moved in a straight line, without rotating, to its current position.
+ * Unlike find_collision(), this catches fast bodies that pass completely
+ * through each other between ticks.
+ * For circles and capsules the test is conservative: it may report
+ * a contact for bodies that pass just beside each other.
+ *
+ * @param body1 the first body, at the end of its motion
+ * @param displacement1 how far body1 moved during the tick
+ * @param body2 the second body, at the end of its motion
+ * @param displacement2 how far body2 moved during the tick
+ * @return whether the shapes touched during the tick, and if so, the axis
+ *   and time of first contact
+ */
+swept_collision_info_t find_swept_collision(body_t *body1,
+                                            vector_t displacement1,
+                                            body_t *body2,
+                                            vector_t displacement2);
+
+/**
+ * Finds where a ray first meets a body's shape.
+ *
+ * @param body the body to test
+ * @param origin the start of the ray
+ * @param direction the unit direction of the ray
+ * @param max_distance how far along the ray to look
+ * @param distance if the ray hits, set to the distance along the ray to the
+ *   first point on the body, or 0 if the ray starts inside it
+ * @return whether the ray meets the body within `max_distance`
+ */
+bool find_ray_collision(body_t *body, vector_t origin, vector_t direction,
+                        double max_distance, double *distance);
+
 #endif // #ifndef __COLLISION_H__
@@ -0,0 +1,85 @@
+#ifndef __COLLISION_GROUP_H__
+#define __COLLISION_GROUP_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "body.h"
+
+/**
+ * A set of bodies that collide as a group, e.g. every collectible.
+ * Bodies leave every group they are in automatically when body_remove()
+ * is called on them, so a group never refers to a freed body.
+ * Adding, removing and membership tests take constant time.
+ */
+typedef struct collision_group collision_group_t;
+
+/**
+ * Allocates memory for an empty collision group.
+ * Asserts that the required memory is allocated.
+ *
+ * @return a pointer to the newly allocated group
+ */
+collision_group_t *collision_group_init(void);
+
+/**
+ * Adds a body to a group if it is not already a member.
+ * Does not take ownership of the body.
+ *
+ * @param group the pointer to the group
+ * @param body the body to add
+ */
+void collision_group_add(collision_group_t *group, body_t *body);
+
+/**
+ * Removes a body from a group if it is a member.
+ * The order of the remaining members may change.
+ *
+ * @param group the pointer to the group
+ * @param body the body to remove
+ */
+void collision_group_remove(collision_group_t *group, body_t *body);
+
+/**
+ * Returns whether a body is a member of a group.
+ *
+ * @param group the pointer to the group
+ * @param body the body to look for
+ * @return whether the body has been added and not removed since
+ */
+bool collision_group_contains(collision_group_t *group, body_t *body);
+
+/**
+ * Gets the number of bodies in a group.
+ *
+ * @param group the pointer to the group
+ * @return the number of members
+ */
+size_t collision_group_size(collision_group_t *group);
+
+/**
+ * Gets one of the members of a group.
+ * Asserts that the index is valid.
+ *
+ * @param group the pointer to the group
+ * @param index the index of the member, less than collision_group_size()
+ * @return the member at that index
+ */
+body_t *collision_group_get(collision_group_t *group, size_t index);
+
+/**
+ * Removes a body from every live group. Called by body_remove().
+ *
+ * @param body the body being removed
+ */
+void collision_group_remove_body(body_t *body);
+
+/**
+ * Frees memory allocated for a group.
+ * Does not free its members.
+ *
+ * @param group the pointer to the group
+ */
+void collision_group_free(collision_group_t *group);
+
+#endif // #ifndef __COLLISION_GROUP_H__
@@ -0,0 +1,96 @@
+#ifndef __CONTACT_QUEUE_H__
+#define __CONTACT_QUEUE_H__
+
+#include "body.h"
+#include "vector.h"
+
+/**
+ * The kinds of change in contact between two bodies.
+ */
+typedef enum {
+  /** The bodies started touching this tick */
+  CONTACT_BEGIN,
+  /** The bodies were touching last tick and still are */
+  CONTACT_STAY,
+  /** The bodies were touching last tick and no longer are */
+  CONTACT_END
+} contact_event_type_t;
+
+/**
+ * A change in contact between two bodies, recorded during scene_tick().
+ */
+typedef struct {
+  contact_event_type_t type;
+  /** The first body, e.g. the member of the first group of a group pass */
+  body_t *body1;
+  /** The second body */
+  body_t *body2;
+  /**
+   * For begin and stay events, the collision axis from body1 towards body2.
+   * For end events, this value is undefined.
+   */
+  vector_t axis;
+} contact_event_t;
+
+/**
+ * A buffer of contact events, filled by the collision passes during
+ * scene_tick() and drained by game code once the tick is over, so that
+ * reacting to a contact never modifies the scene in the middle of a tick.
+ * Events whose bodies have been removed with body_remove() are dropped,
+ * so every drained event refers to bodies that are still in the scene.
+ */
+typedef struct contact_queue contact_queue_t;
+
+/**
+ * A function called on each event when a contact queue is drained.
+ *
+ * @param event the contact event
+ * @param aux an auxiliary value passed to contact_queue_drain()
+ */
+typedef void (*contact_handler_t)(contact_event_t event, void *aux);
+
+/**
+ * Allocates memory for an empty contact queue.
+ * Asserts that the required memory is allocated.
+ *
+ * @return a pointer to the newly allocated queue
+ */
+contact_queue_t *contact_queue_init(void);
+
+/**
+ * Appends an event to the end of a queue.
+ *
+ * @param queue the pointer to the queue
+ * @param event the event to append
+ */
+void contact_queue_push(contact_queue_t *queue, contact_event_t event);
+
+/**
+ * Calls a function on every event in a queue, in the order they were
+ * pushed, and then empties the queue.
+ * The function may remove bodies; events involving them that have not been
+ * handled yet are skipped.
+ *
+ * @param queue the pointer to the queue
+ * @param handler the function to call on each event
+ * @param aux an auxiliary value to pass to `handler`
+ */
+void contact_queue_drain(contact_queue_t *queue, contact_handler_t handler,
+                         void *aux);
+
+/**
+ * Drops the events involving a body from every live queue.
+ * Called by body_remove().
+ *
+ * @param body the body being removed
+ */
+void contact_queue_remove_body(body_t *body);
+
+/**
+ * Frees memory allocated for a queue, discarding any pending events.
+ *
+ * @param queue the pointer to the queue
+ */
+void contact_queue_free(contact_queue_t *queue);
+
+#endif // #ifndef __CONTACT_QUEUE_H__
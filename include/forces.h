@@ -2,6 +2,8 @@
 #define __FORCES_H__
 
 #include "collision.h"
+#include "collision_group.h"
+#include "contact_queue.h"
 #include "scene.h"
 
 /**
@@ -16,6 +18,22 @@
 typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
                                     void *aux, double force_const);
 
+/**
+ * A function called when a swept collision occurs; see
+ * create_timed_swept_collision().
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param axis a unit vector pointing from body1 towards body2
+ *   that defines the direction the two bodies are colliding in
+ * @param time the fraction of the tick, in [0, 1], at which the bodies
+ *   first touched
+ * @param aux the auxiliary value
+ * @param force_const the force constant
+ */
+typedef void (*swept_collision_handler_t)(body_t *body1, body_t *body2,
+                                          vector_t axis, double time,
+                                          void *aux, double force_const);
+
 /**
  * Adds a force creator to a scene that applies gravity between two bodies.
  * The force creator will be called each tick
@@ -79,6 +97,111 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
                       collision_handler_t handler, void *aux,
                       double force_const, free_func_t freer);
 
+/**
+ * Like create_collision(), but also catches collisions that happen between
+ * ticks. Each tick, the bodies are swept along the straight paths they took
+ * since the previous tick (see find_swept_collision()), so a fast body
+ * cannot pass through the other without the handler being called.
+ * Use this for fast-moving bodies or long ticks; it costs more than
+ * create_collision() and ignores the scene's broad phase.
+ *
+ * @param scene the scene containing the bodies
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param handler a function to call whenever the bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param force_const a constant to pass to the handler
+ * @param freer a function to free the auxiliary value
+ */
+void create_swept_collision(scene_t *scene, body_t *body1, body_t *body2,
+                            collision_handler_t handler, void *aux,
+                            double force_const, free_func_t freer);
+
+/**
+ * Like create_swept_collision(), but also passes the handler the time of
+ * first contact, e.g. to rewind a fast body to where it hit.
+ *
+ * @param scene the scene containing the bodies
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param handler a function to call whenever the bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param force_const a constant to pass to the handler
+ * @param freer a function to free the auxiliary value
+ */
+void create_timed_swept_collision(scene_t *scene, body_t *body1, body_t *body2,
+                                  swept_collision_handler_t handler, void *aux,
+                                  double force_const, free_func_t freer);
+
+/**
+ * Adds a single force creator to a scene that checks every pair of bodies
+ * whose collision filters match (see body_set_collision_filter()) and calls
+ * a handler each time such a pair starts colliding.
+ * This replaces registering create_collision() for each pair by hand.
+ * Pairs are skipped by their filters before any geometry is tested,
+ * and the scene's broad phase is used if it is enabled.
+ * The handler receives the body with the lower category bits first.
+ * The pass stays in the scene until the scene is freed.
+ *
+ * @param scene the scene containing the bodies
+ * @param handler a function to call whenever two bodies start colliding
+ * @param aux an auxiliary value to pass to the handler
+ * @param force_const a constant to pass to the handler
+ * @param freer a function to free the auxiliary value
+ */
+void create_filtered_collision(scene_t *scene, collision_handler_t handler,
+                               void *aux, double force_const,
+                               free_func_t freer);
+
+/**
+ * Adds a single force creator to a scene that checks every body in one
+ * group against every body in another and calls a handler each time such
+ * a pair starts colliding.
+ * This replaces registering create_collision() for each pair by hand:
+ * bodies join and leave the groups without adding force creators, and
+ * removed bodies leave the groups automatically.
+ * The scene's broad phase is used if it is enabled.
+ * The handler receives the member of `group_a` first.
+ * The pass stays in the scene until the scene is freed. The scene does not
+ * take ownership of the groups, which must stay allocated until then.
+ *
+ * @param scene the scene containing the bodies
+ * @param group_a the first group
+ * @param group_b the second group; may be the same as `group_a`
+ * @param handler a function to call whenever two bodies start colliding
+ * @param aux an auxiliary value to pass to the handler
+ * @param force_const a constant to pass to the handler
+ * @param freer a function to free the auxiliary value
+ */
+void create_group_collision(scene_t *scene, collision_group_t *group_a,
+                            collision_group_t *group_b,
+                            collision_handler_t handler, void *aux,
+                            double force_const, free_func_t freer);
+
+/**
+ * Like create_group_collision(), but instead of calling a handler in the
+ * middle of scene_tick(), records each change in contact between the
+ * groups' members in a queue for the caller to drain after the tick
+ * (see contact_queue_drain()).
+ * Each tick pushes a begin event for pairs that started touching and an
+ * end event for pairs that stopped touching. Stay events for pairs still
+ * touching are only pushed if `stay_events` is set, since they add one
+ * event per touching pair per tick. No end event is pushed for a pair once
+ * one of its bodies has been removed.
+ * The scene does not take ownership of the groups or the queue,
+ * which must stay allocated until the scene is freed.
+ *
+ * @param scene the scene containing the bodies
+ * @param group_a the first group; its members are body1 in the events
+ * @param group_b the second group; may be the same as `group_a`
+ * @param queue the queue to push events to
+ * @param stay_events whether to push a stay event each tick for every pair
+ *   that is still touching
+ */
+void create_group_contact_events(scene_t *scene, collision_group_t *group_a,
+                                 collision_group_t *group_b,
+                                 contact_queue_t *queue, bool stay_events);
+
 /**
  * Adds a force creator to a scene that destroys two bodies when they collide.
  * The bodies are destroyed by calling body_remove().
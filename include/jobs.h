@@ -0,0 +1,79 @@
+#ifndef __JOBS_H__
+#define __JOBS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A fixed pool of worker threads that run batches of jobs.
+ * Each thread has its own deque of jobs; a thread that runs out of jobs
+ * steals from the other end of another thread's deque, so uneven jobs
+ * still keep every thread busy. The thread that submits a batch works on
+ * it too and returns once every job in the batch has finished.
+ *
+ * Threads are only started where pthreads are available (native builds,
+ * or emcc with -pthread). Elsewhere the pool runs every job on the calling
+ * thread, in order.
+ */
+typedef struct job_pool job_pool_t;
+
+/**
+ * A job that handles the items in a range of indices.
+ *
+ * @param aux the auxiliary value passed to job_pool_parallel_for()
+ * @param start the first index in the range
+ * @param end one past the last index in the range
+ */
+typedef void (*job_func_t)(void *aux, size_t start, size_t end);
+
+/**
+ * Allocates memory for a job pool and starts its worker threads.
+ * Asserts that the required memory is allocated.
+ *
+ * @param num_threads the number of threads to run jobs on, including the
+ *   thread that submits them, or 0 for one per processor core
+ * @return a pointer to the newly allocated job pool
+ */
+job_pool_t *job_pool_init(size_t num_threads);
+
+/**
+ * Gets the number of threads a job pool runs jobs on,
+ * including the thread that submits them.
+ *
+ * @param pool the pointer to the job pool
+ * @return the number of threads; 1 if the pool runs jobs inline
+ */
+size_t job_pool_num_threads(job_pool_t *pool);
+
+/**
+ * Forces a job pool to run every job on the calling thread, in order,
+ * or lets it use its worker threads again.
+ *
+ * @param pool the pointer to the job pool
+ * @param single_threaded whether to run jobs on the calling thread only
+ */
+void job_pool_set_single_threaded(job_pool_t *pool, bool single_threaded);
+
+/**
+ * Splits the indices [0, count) into ranges of at most `chunk_size`
+ * indices and runs `func` on each range, in parallel where possible.
+ * Returns once every range has been handled.
+ * Jobs must not submit more jobs to the same pool.
+ *
+ * @param pool the pointer to the job pool
+ * @param count the number of indices
+ * @param chunk_size the most indices per job; must be positive
+ * @param func the function to run on each range
+ * @param aux an auxiliary value to pass to `func`
+ */
+void job_pool_parallel_for(job_pool_t *pool, size_t count, size_t chunk_size,
+                           job_func_t func, void *aux);
+
+/**
+ * Stops a job pool's worker threads and frees its memory.
+ *
+ * @param pool the pointer to the job pool
+ */
+void job_pool_free(job_pool_t *pool);
+
+#endif // #ifndef __JOBS_H__
@@ -0,0 +1,77 @@
+#ifndef __PAIR_SET_H__
+#define __PAIR_SET_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A hash set of unordered pairs of pointers, e.g. pairs of bodies.
+ * (a, b) and (b, a) are the same pair.
+ * Pairs are kept in insertion order, so the set can also be iterated.
+ */
+typedef struct pair_set pair_set_t;
+
+/**
+ * Allocates memory for an empty pair set.
+ * Asserts that the required memory is allocated.
+ *
+ * @return a pointer to the newly allocated pair set
+ */
+pair_set_t *pair_set_init(void);
+
+/**
+ * Adds an unordered pair to a set if it is not already there.
+ *
+ * @param set the pointer to the pair set
+ * @param first one element of the pair
+ * @param second the other element of the pair
+ * @return true if the pair was added, false if it was already in the set
+ */
+bool pair_set_add(pair_set_t *set, void *first, void *second);
+
+/**
+ * Returns whether an unordered pair is in a set.
+ *
+ * @param set the pointer to the pair set
+ * @param first one element of the pair
+ * @param second the other element of the pair
+ * @return whether the pair has been added since the set was last cleared
+ */
+bool pair_set_contains(pair_set_t *set, void *first, void *second);
+
+/**
+ * Gets the number of pairs in a set.
+ *
+ * @param set the pointer to the pair set
+ * @return the number of pairs
+ */
+size_t pair_set_size(pair_set_t *set);
+
+/**
+ * Gets the pair at a given position in insertion order.
+ * The elements are returned in the order they were passed to pair_set_add().
+ * Asserts that the index is valid.
+ *
+ * @param set the pointer to the pair set
+ * @param index the position of the pair (starting at 0)
+ * @param first set to the first element of the pair
+ * @param second set to the second element of the pair
+ */
+void pair_set_get(pair_set_t *set, size_t index, void **first, void **second);
+
+/**
+ * Removes every pair from a set, keeping its memory for reuse.
+ *
+ * @param set the pointer to the pair set
+ */
+void pair_set_clear(pair_set_t *set);
+
+/**
+ * Frees memory allocated for a pair set.
+ * Does not free the elements of the pairs.
+ *
+ * @param set the pointer to the pair set
+ */
+void pair_set_free(pair_set_t *set);
+
+#endif // #ifndef __PAIR_SET_H__
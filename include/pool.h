@@ -0,0 +1,74 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stddef.h>
+
+/**
+ * A fixed-size block allocator. Blocks are carved out of large slabs and
+ * recycled through a free list, so once a pool has grown to its peak
+ * occupancy, allocating and releasing blocks never calls malloc() or
+ * free(). Slabs are only returned to the system by pool_free().
+ */
+typedef struct pool pool_t;
+
+/**
+ * Occupancy statistics for a pool.
+ */
+typedef struct pool_stats {
+  // The usable size of each block, in bytes
+  size_t block_size;
+  // The number of slabs allocated from the system
+  size_t num_slabs;
+  // The number of blocks in all slabs
+  size_t capacity;
+  // The number of blocks currently allocated
+  size_t in_use;
+  // The largest number of blocks allocated at once
+  size_t peak_in_use;
+} pool_stats_t;
+
+/**
+ * Allocates memory for an empty pool.
+ * Asserts that the required memory is allocated.
+ *
+ * @param block_size the size of each block, in bytes
+ * @param blocks_per_slab how many blocks to allocate from the system at once
+ * @return a pointer to the newly allocated pool
+ */
+pool_t *pool_init(size_t block_size, size_t blocks_per_slab);
+
+/**
+ * Takes a block from a pool, allocating a new slab if every block is in use.
+ * Asserts that the required memory is allocated.
+ * The block is suitably aligned for any type and its contents are undefined.
+ *
+ * @param pool the pointer to the pool
+ * @return a pointer to a block of at least the pool's block size
+ */
+void *pool_alloc(pool_t *pool);
+
+/**
+ * Returns a block to the pool it was taken from.
+ *
+ * @param pool the pointer to the pool
+ * @param block a block returned by pool_alloc() on the same pool
+ */
+void pool_release(pool_t *pool, void *block);
+
+/**
+ * Gets the occupancy statistics of a pool.
+ *
+ * @param pool the pointer to the pool
+ * @return the pool's current statistics
+ */
+pool_stats_t pool_get_stats(pool_t *pool);
+
+/**
+ * Frees a pool and all of its slabs.
+ * Any blocks still in use become invalid.
+ *
+ * @param pool the pointer to the pool
+ */
+void pool_free(pool_t *pool);
+
+#endif // #ifndef __POOL_H__
@@ -0,0 +1,26 @@
+#ifndef __PROJECTION_H__
+#define __PROJECTION_H__
+
+#include <stddef.h>
+
+#include "vector.h"
+
+/**
+ * Projects a polygon's vertices onto an axis, returning the extent of the
+ * projections. This is the inner loop of the separating axis test.
+ *
+ * The kernel is chosen at compile time: AVX handles four vertices per
+ * instruction, SSE2 handles two, and other targets, including the
+ * WebAssembly build, use a scalar loop. All paths return the same values
+ * up to floating-point rounding.
+ *
+ * @param vertices an array of vertices, e.g. from body_get_vertices()
+ * @param num_vertices the number of vertices; must be at least 1
+ * @param unit_axis the unit axis to project each vertex on
+ * @return a vector in the form (min, max) where `min` is the minimum
+ *   projection length and `max` is the maximum projection length
+ */
+vector_t project_vertices(const vector_t *vertices, size_t num_vertices,
+                          vector_t unit_axis);
+
+#endif // #ifndef __PROJECTION_H__
@@ -1,6 +1,8 @@
 #ifndef __SCENE_H__
 #define __SCENE_H__
 
+#include <stdint.h>
+
 #include "body.h"
 #include "list.h"
 
@@ -11,6 +13,27 @@
  */
 typedef struct scene scene_t;
 
+/**
+ * A saved copy of the bodies and force creators in a scene, which the scene
+ * can be put back to any number of times. See scene_snapshot().
+ */
+typedef struct scene_snapshot scene_snapshot_t;
+
+/**
+ * A reference to a body in a scene that can safely outlive the body.
+ * Handles resolve in constant time, and a handle to a body that has been
+ * removed resolves to NULL even after its memory is reused for another body.
+ */
+typedef struct body_handle {
+  uint32_t index;
+  uint32_t generation;
+} body_handle_t;
+
+/**
+ * A handle that never resolves to a body.
+ */
+extern const body_handle_t BODY_HANDLE_NONE;
+
 /**
  * A function which adds some forces or impulses to bodies,
  * e.g. from collisions, gravity, or spring forces.
@@ -19,6 +42,31 @@ typedef struct scene scene_t;
  */
 typedef void (*force_creator_t)(void *aux, list_t *bodies);
 
+/**
+ * A function called on a pair of bodies.
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param aux an auxiliary value that can store parameters or state
+ */
+typedef void (*body_pair_func_t)(body_t *body1, body_t *body2, void *aux);
+
+/**
+ * A function called on a body.
+ * @param body the body
+ * @param aux an auxiliary value that can store parameters or state
+ */
+typedef void (*body_func_t)(body_t *body, void *aux);
+
+/**
+ * A body met by a ray cast with scene_raycast().
+ */
+typedef struct {
+  // The body the ray met
+  body_t *body;
+  // How far along the ray the body starts, or 0 if the ray starts inside it
+  double distance;
+} raycast_hit_t;
+
 /**
  * Allocates memory for an empty scene.
  * Makes a reasonable guess of the number of bodies to allocate space for.
@@ -48,11 +96,57 @@ body_t *scene_get_body(scene_t *scene, size_t index);
 
 /**
  * Adds a body to a scene, taking ownership of the body.
+ * If the body has a tag, it must be less than 256.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param body a pointer to the body to add to the scene
+ * @return a handle to the body, which may be ignored
  */
-void scene_add_body(scene_t *scene, body_t *body);
+body_handle_t scene_add_body(scene_t *scene, body_t *body);
+
+/**
+ * Gets the body a handle refers to, in constant time.
+ *
+ * @param scene the scene the handle came from
+ * @param handle a handle returned by scene_add_body()
+ * @return the body, or NULL if it has been marked for removal or freed
+ */
+body_t *scene_resolve(scene_t *scene, body_handle_t handle);
+
+/**
+ * Marks the body a handle refers to for removal, in constant time.
+ * It is freed along with its force creators in the next scene_tick().
+ *
+ * @param scene the scene the handle came from
+ * @param handle a handle returned by scene_add_body()
+ * @return false if the handle was already stale
+ */
+bool scene_remove_handle(scene_t *scene, body_handle_t handle);
+
+/**
+ * Gets the number of bodies in a scene with a given tag, in constant time.
+ * Bodies are indexed by the tag they had when added (see body_set_tag()).
+ * Bodies marked for removal are counted until the next scene_tick().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tag the tag to count
+ * @return the number of bodies with that tag
+ */
+size_t scene_count_tagged(scene_t *scene, uint32_t tag);
+
+/**
+ * Calls a function on every body in a scene with a given tag,
+ * visiting only those bodies. Bodies marked for removal are skipped,
+ * including ones removed by `func` partway through; bodies added by
+ * `func` are not visited.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tag the tag to look for
+ * @param func the function to call on each body
+ * @param aux an auxiliary value to pass to `func`
+ */
+void scene_for_each_tagged(scene_t *scene, uint32_t tag, body_func_t func,
+                           void *aux);
 
 /**
  * @deprecated Use body_remove() instead
@@ -71,6 +165,10 @@ void scene_remove_body(scene_t *scene, size_t index);
  * The auxiliary value is passed to the force creator each time it is called.
  * The force creator is registered with a list of bodies it applies to,
  * so it can be removed when any one of the bodies is removed.
+ * The scene indexes the force creator under each of the bodies, so removing
+ * a body only visits the force creators acting on it. Bodies should be added
+ * to the scene first; a force creator registered with bodies that are not in
+ * the scene yet is checked against every removed body instead.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param force_creator a force creator function
@@ -84,21 +182,214 @@ void scene_remove_body(scene_t *scene, size_t index);
 void scene_add_force_creator(scene_t *scene, force_creator_t force_creator,
                              void *aux, list_t *bodies, free_func_t freer);
 
+/**
+ * Adds a force creator that only acts on its own bodies, so a scene with a
+ * job pool (see scene_set_job_pool()) can run it alongside force creators
+ * acting on other bodies. It behaves like scene_add_force_creator() otherwise.
+ * The force creator must only read the motion state of the bodies in
+ * `bodies` (centroid, velocity, rotation, mass and so on) through the body
+ * accessors, change them only through body_add_force() and
+ * body_add_impulse(), and have no other side effects; in particular, it must
+ * not read body shapes, add or remove bodies, or touch the scene.
+ * Force creators that act on the same body still run in the order
+ * they were added, so the results match a single-threaded tick exactly.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param force_creator a force creator function
+ * @param aux an auxiliary value to pass to `force_creator` when it is called
+ * @param bodies the list of bodies affected by the force creator,
+ *   which the scene takes ownership of (see scene_add_force_creator())
+ * @param freer the function to free the aux object if it is not NULL
+ */
+void scene_add_isolated_force_creator(scene_t *scene,
+                                      force_creator_t force_creator,
+                                      void *aux, list_t *bodies,
+                                      free_func_t freer);
+
+/**
+ * Sets the job pool a scene uses to run isolated force creators
+ * (see scene_add_isolated_force_creator()) and integrate its bodies
+ * in parallel during scene_tick(). The scene does not take ownership of the
+ * pool, which must outlive its use by the scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param pool the job pool, or NULL to tick on the calling thread only
+ */
+void scene_set_job_pool(scene_t *scene, job_pool_t *pool);
+
+/**
+ * Enables a uniform-grid broad phase for collisions in a scene.
+ * At the start of each scene_tick(), every body is bucketed into the grid
+ * cells its bounding box touches, and collision force creators skip
+ * pairs of bodies that do not share a cell.
+ * Calling this again replaces the grid with one of the new cell size.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param cell_size the side length of each grid cell
+ */
+void scene_enable_spatial_hash(scene_t *scene, double cell_size);
+
+/**
+ * Returns whether two bodies in a scene may be colliding,
+ * according to the scene's broad phase.
+ * Only meaningful while scene_tick() is running the force creators;
+ * at any other time, or if the broad phase is disabled, returns true.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return false if the bodies are certainly not colliding
+ */
+bool scene_bodies_may_collide(scene_t *scene, body_t *body1, body_t *body2);
+
+/**
+ * Calls a function on every pair of bodies in a scene that may be colliding.
+ * While scene_tick() is running the force creators with the broad phase
+ * enabled, these are the pairs that share a grid cell; otherwise every pair
+ * of bodies is visited. Bodies marked for removal are skipped, including
+ * ones removed by `func` partway through.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param func the function to call on each pair
+ * @param aux an auxiliary value to pass to `func`
+ */
+void scene_for_each_candidate_pair(scene_t *scene, body_pair_func_t func,
+                                   void *aux);
+
+/**
+ * Finds the bodies in a scene whose bounding boxes overlap a region.
+ * With the spatial hash enabled, only bodies in the grid cells the region
+ * touches are examined. The grid is rebuilt at the start of each
+ * scene_tick() and updated with the bodies' new positions at its end;
+ * bodies added since then are searched directly, but a body moved with
+ * body_set_centroid() between ticks is only found at its new position
+ * after the next tick.
+ * Bodies marked for removal are skipped.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param region the region to search
+ * @param results the array to store the bodies found in, in no
+ *   particular order
+ * @param max_results the size of `results`; bodies past it are counted
+ *   but not stored
+ * @return the number of bodies found, which may exceed `max_results`
+ */
+size_t scene_query_aabb(scene_t *scene, aabb_t region, body_t **results,
+                        size_t max_results);
+
+/**
+ * Finds the bodies in a scene that a ray meets, nearest first.
+ * Uses the spatial hash like scene_query_aabb(), walking the cells along
+ * the ray. Bodies marked for removal are skipped.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param origin the start of the ray
+ * @param direction the direction of the ray; must be nonzero
+ * @param max_distance how far along the ray to look; must be finite
+ * @param hits the array to store the nearest hits in
+ * @param max_hits the size of `hits`
+ * @return the number of hits stored, at most `max_hits`
+ */
+size_t scene_raycast(scene_t *scene, vector_t origin, vector_t direction,
+                     double max_distance, raycast_hit_t *hits,
+                     size_t max_hits);
+
+/**
+ * Finds the body in a scene whose centroid is nearest to a point.
+ * Uses the spatial hash like scene_query_aabb(), searching outwards from
+ * the point's cell. Bodies marked for removal are skipped.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param point the point to search from
+ * @param max_distance the largest centroid distance to accept; may be
+ *   INFINITY
+ * @param filter if non-NULL, only bodies it returns true for are considered,
+ *   e.g. bodies of one type
+ * @param aux the auxiliary value to pass to `filter`
+ * @return the nearest matching body, or NULL if there is none
+ */
+body_t *scene_nearest(scene_t *scene, vector_t point, double max_distance,
+                      body_filter_t filter, void *aux);
+
 /**
  * Executes a tick of a given scene over a small time interval.
  * This requires executing all the force creators
  * and then ticking each body (see body_tick()).
  * If any bodies are marked for removal, they are removed from the scene
  * and freed, along with any force creators acting on them.
+ * The remaining bodies keep their relative order, so their indices only
+ * shift down past removed bodies.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param dt the time elapsed since the last tick, in seconds
  */
 void scene_tick(scene_t *scene, double dt);
 
+/**
+ * Moves each body in a scene partway between where it was before the last
+ * scene_tick() and where it is now, to draw a frame that falls between two
+ * fixed-length ticks. The game code run after the tick, like moving a body
+ * directly, counts as part of the tick. A body that jumps should call
+ * body_reset_interpolation() so it is not drawn partway along the jump.
+ * The scene must not be ticked and bodies must not be added or removed
+ * until scene_end_interpolation() is called.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param alpha how far through the next tick the frame falls, from 0 to 1
+ */
+void scene_begin_interpolation(scene_t *scene, double alpha);
+
+/**
+ * Puts each body in a scene back where it was before
+ * scene_begin_interpolation() was called.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+void scene_end_interpolation(scene_t *scene);
+
+/**
+ * Saves which bodies and force creators are in a scene, in what order,
+ * along with each body's state (see body_get_state()), packed into one
+ * array. Bodies already marked for removal are left out, along with the
+ * force creators acting on them.
+ * Until the snapshot is freed, its bodies and force creators are kept
+ * alive: removing them takes them out of the scene without freeing them.
+ * Force creators' aux values are not copied, so any state they hold is
+ * not restored.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return a pointer to the newly allocated snapshot
+ */
+scene_snapshot_t *scene_snapshot(scene_t *scene);
+
+/**
+ * Puts a scene back the way it was when a snapshot was taken.
+ * Bodies and force creators added since are removed and freed, unless
+ * another snapshot holds them. Bodies and force creators removed since are
+ * put back, and handles to the bodies resolve again. Every body is put back
+ * in its old place and state, without interpolating to it.
+ * Putting a removed body back does not return it to the collision groups,
+ * assets and contact queues body_remove() took it out of.
+ * Must not be called while scene_tick() is running.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param snapshot a snapshot of the scene returned from scene_snapshot()
+ */
+void scene_restore(scene_t *scene, scene_snapshot_t *snapshot);
+
+/**
+ * Frees a snapshot, along with any of its bodies and force creators that
+ * have been removed from the scene and are not held by another snapshot.
+ * Every snapshot of a scene must be freed before the scene.
+ *
+ * @param snapshot a snapshot returned from scene_snapshot()
+ */
+void scene_snapshot_free(scene_snapshot_t *snapshot);
+
 /**
  * Releases memory allocated for a given scene
  * and all the bodies and force creators it contains.
+ * Asserts that every snapshot of the scene has been freed.
  *
  * @param scene a pointer to a scene returned from scene_init()
  */
@@ -0,0 +1,177 @@
+#ifndef __SPATIAL_HASH_H__
+#define __SPATIAL_HASH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "body.h"
+
+/**
+ * A uniform grid over the plane used as a collision broad phase.
+ * Each body is bucketed into every cell its bounding box touches,
+ * and two bodies are candidates for collision only if they share a cell.
+ * Bodies too large to bucket efficiently are candidates with every body.
+ */
+typedef struct spatial_hash spatial_hash_t;
+
+/**
+ * Allocates memory for an empty spatial hash.
+ * Asserts that the required memory is allocated.
+ *
+ * @param cell_size the side length of each square grid cell; should be
+ *   around the size of the bodies that collide with each other
+ * @return a pointer to the newly allocated spatial hash
+ */
+spatial_hash_t *spatial_hash_init(double cell_size);
+
+/**
+ * Rebuilds the grid from the current positions of an array of bodies,
+ * recomputing the set of candidate pairs.
+ * Bodies marked for removal are skipped.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param bodies the bodies to index
+ * @param num_bodies the number of bodies
+ */
+void spatial_hash_rebuild(spatial_hash_t *hash, body_t *const *bodies,
+                          size_t num_bodies);
+
+/**
+ * Like spatial_hash_rebuild(), but brings the grid up to date with
+ * spatial_hash_update() instead of building it from scratch.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param bodies the bodies to index
+ * @param num_bodies the number of bodies
+ * @param num_indexed the number of bodies at the start of `bodies` that
+ *   are already in the grid; the rest are added
+ */
+void spatial_hash_refresh(spatial_hash_t *hash, body_t *const *bodies,
+                          size_t num_bodies, size_t num_indexed);
+
+/**
+ * Rebuilds the grid from the current positions of an array of bodies for
+ * region and nearest queries, without recomputing the candidate pairs.
+ * Bodies marked for removal are skipped.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param bodies the bodies to index
+ * @param num_bodies the number of bodies
+ */
+void spatial_hash_index(spatial_hash_t *hash, body_t *const *bodies,
+                        size_t num_bodies);
+
+/**
+ * Brings the grid for region and nearest queries up to date after the
+ * indexed bodies have moved, without recomputing the candidate pairs.
+ * Only the bodies whose bounding boxes now touch other cells are bucketed
+ * again, so this is much cheaper than spatial_hash_index() when most
+ * bodies stay in their cells. Until the next spatial_hash_rebuild(),
+ * every pair is treated as a candidate.
+ * Bodies marked for removal must be dropped with
+ * spatial_hash_remove_marked() before they are freed.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param new_bodies bodies to add that are not indexed yet
+ * @param num_new_bodies the number of new bodies
+ */
+void spatial_hash_update(spatial_hash_t *hash, body_t *const *new_bodies,
+                         size_t num_new_bodies);
+
+/**
+ * Drops the bodies marked for removal from the grid, so they can be freed.
+ * Until the next spatial_hash_rebuild(), every pair is treated as
+ * a candidate.
+ *
+ * @param hash the pointer to the spatial hash
+ */
+void spatial_hash_remove_marked(spatial_hash_t *hash);
+
+/**
+ * Empties the grid, so every pair is treated as a candidate
+ * until the next call to spatial_hash_rebuild().
+ *
+ * @param hash the pointer to the spatial hash
+ */
+void spatial_hash_clear(spatial_hash_t *hash);
+
+/**
+ * Returns whether two bodies may be colliding, i.e. whether they were
+ * a candidate pair in the last rebuild.
+ * Bodies that were not indexed by the last rebuild (including bodies added
+ * since then) always count as candidates, so this never misses a collision.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return false if the bodies are certainly not colliding
+ */
+bool spatial_hash_may_collide(spatial_hash_t *hash, body_t *body1,
+                              body_t *body2);
+
+/**
+ * Gets the number of distinct candidate pairs found by the last rebuild.
+ *
+ * @param hash the pointer to the spatial hash
+ * @return the number of candidate pairs
+ */
+size_t spatial_hash_num_pairs(spatial_hash_t *hash);
+
+/**
+ * Gets one of the candidate pairs found by the last rebuild.
+ * Asserts that the index is valid.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param index the index of the pair, less than spatial_hash_num_pairs()
+ * @param body1 set to the first body of the pair
+ * @param body2 set to the second body of the pair
+ */
+void spatial_hash_get_pair(spatial_hash_t *hash, size_t index, body_t **body1,
+                           body_t **body2);
+
+/**
+ * Finds the indexed bodies whose bounding boxes overlap a region.
+ * Each body is reported once. Bodies marked for removal are skipped.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param region the region to search
+ * @param results the array to store the bodies found in
+ * @param max_results the size of `results`; bodies past it are counted
+ *   but not stored
+ * @return the number of bodies found, which may exceed `max_results`
+ */
+size_t spatial_hash_query_aabb(spatial_hash_t *hash, aabb_t region,
+                               body_t **results, size_t max_results);
+
+/**
+ * Finds the indexed body whose centroid is nearest to a point.
+ * Bodies marked for removal are skipped.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param point the point to search from
+ * @param max_distance the largest centroid distance to accept
+ * @param filter if non-NULL, only bodies it returns true for are considered
+ * @param aux the auxiliary value to pass to `filter`
+ * @return the nearest matching body, or NULL if none is close enough
+ */
+body_t *spatial_hash_nearest(spatial_hash_t *hash, vector_t point,
+                             double max_distance, body_filter_t filter,
+                             void *aux);
+
+/**
+ * Gets the side length of the grid cells.
+ *
+ * @param hash the pointer to the spatial hash
+ * @return the cell size passed to spatial_hash_init()
+ */
+double spatial_hash_cell_size(spatial_hash_t *hash);
+
+/**
+ * Frees memory allocated for a spatial hash.
+ * Does not free the bodies it indexes.
+ *
+ * @param hash the pointer to the spatial hash
+ */
+void spatial_hash_free(spatial_hash_t *hash);
+
+#endif // #ifndef __SPATIAL_HASH_H__
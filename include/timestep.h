@@ -0,0 +1,80 @@
+#ifndef __TIMESTEP_H__
+#define __TIMESTEP_H__
+
+#include <stddef.h>
+
+/**
+ * An accumulator that turns the variable time between frames into a whole
+ * number of fixed-length simulation steps. Frame time that does not make up
+ * a whole step is carried over to the next frame, and the fraction of a step
+ * carried over tells how far to interpolate between the last two steps
+ * when drawing (see scene_begin_interpolation()).
+ */
+typedef struct timestep timestep_t;
+
+/**
+ * Allocates memory for a timestep with no time accumulated.
+ * Asserts that the required memory is allocated.
+ *
+ * @param step the length of each step, in seconds; must be positive
+ * @param max_steps the most steps timestep_advance() returns for one frame;
+ *   must be positive. A frame that would need more drops the time left over,
+ *   so a slow frame slows the simulation down rather than making the next
+ *   frame slower still.
+ * @return a pointer to the newly allocated timestep
+ */
+timestep_t *timestep_init(double step, size_t max_steps);
+
+/**
+ * Adds a frame's time to a timestep and takes as many whole steps out of it
+ * as fit, up to the timestep's maximum.
+ *
+ * @param timestep the pointer to the timestep
+ * @param dt the number of seconds since the last frame
+ * @return the number of steps to simulate this frame
+ */
+size_t timestep_advance(timestep_t *timestep, double dt);
+
+/**
+ * Gets how far the time carried over by a timestep reaches into the next
+ * step.
+ *
+ * @param timestep the pointer to the timestep
+ * @return the fraction of a step carried over, from 0 up to but not
+ *   including 1
+ */
+double timestep_get_alpha(timestep_t *timestep);
+
+/**
+ * Gets the length of each step of a timestep.
+ *
+ * @param timestep the pointer to the timestep
+ * @return the length of each step, in seconds
+ */
+double timestep_get_step(timestep_t *timestep);
+
+/**
+ * Changes the length of each step of a timestep, e.g. to simulate at a
+ * lower rate on a slow machine. Time already carried over is kept.
+ *
+ * @param timestep the pointer to the timestep
+ * @param step the new length of each step, in seconds; must be positive
+ */
+void timestep_set_step(timestep_t *timestep, double step);
+
+/**
+ * Drops the time carried over by a timestep, e.g. after the simulation
+ * has been paused.
+ *
+ * @param timestep the pointer to the timestep
+ */
+void timestep_reset(timestep_t *timestep);
+
+/**
+ * Frees memory allocated for a timestep.
+ *
+ * @param timestep the pointer to the timestep
+ */
+void timestep_free(timestep_t *timestep);
+
+#endif // #ifndef __TIMESTEP_H__
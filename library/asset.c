@@ -10,6 +10,12 @@
 static list_t *ASSET_LIST = NULL;
 const size_t INIT_CAPACITY = 5;
 
+/**
+ * Whether a body has been marked for removal since the last call to
+ * asset_sweep_removed_bodies(), so some assets may need to be destroyed.
+ */
+static bool SWEEP_PENDING = false;
+
 /**
  * Allocates memory for an asset with the given parameters.
  *
@@ -41,7 +47,8 @@ void asset_make_image_with_body(const char *filepath, body_t *body) {
   list_add(ASSET_LIST, (asset_t *)img);
 }
 
-void asset_make_text_with_body(const char *fontpath, body_t *body, char *text, color_t color) {
+text_asset_t *asset_make_text_with_body(const char *fontpath, body_t *body,
+                                        char *text, color_t color) {
   TTF_Font *font = asset_cache_obj_get_or_create(ASSET_TEXT, fontpath);
   assert(font);
   SDL_Rect dummy_bb = {0, 0, 0, 0};
@@ -52,6 +59,7 @@ void asset_make_text_with_body(const char *fontpath, body_t *body, char *text, c
   txt->body = body;
 
   list_add(ASSET_LIST, (asset_t *)txt);
+  return txt;
 }
 
 void asset_make_image(const char *filepath, SDL_Rect bounding_box) {
@@ -84,6 +92,50 @@ void asset_reset_asset_list() {
 
 list_t *asset_get_asset_list() { return ASSET_LIST; }
 
+/**
+ * Gets the body an asset is attached to.
+ *
+ * @param asset the asset
+ * @return the body the asset follows, or NULL if it has a fixed bounding box
+ */
+static body_t *asset_get_body(asset_t *asset) {
+  if (asset->type == ASSET_IMAGE) {
+    return ((image_asset_t *)asset)->body;
+  }
+  return ((text_asset_t *)asset)->body;
+}
+
+void asset_schedule_sweep() { SWEEP_PENDING = true; }
+
+void asset_sweep_removed_bodies() {
+  if (!SWEEP_PENDING || ASSET_LIST == NULL) {
+    SWEEP_PENDING = false;
+    return;
+  }
+  SWEEP_PENDING = false;
+
+  // Empty the list from the back, which never shifts the assets left in it,
+  // then add back the ones to keep in the order they were drawn in
+  size_t size = list_size(ASSET_LIST);
+  if (size == 0) {
+    return;
+  }
+  asset_t **assets = malloc(sizeof(asset_t *) * size);
+  assert(assets);
+  for (size_t i = size; i-- > 0;) {
+    assets[i] = list_remove(ASSET_LIST, i);
+  }
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = asset_get_body(assets[i]);
+    if (body != NULL && body_is_removed(body)) {
+      asset_destroy(assets[i]);
+    } else {
+      list_add(ASSET_LIST, assets[i]);
+    }
+  }
+  free(assets);
+}
+
 
 
 
@@ -128,6 +180,11 @@ void sdl_render_image_ex(SDL_Texture *texture, SDL_Rect *dest, double angle_degr
 }
 
 void asset_render(asset_t *asset) {
+  // A removed body's assets stay in the list until the next sweep
+  body_t *body = asset_get_body(asset);
+  if (body != NULL && body_is_removed(body)) {
+    return;
+  }
   if (asset->type == ASSET_IMAGE) {
     image_asset_t *img = (image_asset_t *)asset;
 
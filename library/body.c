@@ -0,0 +1,1456 @@
+#include "body.h"
+#include "asset.h"
+#include "collision_group.h"
+#include "contact_queue.h"
+#include "pool.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Edges whose normals are closer than this to parallel share one axis.
+ */
+const double AXIS_PARALLEL_EPSILON = 1e-9;
+
+/**
+ * The number of vertices in the polygon drawn for a circle.
+ * Each end of a capsule is drawn with half as many.
+ */
+const size_t ROUND_SHAPE_VERTICES = 16;
+
+/**
+ * Initial number of bodies a body store has room for.
+ */
+const size_t BODY_STORE_INIT_CAPACITY = 16;
+
+/**
+ * The most bodies one job integrates when a store is ticked on a job pool.
+ */
+const size_t BODY_STORE_CHUNK_SIZE = 2048;
+
+const uint32_t BODY_TAG_NONE = UINT32_MAX;
+
+const double BODY_SLEEP_SPEED = 1e-3;
+
+const double BODY_SLEEP_TIME = 0.5;
+
+/**
+ * The number of blocks each body pool allocates from the system at once.
+ */
+const size_t BODY_POOL_BLOCKS_PER_SLAB = 64;
+
+/**
+ * The largest info payload body_info_alloc() can hand out.
+ */
+const size_t BODY_INFO_MAX_SIZE = 32;
+
+/**
+ * The most vertices a block from each vertex pool holds,
+ * starting with BODY_POOL_VERTICES_2.
+ */
+static const size_t VERTEX_POOL_SIZES[] = {2, 4, 8, 16, 32};
+
+/**
+ * The most vertices a block from each prototype vertex pool holds,
+ * starting with BODY_POOL_PROTOTYPE_VERTICES_4.
+ */
+static const size_t PROTOTYPE_VERTEX_POOL_SIZES[] = {4, 8, 16, 32};
+
+/**
+ * Each vertex block holds a body's points, followed by its local axes and
+ * its rotated axes, which need at most one entry per point each.
+ */
+static const size_t VECTORS_PER_VERTEX = 3;
+
+/**
+ * A body built from a shape prototype reads the local axes from the
+ * prototype, so its vertex block only holds its points and rotated axes.
+ */
+static const size_t VECTORS_PER_PROTOTYPE_VERTEX = 2;
+
+/**
+ * Initial number of shape prototypes the registry has room for.
+ */
+const size_t SHAPE_PROTOTYPES_INIT_SIZE = 8;
+
+/**
+ * The pools behind body_init*() and body_info_alloc(), created on first use.
+ * They live for the rest of the program so freed blocks can be reused.
+ */
+static pool_t *BODY_POOLS[NUM_BODY_POOLS];
+
+/**
+ * Every shape prototype still referenced by a body or a caller,
+ * so shape_prototype_get() can hand out an existing one.
+ */
+static list_t *SHAPE_PROTOTYPES = NULL;
+
+struct shape_prototype {
+  // The vertices as they were given, to find the prototype again
+  vector_t *vertices;
+  // The vertices relative to their centroid
+  vector_t *local_points;
+  // Unit edge normals, with parallel edges sharing one entry
+  vector_t *local_axes;
+  size_t num_points;
+  size_t num_axes;
+  vector_t centroid;
+  double area;
+  // The smallest box around local_points
+  aabb_t local_aabb;
+  // The number of bodies and callers holding the prototype
+  size_t refcount;
+};
+
+/**
+ * Where a body is and how it is turned.
+ */
+typedef struct body_pose {
+  vector_t centroid;
+  double rotation;
+} body_pose_t;
+
+struct body_store {
+  // The body in each slot, so a slot can be handed to another body
+  body_t **bodies;
+  vector_t *centroids;
+  vector_t *velocities;
+  vector_t *forces;
+  vector_t *impulses;
+  double *masses;
+  double *rotations;
+  // How long each awake dynamic body has been at rest, in seconds
+  double *rest_times;
+  // Each body's pose as of the last body_store_save_poses()
+  body_pose_t *previous_poses;
+  // Each body's pose after its last tick, while an interpolated pose is
+  // shown in its place
+  body_pose_t *stepped_poses;
+  bool interpolating;
+  // The slots are grouped by how body_store_tick() treats them: awake
+  // dynamic bodies first, then kinematic bodies, then static and sleeping
+  // bodies, which it skips
+  size_t num_awake;
+  size_t num_kinematic;
+  size_t size;
+  size_t capacity;
+};
+
+struct body {
+  shape_type_t shape_type;
+  // The shared shape the body was built from, or NULL if it owns its shape
+  shape_prototype_t *prototype;
+  // The polygon's vertices, or a circle's center, or a capsule's segment.
+  // NULL for a body built from a prototype until its points are first read.
+  vector_t *points;
+  size_t num_points;
+  // The centroid and rotation the points and axes currently reflect.
+  // Moving or rotating a body only changes its centroid or rotation;
+  // the points and axes catch up when next read.
+  vector_t points_centroid;
+  double points_rotation;
+  // A circle's or capsule's polygon outline, built the first time it is
+  // read, or NULL for polygons and until then
+  vector_t *outline;
+  size_t num_outline;
+  // Whether outline must be rebuilt from the points before it is read
+  bool outline_dirty;
+  // How far the shape extends around the points; 0 for polygons
+  double radius;
+  // Unit edge normals at rotation 0, with parallel edges sharing one entry
+  vector_t *local_axes;
+  // local_axes rotated by the body's current rotation
+  vector_t *axes;
+  size_t num_axes;
+  aabb_t aabb;
+  // Whether aabb must be recomputed from the points before it is read
+  bool aabb_dirty;
+  double area;
+  color_t color;
+  uint32_t category;
+  uint32_t collision_mask;
+  uint32_t tag;
+  // The store holding the motion state below, or NULL while the body is
+  // not in one, and the body's slot in it
+  body_store_t *store;
+  size_t slot;
+  vector_t centroid;
+  vector_t velocity;
+  vector_t force;
+  vector_t impulse;
+  double mass;
+  double rotation;
+  body_motion_t motion;
+  // Whether the body is dynamic and has been put to sleep by its store
+  bool sleeping;
+  bool removed;
+  void *info;
+  free_func_t info_freer;
+};
+
+/**
+ * Computes the signed area of a polygon with the shoelace formula.
+ *
+ * @param points the vertices of the polygon in counterclockwise order
+ * @param size the number of vertices
+ * @return the area of the polygon
+ */
+static double calculate_area(const vector_t *points, size_t size) {
+  double sum = 0;
+  for (size_t i = 0; i < size; i++) {
+    sum += vec_cross(points[i], points[(i + 1) % size]);
+  }
+  return sum * 0.5;
+}
+
+/**
+ * Computes the center of mass of a polygon with uniform density.
+ *
+ * @param points the vertices of the polygon in counterclockwise order
+ * @param size the number of vertices
+ * @param area the area of the polygon
+ * @return the centroid of the polygon
+ */
+static vector_t calculate_centroid(const vector_t *points, size_t size,
+                                   double area) {
+  double sumx = 0;
+  double sumy = 0;
+  for (size_t i = 0; i < size; i++) {
+    vector_t v1 = points[i];
+    vector_t v2 = points[(i + 1) % size];
+    double cross = vec_cross(v1, v2);
+    sumx += (v1.x + v2.x) * cross;
+    sumy += (v1.y + v2.y) * cross;
+  }
+  return (vector_t){.x = sumx / (6 * area), .y = sumy / (6 * area)};
+}
+
+/**
+ * Computes the unit edge normals of a polygon, keeping one normal for each
+ * set of parallel edges since they define the same separating axis.
+ *
+ * @param points the vertices of the polygon in counterclockwise order
+ * @param size the number of vertices
+ * @param axes an array of at least `size` vectors to store the normals in
+ * @return the number of distinct normals stored
+ */
+static size_t calculate_axes(const vector_t *points, size_t size,
+                             vector_t *axes) {
+  size_t num_axes = 0;
+  for (size_t i = 0; i < size; i++) {
+    vector_t edge = vec_subtract(points[i], points[(i + 1) % size]);
+    vector_t axis = {.x = -edge.y, .y = edge.x};
+    double len = vec_get_length(axis);
+    if (len == 0) {
+      continue;
+    }
+    axis = vec_multiply(1.0 / len, axis);
+
+    bool duplicate = false;
+    for (size_t j = 0; j < num_axes; j++) {
+      if (fabs(vec_cross(axes[j], axis)) < AXIS_PARALLEL_EPSILON) {
+        duplicate = true;
+        break;
+      }
+    }
+    if (!duplicate) {
+      axes[num_axes++] = axis;
+    }
+  }
+  return num_axes;
+}
+
+/**
+ * Computes the axis-aligned bounding box of a set of points.
+ *
+ * @param points the vertices of the polygon
+ * @param size the number of vertices
+ * @return the smallest box containing every point
+ */
+static aabb_t calculate_aabb(const vector_t *points, size_t size) {
+  aabb_t aabb = {.min = {__DBL_MAX__, __DBL_MAX__},
+                 .max = {-__DBL_MAX__, -__DBL_MAX__}};
+  for (size_t i = 0; i < size; i++) {
+    aabb.min.x = fmin(aabb.min.x, points[i].x);
+    aabb.min.y = fmin(aabb.min.y, points[i].y);
+    aabb.max.x = fmax(aabb.max.x, points[i].x);
+    aabb.max.y = fmax(aabb.max.y, points[i].y);
+  }
+  return aabb;
+}
+
+/**
+ * Gets how many vectors a block from a vertex pool holds.
+ *
+ * @param kind a vertex pool
+ * @return the number of vectors in each of its blocks
+ */
+static size_t vertex_pool_vectors(body_pool_t kind) {
+  if (kind >= BODY_POOL_PROTOTYPE_VERTICES_4) {
+    return VECTORS_PER_PROTOTYPE_VERTEX *
+           PROTOTYPE_VERTEX_POOL_SIZES[kind - BODY_POOL_PROTOTYPE_VERTICES_4];
+  }
+  return VECTORS_PER_VERTEX * VERTEX_POOL_SIZES[kind - BODY_POOL_VERTICES_2];
+}
+
+/**
+ * Gets one of the body pools, creating it on first use.
+ *
+ * @param kind which pool to get
+ * @return the pool
+ */
+static pool_t *get_pool(body_pool_t kind) {
+  if (BODY_POOLS[kind] == NULL) {
+    size_t block_size;
+    switch (kind) {
+    case BODY_POOL_BODIES:
+      block_size = sizeof(body_t);
+      break;
+    case BODY_POOL_INFO:
+      block_size = BODY_INFO_MAX_SIZE;
+      break;
+    default:
+      block_size = sizeof(vector_t) * vertex_pool_vectors(kind);
+      break;
+    }
+    BODY_POOLS[kind] = pool_init(block_size, BODY_POOL_BLOCKS_PER_SLAB);
+  }
+  return BODY_POOLS[kind];
+}
+
+/**
+ * Finds the vertex pool whose blocks fit a number of vectors.
+ *
+ * @param num_vectors the number of vectors in the block
+ * @return the fitting vertex pool with the smallest blocks, or
+ *   NUM_BODY_POOLS if the block is too big for any of them
+ */
+static body_pool_t vertex_pool_for(size_t num_vectors) {
+  body_pool_t best = NUM_BODY_POOLS;
+  for (body_pool_t kind = BODY_POOL_VERTICES_2; kind < NUM_BODY_POOLS;
+       kind++) {
+    size_t vectors = vertex_pool_vectors(kind);
+    if (num_vectors <= vectors &&
+        (best == NUM_BODY_POOLS || vectors < vertex_pool_vectors(best))) {
+      best = kind;
+    }
+  }
+  return best;
+}
+
+/**
+ * Allocates a block for a shape's points and axes, or for a round shape's
+ * outline, from a vertex pool if one fits and from the system otherwise.
+ *
+ * @param num_vectors the number of vectors the block must hold
+ * @return room for num_vectors vectors
+ */
+static vector_t *vertex_block_alloc(size_t num_vectors) {
+  body_pool_t kind = vertex_pool_for(num_vectors);
+  if (kind == NUM_BODY_POOLS) {
+    vector_t *block = malloc(sizeof(vector_t) * num_vectors);
+    assert(block);
+    return block;
+  }
+  return pool_alloc(get_pool(kind));
+}
+
+/**
+ * Frees a block returned by vertex_block_alloc().
+ *
+ * @param block the block
+ * @param num_vectors the number of vectors it was allocated for
+ */
+static void vertex_block_release(vector_t *block, size_t num_vectors) {
+  body_pool_t kind = vertex_pool_for(num_vectors);
+  if (kind == NUM_BODY_POOLS) {
+    free(block);
+  } else {
+    pool_release(get_pool(kind), block);
+  }
+}
+
+/**
+ * Gets where a body's centroid is stored.
+ *
+ * @param body the body
+ * @return the body's slot in its store's array, or its own field if it is
+ *   not in a store
+ */
+static vector_t *centroid_ref(body_t *body) {
+  return body->store == NULL ? &body->centroid
+                             : &body->store->centroids[body->slot];
+}
+
+/**
+ * Gets where a body's velocity is stored. See centroid_ref().
+ */
+static vector_t *velocity_ref(body_t *body) {
+  return body->store == NULL ? &body->velocity
+                             : &body->store->velocities[body->slot];
+}
+
+/**
+ * Gets where a body's accumulated force is stored. See centroid_ref().
+ */
+static vector_t *force_ref(body_t *body) {
+  return body->store == NULL ? &body->force
+                             : &body->store->forces[body->slot];
+}
+
+/**
+ * Gets where a body's accumulated impulse is stored. See centroid_ref().
+ */
+static vector_t *impulse_ref(body_t *body) {
+  return body->store == NULL ? &body->impulse
+                             : &body->store->impulses[body->slot];
+}
+
+/**
+ * Gets where a body's mass is stored. See centroid_ref().
+ */
+static double *mass_ref(body_t *body) {
+  return body->store == NULL ? &body->mass : &body->store->masses[body->slot];
+}
+
+/**
+ * Gets where a body's rotation is stored. See centroid_ref().
+ */
+static double *rotation_ref(body_t *body) {
+  return body->store == NULL ? &body->rotation
+                             : &body->store->rotations[body->slot];
+}
+
+/**
+ * Rotates a body's points about the centroid they are placed around,
+ * and its axes, from the rotation they reflect to a new one.
+ *
+ * @param body the body
+ * @param angle the new rotation, in radians
+ */
+static void rotate_points(body_t *body, double angle) {
+  double delta = angle - body->points_rotation;
+  double cos_delta = cos(delta);
+  double sin_delta = sin(delta);
+  for (size_t i = 0; i < body->num_points; i++) {
+    vector_t offset = vec_subtract(body->points[i], body->points_centroid);
+    vector_t rotated = {.x = offset.x * cos_delta - offset.y * sin_delta,
+                        .y = offset.x * sin_delta + offset.y * cos_delta};
+    body->points[i] = vec_add(body->points_centroid, rotated);
+  }
+  body->aabb_dirty = true;
+  body->outline_dirty = true;
+
+  // Axis-aligned bodies reuse the local axes as they are
+  if (angle == 0) {
+    for (size_t i = 0; i < body->num_axes; i++) {
+      body->axes[i] = body->local_axes[i];
+    }
+  } else {
+    double cos_angle = cos(angle);
+    double sin_angle = sin(angle);
+    for (size_t i = 0; i < body->num_axes; i++) {
+      vector_t local = body->local_axes[i];
+      body->axes[i] =
+          (vector_t){.x = local.x * cos_angle - local.y * sin_angle,
+                     .y = local.x * sin_angle + local.y * cos_angle};
+    }
+  }
+  body->points_rotation = angle;
+}
+
+/**
+ * Gives a body built from a shape prototype its own points, placed around
+ * its current centroid at rotation 0, and unrotated axes.
+ *
+ * @param body a body built from a prototype whose points are NULL
+ */
+static void place_prototype_points(body_t *body) {
+  shape_prototype_t *prototype = body->prototype;
+  size_t num_points = prototype->num_points;
+  body->points =
+      vertex_block_alloc(VECTORS_PER_PROTOTYPE_VERTEX * num_points);
+  body->axes = body->points + num_points;
+  vector_t centroid = *centroid_ref(body);
+  for (size_t i = 0; i < num_points; i++) {
+    body->points[i] = vec_add(centroid, prototype->local_points[i]);
+  }
+  for (size_t i = 0; i < body->num_axes; i++) {
+    body->axes[i] = body->local_axes[i];
+  }
+  body->points_centroid = centroid;
+  body->points_rotation = 0;
+  body->aabb_dirty = true;
+}
+
+/**
+ * Brings a body's points and axes up to its current centroid and rotation
+ * if either has changed since they were last placed. Must be called before
+ * the points or axes are read.
+ *
+ * @param body the body
+ */
+static void sync_points(body_t *body) {
+  if (body->points == NULL) {
+    place_prototype_points(body);
+  }
+  vector_t centroid = *centroid_ref(body);
+  if (centroid.x != body->points_centroid.x ||
+      centroid.y != body->points_centroid.y) {
+    vector_t translation = vec_subtract(centroid, body->points_centroid);
+    for (size_t i = 0; i < body->num_points; i++) {
+      body->points[i] = vec_add(body->points[i], translation);
+    }
+    // A translated box or outline keeps its shape, so it can be shifted
+    // instead of rebuilt
+    if (!body->aabb_dirty) {
+      body->aabb.min = vec_add(body->aabb.min, translation);
+      body->aabb.max = vec_add(body->aabb.max, translation);
+    }
+    if (!body->outline_dirty) {
+      for (size_t i = 0; i < body->num_outline; i++) {
+        body->outline[i] = vec_add(body->outline[i], translation);
+      }
+    }
+    body->points_centroid = centroid;
+  }
+
+  double rotation = *rotation_ref(body);
+  if (rotation != body->points_rotation) {
+    rotate_points(body, rotation);
+  }
+}
+
+/**
+ * Advances one body's motion state by a time step, applying and clearing
+ * its accumulated force and impulse. Shared by body_tick() and
+ * body_store_tick() so both integrate identically.
+ *
+ * @param dt the time step
+ * @param mass the body's mass
+ * @param centroid the body's centroid, updated in place
+ * @param velocity the body's velocity, updated in place
+ * @param force the body's accumulated force, cleared
+ * @param impulse the body's accumulated impulse, cleared
+ */
+static inline void integrate(double dt, double mass, vector_t *centroid,
+                             vector_t *velocity, vector_t *force,
+                             vector_t *impulse) {
+  // Written out per component so the store's loop can be vectorized
+  double force_scale = dt / mass;
+  double impulse_scale = 1.0 / mass;
+  vector_t old_velocity = *velocity;
+  vector_t new_velocity = {.x = old_velocity.x + force_scale * force->x +
+                                 impulse_scale * impulse->x,
+                           .y = old_velocity.y + force_scale * force->y +
+                                 impulse_scale * impulse->y};
+  centroid->x += dt * (0.5 * (old_velocity.x + new_velocity.x));
+  centroid->y += dt * (0.5 * (old_velocity.y + new_velocity.y));
+  *velocity = new_velocity;
+  *force = VEC_ZERO;
+  *impulse = VEC_ZERO;
+}
+
+/**
+ * Initializes the parts of a new body that do not depend on its shape.
+ * The body's centroid must already be set.
+ *
+ * @param body the body
+ * @param mass the mass of the body
+ * @param color the color of the body
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ */
+static void init_body_state(body_t *body, double mass, color_t color,
+                            void *info, free_func_t info_freer) {
+  body->points_centroid = body->centroid;
+  body->points_rotation = 0;
+  body->outline = NULL;
+  body->num_outline = 0;
+  body->outline_dirty = true;
+  body->aabb_dirty = true;
+  body->store = NULL;
+  body->slot = 0;
+  body->mass = mass;
+  body->color = color;
+  body->category = 0;
+  body->collision_mask = 0;
+  body->tag = BODY_TAG_NONE;
+  body->velocity = VEC_ZERO;
+  body->force = VEC_ZERO;
+  body->impulse = VEC_ZERO;
+  body->rotation = 0;
+  body->motion = BODY_DYNAMIC;
+  body->sleeping = false;
+  body->removed = false;
+  body->info = info;
+  body->info_freer = info_freer;
+}
+
+/**
+ * Allocates a body around a vertex block holding its core points, which it
+ * takes ownership of. The area and centroid are computed for the shape type.
+ *
+ * @param shape_type the kind of collider shape
+ * @param points a block from vertex_block_alloc() starting with the
+ *   polygon's vertices, a circle's center, or a capsule's two segment ends
+ * @param num_points the number of points
+ * @param radius the radius around the points; 0 for polygons
+ * @param mass the mass of the body
+ * @param color the color of the body
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the newly allocated body
+ */
+static body_t *body_alloc(shape_type_t shape_type, vector_t *points,
+                          size_t num_points, double radius, double mass,
+                          color_t color, void *info, free_func_t info_freer) {
+  body_t *body = pool_alloc(get_pool(BODY_POOL_BODIES));
+  body->shape_type = shape_type;
+  body->prototype = NULL;
+  body->points = points;
+  body->num_points = num_points;
+  body->radius = radius;
+
+  body->local_axes = points + num_points;
+  body->axes = body->local_axes + num_points;
+  // A circle has no edges; a capsule's two "edges" share the segment normal
+  body->num_axes = shape_type == SHAPE_CIRCLE
+                       ? 0
+                       : calculate_axes(points, num_points, body->local_axes);
+  for (size_t i = 0; i < body->num_axes; i++) {
+    body->axes[i] = body->local_axes[i];
+  }
+
+  switch (shape_type) {
+  case SHAPE_POLYGON:
+    body->area = calculate_area(points, num_points);
+    body->centroid = calculate_centroid(points, num_points, body->area);
+    break;
+  case SHAPE_CIRCLE:
+    body->area = M_PI * radius * radius;
+    body->centroid = points[0];
+    break;
+  case SHAPE_CAPSULE: {
+    double length = vec_get_length(vec_subtract(points[1], points[0]));
+    body->area = M_PI * radius * radius + 2 * radius * length;
+    body->centroid = vec_multiply(0.5, vec_add(points[0], points[1]));
+    break;
+  }
+  }
+
+  init_body_state(body, mass, color, info, info_freer);
+  return body;
+}
+
+bool aabb_overlaps(aabb_t aabb1, aabb_t aabb2) {
+  return aabb1.min.x <= aabb2.max.x && aabb2.min.x <= aabb1.max.x &&
+         aabb1.min.y <= aabb2.max.y && aabb2.min.y <= aabb1.max.y;
+}
+
+body_t *body_init(list_t *shape, double mass, color_t color) {
+  return body_init_with_info(shape, mass, color, NULL, NULL);
+}
+
+body_t *body_init_with_info(list_t *shape, double mass, color_t color,
+                            void *info, free_func_t info_freer) {
+  // Copy the vertices into one contiguous array so collision checks can
+  // read them in place instead of copying the shape.
+  size_t num_points = list_size(shape);
+  vector_t *points = vertex_block_alloc(VECTORS_PER_VERTEX * num_points);
+  for (size_t i = 0; i < num_points; i++) {
+    points[i] = *(vector_t *)list_get(shape, i);
+  }
+  list_free(shape);
+  return body_alloc(SHAPE_POLYGON, points, num_points, 0, mass, color, info,
+                    info_freer);
+}
+
+body_t *body_init_polygon(const vector_t *vertices, size_t num_vertices,
+                          double mass, color_t color, void *info,
+                          free_func_t info_freer) {
+  vector_t *points = vertex_block_alloc(VECTORS_PER_VERTEX * num_vertices);
+  memcpy(points, vertices, sizeof(vector_t) * num_vertices);
+  return body_alloc(SHAPE_POLYGON, points, num_vertices, 0, mass, color, info,
+                    info_freer);
+}
+
+body_t *body_init_circle(vector_t center, double radius, double mass,
+                         color_t color, void *info, free_func_t info_freer) {
+  assert(radius > 0);
+  vector_t *points = vertex_block_alloc(VECTORS_PER_VERTEX);
+  points[0] = center;
+  return body_alloc(SHAPE_CIRCLE, points, 1, radius, mass, color, info,
+                    info_freer);
+}
+
+body_t *body_init_capsule(vector_t start, vector_t end, double radius,
+                          double mass, color_t color, void *info,
+                          free_func_t info_freer) {
+  assert(radius > 0);
+  // A capsule with no length has no segment normal; use a circle instead
+  assert(start.x != end.x || start.y != end.y);
+  vector_t *points = vertex_block_alloc(VECTORS_PER_VERTEX * 2);
+  points[0] = start;
+  points[1] = end;
+  return body_alloc(SHAPE_CAPSULE, points, 2, radius, mass, color, info,
+                    info_freer);
+}
+
+shape_prototype_t *shape_prototype_get(const vector_t *vertices,
+                                       size_t num_vertices) {
+  if (SHAPE_PROTOTYPES == NULL) {
+    SHAPE_PROTOTYPES = list_init(SHAPE_PROTOTYPES_INIT_SIZE, NULL);
+  }
+  size_t num_prototypes = list_size(SHAPE_PROTOTYPES);
+  for (size_t i = 0; i < num_prototypes; i++) {
+    shape_prototype_t *prototype = list_get(SHAPE_PROTOTYPES, i);
+    if (prototype->num_points == num_vertices &&
+        memcmp(prototype->vertices, vertices,
+               sizeof(vector_t) * num_vertices) == 0) {
+      prototype->refcount++;
+      return prototype;
+    }
+  }
+
+  shape_prototype_t *prototype = malloc(sizeof(shape_prototype_t));
+  assert(prototype);
+  // One block for the given vertices, the local points and the local axes
+  prototype->vertices = malloc(sizeof(vector_t) * 3 * num_vertices);
+  assert(prototype->vertices);
+  prototype->local_points = prototype->vertices + num_vertices;
+  prototype->local_axes = prototype->local_points + num_vertices;
+  memcpy(prototype->vertices, vertices, sizeof(vector_t) * num_vertices);
+  prototype->num_points = num_vertices;
+  prototype->area = calculate_area(vertices, num_vertices);
+  prototype->centroid =
+      calculate_centroid(vertices, num_vertices, prototype->area);
+  for (size_t i = 0; i < num_vertices; i++) {
+    prototype->local_points[i] =
+        vec_subtract(vertices[i], prototype->centroid);
+  }
+  prototype->num_axes =
+      calculate_axes(vertices, num_vertices, prototype->local_axes);
+  prototype->local_aabb =
+      calculate_aabb(prototype->local_points, num_vertices);
+  prototype->refcount = 1;
+  list_add(SHAPE_PROTOTYPES, prototype);
+  return prototype;
+}
+
+void shape_prototype_release(shape_prototype_t *prototype) {
+  assert(prototype->refcount > 0);
+  if (--prototype->refcount > 0) {
+    return;
+  }
+  size_t num_prototypes = list_size(SHAPE_PROTOTYPES);
+  for (size_t i = 0; i < num_prototypes; i++) {
+    if (list_get(SHAPE_PROTOTYPES, i) == prototype) {
+      list_remove(SHAPE_PROTOTYPES, i);
+      break;
+    }
+  }
+  free(prototype->vertices);
+  free(prototype);
+}
+
+size_t shape_prototype_count(void) {
+  return SHAPE_PROTOTYPES == NULL ? 0 : list_size(SHAPE_PROTOTYPES);
+}
+
+body_t *body_init_from_prototype(shape_prototype_t *prototype, double mass,
+                                 color_t color, void *info,
+                                 free_func_t info_freer) {
+  prototype->refcount++;
+  body_t *body = pool_alloc(get_pool(BODY_POOL_BODIES));
+  body->shape_type = SHAPE_POLYGON;
+  body->prototype = prototype;
+  // The points are only placed once they are read; until then the body
+  // is just a transform over the prototype
+  body->points = NULL;
+  body->num_points = prototype->num_points;
+  body->radius = 0;
+  body->local_axes = prototype->local_axes;
+  body->axes = NULL;
+  body->num_axes = prototype->num_axes;
+  body->area = prototype->area;
+  body->centroid = prototype->centroid;
+  init_body_state(body, mass, color, info, info_freer);
+  return body;
+}
+
+void *body_get_info(body_t *body) { return body->info; }
+
+/**
+ * Fills in the vertices of an arc around a center,
+ * counterclockwise from `start_angle`, including both ends.
+ *
+ * @param vertices where to write the vertices
+ * @param center the center of the arc
+ * @param radius the radius of the arc
+ * @param start_angle the angle of the first vertex, in radians
+ * @param sweep the angle covered by the arc, in radians
+ * @param num_vertices the number of vertices to write; at least 2
+ */
+static void fill_arc(vector_t *vertices, vector_t center, double radius,
+                     double start_angle, double sweep, size_t num_vertices) {
+  for (size_t i = 0; i < num_vertices; i++) {
+    double angle = start_angle + sweep * i / (num_vertices - 1);
+    vertices[i] = (vector_t){.x = center.x + radius * cos(angle),
+                             .y = center.y + radius * sin(angle)};
+  }
+}
+
+/**
+ * Rebuilds the polygon approximating a circle's or capsule's outline
+ * around its current points, allocating it the first time.
+ *
+ * @param body a circle or capsule whose points are in sync
+ */
+static void build_outline(body_t *body) {
+  // Each end of a capsule is a half circle facing away from the other end
+  size_t cap_vertices = ROUND_SHAPE_VERTICES / 2 + 1;
+  if (body->outline == NULL) {
+    body->num_outline = body->shape_type == SHAPE_CIRCLE
+                            ? ROUND_SHAPE_VERTICES
+                            : 2 * cap_vertices;
+    body->outline = vertex_block_alloc(body->num_outline);
+  }
+  if (body->shape_type == SHAPE_CIRCLE) {
+    double step = 2 * M_PI / ROUND_SHAPE_VERTICES;
+    fill_arc(body->outline, body->points[0], body->radius, 0,
+             2 * M_PI - step, ROUND_SHAPE_VERTICES);
+  } else {
+    vector_t dir = vec_subtract(body->points[1], body->points[0]);
+    double angle = atan2(dir.y, dir.x);
+    fill_arc(body->outline, body->points[1], body->radius,
+             angle - M_PI / 2, M_PI, cap_vertices);
+    fill_arc(body->outline + cap_vertices, body->points[0], body->radius,
+             angle + M_PI / 2, M_PI, cap_vertices);
+  }
+  body->outline_dirty = false;
+}
+
+shape_view_t body_get_shape_view(body_t *body) {
+  sync_points(body);
+  if (body->shape_type == SHAPE_POLYGON) {
+    return (shape_view_t){.vertices = body->points,
+                          .num_vertices = body->num_points};
+  }
+  if (body->outline_dirty) {
+    build_outline(body);
+  }
+  return (shape_view_t){.vertices = body->outline,
+                        .num_vertices = body->num_outline};
+}
+
+list_t *body_get_shape(body_t *body) {
+  shape_view_t view = body_get_shape_view(body);
+  list_t *shape = list_init(view.num_vertices, free);
+  for (size_t i = 0; i < view.num_vertices; i++) {
+    vector_t *vec = malloc(sizeof(vector_t));
+    assert(vec);
+    *vec = view.vertices[i];
+    list_add(shape, vec);
+  }
+  return shape;
+}
+
+shape_type_t body_get_shape_type(body_t *body) { return body->shape_type; }
+
+double body_get_radius(body_t *body) { return body->radius; }
+
+size_t body_num_vertices(body_t *body) { return body->num_points; }
+
+vector_t body_get_vertex(body_t *body, size_t index) {
+  assert(index < body->num_points);
+  sync_points(body);
+  return body->points[index];
+}
+
+const vector_t *body_get_vertices(body_t *body) {
+  sync_points(body);
+  return body->points;
+}
+
+size_t body_num_axes(body_t *body) { return body->num_axes; }
+
+vector_t body_get_axis(body_t *body, size_t index) {
+  assert(index < body->num_axes);
+  sync_points(body);
+  return body->axes[index];
+}
+
+aabb_t body_get_aabb(body_t *body) {
+  // An unrotated prototype body's box is the prototype's, moved into place,
+  // so it does not need points of its own to answer
+  if (body->points == NULL && *rotation_ref(body) == 0) {
+    vector_t centroid = *centroid_ref(body);
+    aabb_t local = body->prototype->local_aabb;
+    return (aabb_t){.min = vec_add(centroid, local.min),
+                    .max = vec_add(centroid, local.max)};
+  }
+  sync_points(body);
+  if (body->aabb_dirty) {
+    body->aabb = calculate_aabb(body->points, body->num_points);
+    body->aabb.min.x -= body->radius;
+    body->aabb.min.y -= body->radius;
+    body->aabb.max.x += body->radius;
+    body->aabb.max.y += body->radius;
+    body->aabb_dirty = false;
+  }
+  return body->aabb;
+}
+
+vector_t body_get_centroid(body_t *body) { return *centroid_ref(body); }
+
+void body_set_centroid(body_t *body, vector_t x) { *centroid_ref(body) = x; }
+
+vector_t body_get_velocity(body_t *body) { return *velocity_ref(body); }
+
+void body_set_velocity(body_t *body, vector_t v) {
+  if (v.x != 0 || v.y != 0) {
+    body_wake(body);
+  }
+  *velocity_ref(body) = v;
+}
+
+double body_area(body_t *body) { return body->area; }
+
+color_t body_get_color(body_t *body) { return body->color; }
+
+void body_set_color(body_t *body, color_t color) { body->color = color; }
+
+uint32_t body_get_category(body_t *body) { return body->category; }
+
+uint32_t body_get_collision_mask(body_t *body) { return body->collision_mask; }
+
+void body_set_collision_filter(body_t *body, uint32_t category,
+                               uint32_t mask) {
+  body->category = category;
+  body->collision_mask = mask;
+}
+
+uint32_t body_get_tag(body_t *body) { return body->tag; }
+
+void body_set_tag(body_t *body, uint32_t tag) {
+  // Scenes bucket bodies by tag when they are added
+  assert(body->store == NULL);
+  body->tag = tag;
+}
+
+double body_get_rotation(body_t *body) { return *rotation_ref(body); }
+
+void body_set_rotation(body_t *body, double angle) {
+  // The points and axes are rotated when next read, so a body rotated
+  // several times between reads is only rotated once
+  *rotation_ref(body) = angle;
+}
+
+/**
+ * The ranges of slots in a body store, in the order they are laid out.
+ */
+typedef enum {
+  STORE_RANGE_AWAKE,
+  STORE_RANGE_KINEMATIC,
+  STORE_RANGE_INACTIVE,
+} store_range_t;
+
+/**
+ * Gets which range of its store's slots a body belongs in.
+ *
+ * @param body the body
+ * @return the range for the body's motion class and sleep state
+ */
+static store_range_t store_range_of(body_t *body) {
+  if (body->motion == BODY_KINEMATIC) {
+    return STORE_RANGE_KINEMATIC;
+  }
+  return body->motion == BODY_DYNAMIC && !body->sleeping
+             ? STORE_RANGE_AWAKE
+             : STORE_RANGE_INACTIVE;
+}
+
+/**
+ * Swaps the contents of two slots of a body store.
+ *
+ * @param store the pointer to the store
+ * @param i the index of one slot
+ * @param j the index of the other slot
+ */
+static void store_swap(body_store_t *store, size_t i, size_t j) {
+  if (i == j) {
+    return;
+  }
+  body_t *body = store->bodies[i];
+  store->bodies[i] = store->bodies[j];
+  store->bodies[j] = body;
+  store->bodies[i]->slot = i;
+  store->bodies[j]->slot = j;
+  vector_t centroid = store->centroids[i];
+  store->centroids[i] = store->centroids[j];
+  store->centroids[j] = centroid;
+  vector_t velocity = store->velocities[i];
+  store->velocities[i] = store->velocities[j];
+  store->velocities[j] = velocity;
+  vector_t force = store->forces[i];
+  store->forces[i] = store->forces[j];
+  store->forces[j] = force;
+  vector_t impulse = store->impulses[i];
+  store->impulses[i] = store->impulses[j];
+  store->impulses[j] = impulse;
+  double mass = store->masses[i];
+  store->masses[i] = store->masses[j];
+  store->masses[j] = mass;
+  double rotation = store->rotations[i];
+  store->rotations[i] = store->rotations[j];
+  store->rotations[j] = rotation;
+  double rest_time = store->rest_times[i];
+  store->rest_times[i] = store->rest_times[j];
+  store->rest_times[j] = rest_time;
+  body_pose_t previous_pose = store->previous_poses[i];
+  store->previous_poses[i] = store->previous_poses[j];
+  store->previous_poses[j] = previous_pose;
+}
+
+/**
+ * Moves a body in a store from one range of slots to another,
+ * one range boundary at a time, by swapping it with the slot at the
+ * boundary and moving the boundary past it.
+ *
+ * @param body a body in a store
+ * @param from the range the body is in
+ * @param to the range the body belongs in
+ */
+static void store_move(body_t *body, store_range_t from, store_range_t to) {
+  body_store_t *store = body->store;
+  for (; from < to; from++) {
+    if (from == STORE_RANGE_AWAKE) {
+      store_swap(store, body->slot, store->num_awake - 1);
+      store->num_awake--;
+      store->num_kinematic++;
+    } else {
+      store_swap(store, body->slot,
+                 store->num_awake + store->num_kinematic - 1);
+      store->num_kinematic--;
+    }
+  }
+  for (; from > to; from--) {
+    if (from == STORE_RANGE_KINEMATIC) {
+      store_swap(store, body->slot, store->num_awake);
+      store->num_awake++;
+      store->num_kinematic--;
+    } else {
+      store_swap(store, body->slot, store->num_awake + store->num_kinematic);
+      store->num_kinematic++;
+    }
+  }
+  store->rest_times[body->slot] = 0;
+}
+
+/**
+ * Changes a body's motion class and sleep state, moving it to the matching
+ * range of its store if it is in one.
+ *
+ * @param body the body
+ * @param motion the new motion class
+ * @param sleeping whether the body is now asleep; only dynamic bodies sleep
+ */
+static void set_motion_state(body_t *body, body_motion_t motion,
+                             bool sleeping) {
+  store_range_t from = store_range_of(body);
+  body->motion = motion;
+  body->sleeping = sleeping;
+  if (body->store != NULL) {
+    store_move(body, from, store_range_of(body));
+  }
+}
+
+void body_set_motion(body_t *body, body_motion_t motion) {
+  if (motion != BODY_DYNAMIC) {
+    // Only dynamic bodies respond to forces and impulses
+    *force_ref(body) = VEC_ZERO;
+    *impulse_ref(body) = VEC_ZERO;
+  }
+  set_motion_state(body, motion, false);
+}
+
+body_motion_t body_get_motion(body_t *body) { return body->motion; }
+
+bool body_is_sleeping(body_t *body) { return body->sleeping; }
+
+void body_reset_interpolation(body_t *body) {
+  body_store_t *store = body->store;
+  if (store != NULL) {
+    assert(!store->interpolating);
+    store->previous_poses[body->slot] = (body_pose_t){
+        .centroid = *centroid_ref(body), .rotation = *rotation_ref(body)};
+  }
+}
+
+void body_wake(body_t *body) {
+  if (body->sleeping) {
+    set_motion_state(body, body->motion, false);
+  }
+}
+
+void body_tick(body_t *body, double dt) {
+  switch (body->motion) {
+  case BODY_DYNAMIC:
+    if (!body->sleeping) {
+      integrate(dt, *mass_ref(body), centroid_ref(body), velocity_ref(body),
+                force_ref(body), impulse_ref(body));
+    }
+    break;
+  case BODY_KINEMATIC: {
+    vector_t *centroid = centroid_ref(body);
+    *centroid = vec_add(*centroid, vec_multiply(dt, *velocity_ref(body)));
+    break;
+  }
+  case BODY_STATIC:
+    break;
+  }
+}
+
+double body_get_mass(body_t *body) { return *mass_ref(body); }
+
+void body_add_force(body_t *body, vector_t force) {
+  if (body->motion != BODY_DYNAMIC) {
+    return;
+  }
+  if (force.x != 0 || force.y != 0) {
+    body_wake(body);
+  }
+  vector_t *total = force_ref(body);
+  *total = vec_add(*total, force);
+}
+
+void body_add_impulse(body_t *body, vector_t impulse) {
+  if (body->motion != BODY_DYNAMIC) {
+    return;
+  }
+  if (impulse.x != 0 || impulse.y != 0) {
+    body_wake(body);
+  }
+  vector_t *total = impulse_ref(body);
+  *total = vec_add(*total, impulse);
+}
+
+void body_remove(body_t *body) {
+  if (!body->removed) {
+    body->removed = true;
+    asset_schedule_sweep();
+    collision_group_remove_body(body);
+    contact_queue_remove_body(body);
+  }
+}
+
+void body_reset(body_t *body) {
+  *force_ref(body) = VEC_ZERO;
+  *impulse_ref(body) = VEC_ZERO;
+}
+
+bool body_is_removed(body_t *body) { return body->removed; }
+
+body_state_t body_get_state(body_t *body) {
+  return (body_state_t){.centroid = *centroid_ref(body),
+                        .velocity = *velocity_ref(body),
+                        .force = *force_ref(body),
+                        .impulse = *impulse_ref(body),
+                        .rotation = *rotation_ref(body),
+                        .motion = body->motion,
+                        .sleeping = body->sleeping,
+                        .removed = body->removed};
+}
+
+void body_set_state(body_t *body, const body_state_t *state) {
+  // Move the body to its slot's range first, so the refs below stay valid
+  set_motion_state(body, state->motion, state->sleeping);
+  *centroid_ref(body) = state->centroid;
+  *velocity_ref(body) = state->velocity;
+  *force_ref(body) = state->force;
+  *impulse_ref(body) = state->impulse;
+  *rotation_ref(body) = state->rotation;
+  body->removed = state->removed;
+}
+
+void body_free(body_t *body) {
+  body_store_remove(body);
+  if (body->prototype == NULL) {
+    vertex_block_release(body->points, VECTORS_PER_VERTEX * body->num_points);
+  } else {
+    if (body->points != NULL) {
+      vertex_block_release(body->points,
+                           VECTORS_PER_PROTOTYPE_VERTEX * body->num_points);
+    }
+    shape_prototype_release(body->prototype);
+  }
+  if (body->outline != NULL) {
+    vertex_block_release(body->outline, body->num_outline);
+  }
+  if (body->info_freer != NULL) {
+    body->info_freer(body->info);
+  }
+  pool_release(get_pool(BODY_POOL_BODIES), body);
+}
+
+void *body_info_alloc(size_t size) {
+  assert(size <= BODY_INFO_MAX_SIZE);
+  return pool_alloc(get_pool(BODY_POOL_INFO));
+}
+
+void body_info_free(void *info) {
+  if (info != NULL) {
+    pool_release(get_pool(BODY_POOL_INFO), info);
+  }
+}
+
+pool_stats_t body_get_pool_stats(body_pool_t kind) {
+  assert(kind < NUM_BODY_POOLS);
+  return pool_get_stats(get_pool(kind));
+}
+
+body_store_t *body_store_init(void) {
+  body_store_t *store = malloc(sizeof(body_store_t));
+  assert(store);
+  store->size = 0;
+  store->capacity = BODY_STORE_INIT_CAPACITY;
+  store->bodies = malloc(sizeof(body_t *) * store->capacity);
+  store->centroids = malloc(sizeof(vector_t) * store->capacity);
+  store->velocities = malloc(sizeof(vector_t) * store->capacity);
+  store->forces = malloc(sizeof(vector_t) * store->capacity);
+  store->impulses = malloc(sizeof(vector_t) * store->capacity);
+  store->masses = malloc(sizeof(double) * store->capacity);
+  store->rotations = malloc(sizeof(double) * store->capacity);
+  store->rest_times = malloc(sizeof(double) * store->capacity);
+  store->previous_poses = malloc(sizeof(body_pose_t) * store->capacity);
+  store->stepped_poses = malloc(sizeof(body_pose_t) * store->capacity);
+  assert(store->bodies && store->centroids && store->velocities &&
+         store->forces && store->impulses && store->masses &&
+         store->rotations && store->rest_times && store->previous_poses &&
+         store->stepped_poses);
+  store->num_awake = 0;
+  store->num_kinematic = 0;
+  store->interpolating = false;
+  return store;
+}
+
+/**
+ * Doubles the capacity of a body store.
+ *
+ * @param store the pointer to the store
+ */
+static void body_store_grow(body_store_t *store) {
+  store->capacity *= 2;
+  size_t capacity = store->capacity;
+  store->bodies = realloc(store->bodies, sizeof(body_t *) * capacity);
+  store->centroids = realloc(store->centroids, sizeof(vector_t) * capacity);
+  store->velocities =
+      realloc(store->velocities, sizeof(vector_t) * capacity);
+  store->forces = realloc(store->forces, sizeof(vector_t) * capacity);
+  store->impulses = realloc(store->impulses, sizeof(vector_t) * capacity);
+  store->masses = realloc(store->masses, sizeof(double) * capacity);
+  store->rotations = realloc(store->rotations, sizeof(double) * capacity);
+  store->rest_times = realloc(store->rest_times, sizeof(double) * capacity);
+  store->previous_poses =
+      realloc(store->previous_poses, sizeof(body_pose_t) * capacity);
+  store->stepped_poses =
+      realloc(store->stepped_poses, sizeof(body_pose_t) * capacity);
+  assert(store->bodies && store->centroids && store->velocities &&
+         store->forces && store->impulses && store->masses &&
+         store->rotations && store->rest_times && store->previous_poses &&
+         store->stepped_poses);
+}
+
+void body_store_add(body_store_t *store, body_t *body) {
+  assert(body->store == NULL);
+  assert(!store->interpolating);
+  if (store->size == store->capacity) {
+    body_store_grow(store);
+  }
+  size_t slot = store->size++;
+  store->bodies[slot] = body;
+  store->centroids[slot] = body->centroid;
+  store->velocities[slot] = body->velocity;
+  store->forces[slot] = body->force;
+  store->impulses[slot] = body->impulse;
+  store->masses[slot] = body->mass;
+  store->rotations[slot] = body->rotation;
+  store->rest_times[slot] = 0;
+  // A new body has no earlier pose to be shown moving from
+  store->previous_poses[slot] =
+      (body_pose_t){.centroid = body->centroid, .rotation = body->rotation};
+  body->store = store;
+  body->slot = slot;
+  // New slots start in the last range
+  store_move(body, STORE_RANGE_INACTIVE, store_range_of(body));
+}
+
+void body_store_remove(body_t *body) {
+  body_store_t *store = body->store;
+  if (store == NULL) {
+    return;
+  }
+  assert(!store->interpolating);
+  // Move the body to the end of the last range and then out of the store,
+  // so the ranges stay packed
+  store_move(body, store_range_of(body), STORE_RANGE_INACTIVE);
+  size_t slot = body->slot;
+  size_t last = store->size - 1;
+  store_swap(store, slot, last);
+  slot = last;
+  store->size--;
+  body->centroid = store->centroids[slot];
+  body->velocity = store->velocities[slot];
+  body->force = store->forces[slot];
+  body->impulse = store->impulses[slot];
+  body->mass = store->masses[slot];
+  body->rotation = store->rotations[slot];
+  body->store = NULL;
+}
+
+size_t body_store_size(body_store_t *store) { return store->size; }
+
+/**
+ * A store and time step, shared by the jobs that tick parts of the store.
+ */
+typedef struct store_step {
+  body_store_t *store;
+  double dt;
+} store_step_t;
+
+/**
+ * Integrates a range of a store's awake dynamic bodies.
+ *
+ * @param aux the store_step_t
+ * @param start the first slot in the range
+ * @param end one past the last slot in the range
+ */
+static void integrate_awake(void *aux, size_t start, size_t end) {
+  store_step_t *step = aux;
+  body_store_t *store = step->store;
+  double dt = step->dt;
+  vector_t *centroids = store->centroids;
+  vector_t *velocities = store->velocities;
+  vector_t *forces = store->forces;
+  vector_t *impulses = store->impulses;
+  double *masses = store->masses;
+  for (size_t i = start; i < end; i++) {
+    integrate(dt, masses[i], &centroids[i], &velocities[i], &forces[i],
+              &impulses[i]);
+  }
+}
+
+/**
+ * Moves a range of a store's kinematic bodies at their velocities.
+ * Kinematic bodies take no forces, so this matches integrate() with no
+ * force or impulse exactly.
+ *
+ * @param aux the store_step_t
+ * @param start the first kinematic body in the range, counting from 0
+ * @param end one past the last kinematic body in the range
+ */
+static void advance_kinematic(void *aux, size_t start, size_t end) {
+  store_step_t *step = aux;
+  body_store_t *store = step->store;
+  double dt = step->dt;
+  vector_t *centroids = store->centroids + store->num_awake;
+  vector_t *velocities = store->velocities + store->num_awake;
+  for (size_t i = start; i < end; i++) {
+    centroids[i].x += dt * velocities[i].x;
+    centroids[i].y += dt * velocities[i].y;
+  }
+}
+
+void body_store_tick(body_store_t *store, double dt) {
+  body_store_tick_with_jobs(store, dt, NULL);
+}
+
+void body_store_tick_with_jobs(body_store_t *store, double dt,
+                               job_pool_t *pool) {
+  assert(!store->interpolating);
+  store_step_t step = {.store = store, .dt = dt};
+  if (pool == NULL) {
+    integrate_awake(&step, 0, store->num_awake);
+    advance_kinematic(&step, 0, store->num_kinematic);
+  } else {
+    // Every body is integrated on its own, so splitting the ranges into
+    // chunks gives the same results as one loop
+    job_pool_parallel_for(pool, store->num_awake, BODY_STORE_CHUNK_SIZE,
+                          integrate_awake, &step);
+    job_pool_parallel_for(pool, store->num_kinematic, BODY_STORE_CHUNK_SIZE,
+                          advance_kinematic, &step);
+  }
+
+  // Put dynamic bodies to sleep once they have been at rest long enough.
+  // A sleeping body is swapped out of the awake range, so the body swapped
+  // into its slot is checked next.
+  vector_t *velocities = store->velocities;
+  double sleep_speed_squared = BODY_SLEEP_SPEED * BODY_SLEEP_SPEED;
+  for (size_t i = 0; i < store->num_awake;) {
+    if (vec_dot(velocities[i], velocities[i]) >= sleep_speed_squared) {
+      store->rest_times[i] = 0;
+      i++;
+      continue;
+    }
+    store->rest_times[i] += dt;
+    if (store->rest_times[i] < BODY_SLEEP_TIME) {
+      i++;
+      continue;
+    }
+    velocities[i] = VEC_ZERO;
+    set_motion_state(store->bodies[i], BODY_DYNAMIC, true);
+  }
+}
+
+void body_store_save_poses(body_store_t *store) {
+  assert(!store->interpolating);
+  for (size_t i = 0; i < store->size; i++) {
+    store->previous_poses[i] = (body_pose_t){
+        .centroid = store->centroids[i], .rotation = store->rotations[i]};
+  }
+}
+
+void body_store_begin_interpolation(body_store_t *store, double alpha) {
+  assert(!store->interpolating);
+  store->interpolating = true;
+  for (size_t i = 0; i < store->size; i++) {
+    body_pose_t previous = store->previous_poses[i];
+    body_pose_t stepped = {.centroid = store->centroids[i],
+                           .rotation = store->rotations[i]};
+    store->stepped_poses[i] = stepped;
+    store->centroids[i] = vec_add(
+        previous.centroid,
+        vec_multiply(alpha, vec_subtract(stepped.centroid, previous.centroid)));
+    store->rotations[i] =
+        previous.rotation + alpha * (stepped.rotation - previous.rotation);
+  }
+}
+
+void body_store_end_interpolation(body_store_t *store) {
+  assert(store->interpolating);
+  store->interpolating = false;
+  for (size_t i = 0; i < store->size; i++) {
+    store->centroids[i] = store->stepped_poses[i].centroid;
+    store->rotations[i] = store->stepped_poses[i].rotation;
+  }
+}
+
+void body_store_free(body_store_t *store) {
+  while (store->size > 0) {
+    body_store_remove(store->bodies[store->size - 1]);
+  }
+  free(store->bodies);
+  free(store->centroids);
+  free(store->velocities);
+  free(store->forces);
+  free(store->impulses);
+  free(store->masses);
+  free(store->rotations);
+  free(store->rest_times);
+  free(store->previous_poses);
+  free(store->stepped_poses);
+  free(store);
+}
@@ -1,89 +1,55 @@
 #include "collision.h"
 #include "body.h"
+#include "projection.h"
 
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
 
 /**
- * Returns a list of vectors representing the edges of a shape.
- *
- * @param shape the list of vectors representing the vertices of a shape
- * @return a list of vectors representing the edges of the shape
+ * The most axes find_collisions_batch() keeps projections for on the stack:
+ * the largest pooled vertex count in body.c.
  */
-static list_t *get_edges(list_t *shape) {
-  list_t *edges = list_init(list_size(shape), free);
-
-  for (size_t i = 0; i < list_size(shape); i++) {
-    vector_t *vec = malloc(sizeof(vector_t));
-    assert(vec);
-    *vec =
-        vec_subtract(*(vector_t *)list_get(shape, i % list_size(shape)),
-                     *(vector_t *)list_get(shape, (i + 1) % list_size(shape)));
-    list_add(edges, vec);
-  }
-
-  return edges;
-}
+const size_t BATCH_STACK_AXES = 32;
 
 /**
- * Returns a vector containing the maximum and minimum length projections given
- * a unit axis and shape.
- *
- * @param shape the list of vectors representing the vertices of a shape
- * @param unit_axis the unit axis to project eeach vertex on
- * @return a vector in the form (max, min) where `max` is the maximum projection
- * length and `min` is the minimum projection length.
+ * Counts how often find_collision_cached() avoided the full SAT loop.
  */
-static vector_t get_max_min_projections(list_t *shape, vector_t unit_axis) {
-  double max = -__DBL_MAX__;
-  double min = __DBL_MAX__;
-  for (size_t i = 0; i < list_size(shape); i++) {
-    vector_t vertex = *(vector_t *)list_get(shape, i);
-    double projection = vec_dot(vertex, unit_axis);
-    if (projection < min) {
-      min = projection;
-    }
-    if (projection > max) {
-      max = projection;
-    }
-  }
-  vector_t result = {.x = min, .y = max};
-  return result;
-}
+static axis_cache_stats_t AXIS_CACHE_STATS = {.hits = 0, .misses = 0};
 
 /**
- * Determines whether two convex polygons intersect.
- * The polygons are given as lists of vertices in counterclockwise order.
- * There is an edge between each pair of consecutive vertices,
- * and one between the first vertex and the last vertex.
+ * Determines whether two convex polygons intersect, testing the edge normals
+ * of the first polygon as separating axes.
+ * The normals are cached on the body, so each axis only costs the dot
+ * products of the projections, which run through the SIMD kernel in
+ * project_vertices().
  *
- * @param shape1 the first shape
- * @param shape2 the second shape
- * @return whether the shapes are colliding
+ * @param body1 the body whose edge normals supply the axes
+ * @param body2 the other body
+ * @param min_overlap set to the smallest overlap found along any axis
+ * @return whether the shapes are colliding; if not, the axis is one
+ *   that separates them
  */
-static collision_info_t compare_collision(list_t *shape1, list_t *shape2,
+static collision_info_t compare_collision(body_t *body1, body_t *body2,
                                           double *min_overlap) {
   collision_info_t info = {.collided = true, .axis = {0, 0}};
-  list_t *edges1 = get_edges(shape1);
+  size_t num_axes = body_num_axes(body1);
+  const vector_t *vertices1 = body_get_vertices(body1);
+  size_t num_vertices1 = body_num_vertices(body1);
+  const vector_t *vertices2 = body_get_vertices(body2);
+  size_t num_vertices2 = body_num_vertices(body2);
 
-  for (size_t i = 0; i < list_size(edges1); i++) {
-    vector_t edge = *(vector_t *)list_get(edges1, i);
-    vector_t axis = {.x = -edge.y, .y = edge.x};
+  for (size_t i = 0; i < num_axes; i++) {
+    vector_t axis = body_get_axis(body1, i);
 
-    double len = vec_get_length(axis);
-    if (len == 0)
-      continue;
-    axis = vec_multiply(1.0 / len, axis);
-
-    vector_t proj1 = get_max_min_projections(shape1, axis);
-    vector_t proj2 = get_max_min_projections(shape2, axis);
+    vector_t proj1 = project_vertices(vertices1, num_vertices1, axis);
+    vector_t proj2 = project_vertices(vertices2, num_vertices2, axis);
 
     double overlap = fmin(proj1.y, proj2.y) - fmax(proj1.x, proj2.x);
 
     if (overlap <= 0) {
       info.collided = false;
-      list_free(edges1);
+      info.axis = axis;
       return info;
     }
 
@@ -93,24 +59,28 @@ static collision_info_t compare_collision(list_t *shape1, list_t *shape2,
     }
   }
 
-  list_free(edges1);
   return info;
 }
 
-collision_info_t find_collision(body_t *body1, body_t *body2) {
-  list_t *shape1 = body_get_shape(body1);
-  list_t *shape2 = body_get_shape(body2);
-
+/**
+ * Runs the full separating axis test on two bodies, using the edge normals
+ * of both as axes.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return whether the shapes are colliding, and the collision axis if so
+ *   or a separating axis if not
+ */
+static collision_info_t sat_collision(body_t *body1, body_t *body2) {
   double c1_overlap = __DBL_MAX__;
   double c2_overlap = __DBL_MAX__;
 
-  collision_info_t collision1 = compare_collision(shape1, shape2, &c1_overlap);
-  collision_info_t collision2 = compare_collision(shape2, shape1, &c2_overlap);
-
+  collision_info_t collision1 = compare_collision(body1, body2, &c1_overlap);
   if (!collision1.collided) {
     return collision1;
   }
 
+  collision_info_t collision2 = compare_collision(body2, body1, &c2_overlap);
   if (!collision2.collided) {
     return collision2;
   }
@@ -119,4 +89,672 @@ collision_info_t find_collision(body_t *body1, body_t *body2) {
     return collision1;
   }
   return collision2;
-}
\ No newline at end of file
+}
+
+/**
+ * Projects a body onto an axis, including the radius around its core.
+ *
+ * @param body the body to project
+ * @param unit_axis the unit axis to project on
+ * @return a vector in the form (min, max) of the projection
+ */
+static vector_t project_body(body_t *body, vector_t unit_axis) {
+  vector_t proj = project_vertices(body_get_vertices(body),
+                                   body_num_vertices(body), unit_axis);
+  double radius = body_get_radius(body);
+  return (vector_t){.x = proj.x - radius, .y = proj.y + radius};
+}
+
+/**
+ * Finds the point on a segment closest to a given point.
+ *
+ * @param point the point to approach
+ * @param start one end of the segment
+ * @param end the other end of the segment; may equal `start`
+ * @return the closest point on the segment
+ */
+static vector_t closest_on_segment(vector_t point, vector_t start,
+                                   vector_t end) {
+  vector_t segment = vec_subtract(end, start);
+  double length_sq = vec_dot(segment, segment);
+  if (length_sq == 0) {
+    return start;
+  }
+  double t = vec_dot(vec_subtract(point, start), segment) / length_sq;
+  return vec_add(start, vec_multiply(fmin(fmax(t, 0), 1), segment));
+}
+
+/**
+ * Returns whether two segments cross or touch.
+ *
+ * @param a1 one end of the first segment
+ * @param a2 the other end of the first segment
+ * @param b1 one end of the second segment
+ * @param b2 the other end of the second segment
+ * @return true if the segments share a point
+ */
+static bool segments_cross(vector_t a1, vector_t a2, vector_t b1,
+                           vector_t b2) {
+  vector_t a = vec_subtract(a2, a1);
+  vector_t b = vec_subtract(b2, b1);
+  double side1 = vec_cross(a, vec_subtract(b1, a1));
+  double side2 = vec_cross(a, vec_subtract(b2, a1));
+  double side3 = vec_cross(b, vec_subtract(a1, b1));
+  double side4 = vec_cross(b, vec_subtract(a2, b1));
+  // Collinear or touching segments are caught by the distance checks
+  return ((side1 < 0 && side2 > 0) || (side1 > 0 && side2 < 0)) &&
+         ((side3 < 0 && side4 > 0) || (side3 > 0 && side4 < 0));
+}
+
+/**
+ * Finds the closest pair of points on two segments.
+ * Either segment may have both ends equal, i.e. be a single point.
+ *
+ * @param a1 one end of the first segment
+ * @param a2 the other end of the first segment
+ * @param b1 one end of the second segment
+ * @param b2 the other end of the second segment
+ * @param closest_a set to the closest point on the first segment
+ * @param closest_b set to the closest point on the second segment
+ * @return the distance between the segments
+ */
+static double segment_distance(vector_t a1, vector_t a2, vector_t b1,
+                               vector_t b2, vector_t *closest_a,
+                               vector_t *closest_b) {
+  if (segments_cross(a1, a2, b1, b2)) {
+    // Any point will do, since the caller only needs to know they touch
+    *closest_a = a1;
+    *closest_b = a1;
+    return 0;
+  }
+
+  // Otherwise the closest pair always includes an end of one segment
+  vector_t ends[4] = {a1, a2, b1, b2};
+  double best = INFINITY;
+  for (size_t i = 0; i < 4; i++) {
+    vector_t on_a = i < 2 ? ends[i] : closest_on_segment(ends[i], a1, a2);
+    vector_t on_b = i < 2 ? closest_on_segment(ends[i], b1, b2) : ends[i];
+    double distance = vec_get_length(vec_subtract(on_b, on_a));
+    if (distance < best) {
+      best = distance;
+      *closest_a = on_a;
+      *closest_b = on_b;
+    }
+  }
+  return best;
+}
+
+/**
+ * Returns whether a point lies inside or on a convex polygon.
+ *
+ * @param point the point to test
+ * @param vertices the vertices of the polygon, in either winding order
+ * @param num_vertices the number of vertices
+ * @return true if the point is not outside the polygon
+ */
+static bool point_in_polygon(vector_t point, const vector_t *vertices,
+                             size_t num_vertices) {
+  bool has_left = false;
+  bool has_right = false;
+  for (size_t i = 0; i < num_vertices; i++) {
+    vector_t start = vertices[i];
+    vector_t end = vertices[(i + 1) % num_vertices];
+    double side = vec_cross(vec_subtract(end, start),
+                            vec_subtract(point, start));
+    has_left |= side > 0;
+    has_right |= side < 0;
+  }
+  return !(has_left && has_right);
+}
+
+/**
+ * Gets the core segment of a circle or capsule.
+ * A circle's core is a segment with both ends at its center.
+ *
+ * @param body a circle or capsule body
+ * @param start set to one end of the segment
+ * @param end set to the other end of the segment
+ */
+static void get_core_segment(body_t *body, vector_t *start, vector_t *end) {
+  *start = body_get_vertex(body, 0);
+  *end = body_get_vertex(body, body_num_vertices(body) - 1);
+}
+
+/**
+ * Returns a unit vector from one body's centroid towards another's,
+ * or an arbitrary unit vector if the centroids coincide.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return the direction from body1 to body2
+ */
+static vector_t centroid_direction(body_t *body1, body_t *body2) {
+  vector_t offset =
+      vec_subtract(body_get_centroid(body2), body_get_centroid(body1));
+  double length = vec_get_length(offset);
+  if (length == 0) {
+    return (vector_t){1, 0};
+  }
+  return vec_multiply(1 / length, offset);
+}
+
+/**
+ * Tests two circles or capsules against each other with one closest-point
+ * query between their core segments. This covers circle-circle,
+ * circle-capsule and capsule-capsule pairs.
+ *
+ * @param body1 the first body, a circle or capsule
+ * @param body2 the second body, a circle or capsule
+ * @return whether the shapes are colliding, with an axis from body1 towards
+ *   body2 that is the collision axis if so or a separating axis if not
+ */
+static collision_info_t round_collision(body_t *body1, body_t *body2) {
+  vector_t start1, end1, start2, end2, closest1, closest2;
+  get_core_segment(body1, &start1, &end1);
+  get_core_segment(body2, &start2, &end2);
+  double distance =
+      segment_distance(start1, end1, start2, end2, &closest1, &closest2);
+
+  collision_info_t info = {.time = 0};
+  info.collided = distance < body_get_radius(body1) + body_get_radius(body2);
+  if (distance > 0) {
+    info.axis = vec_multiply(1 / distance, vec_subtract(closest2, closest1));
+  } else {
+    info.axis = centroid_direction(body1, body2);
+  }
+  return info;
+}
+
+/**
+ * Tests a circle or capsule against a convex polygon. When the core segment
+ * is outside the polygon, the closest points between the segment and the
+ * polygon's edges decide the test; otherwise the shapes overlap deeply and
+ * the axis of least overlap is found as in the separating axis test.
+ *
+ * @param round the circle or capsule
+ * @param polygon the polygon
+ * @return whether the shapes are colliding, with an axis from `round`
+ *   towards `polygon` that is the collision axis if so or a separating axis
+ *   if not
+ */
+static collision_info_t round_polygon_collision(body_t *round,
+                                                body_t *polygon) {
+  vector_t start, end;
+  get_core_segment(round, &start, &end);
+  const vector_t *vertices = body_get_vertices(polygon);
+  size_t num_vertices = body_num_vertices(polygon);
+
+  if (!point_in_polygon(start, vertices, num_vertices) &&
+      !point_in_polygon(end, vertices, num_vertices)) {
+    double best = INFINITY;
+    vector_t closest_round = start, closest_polygon = start;
+    for (size_t i = 0; i < num_vertices; i++) {
+      vector_t on_round, on_polygon;
+      double distance =
+          segment_distance(start, end, vertices[i],
+                           vertices[(i + 1) % num_vertices], &on_round,
+                           &on_polygon);
+      if (distance < best) {
+        best = distance;
+        closest_round = on_round;
+        closest_polygon = on_polygon;
+      }
+    }
+    if (best > 0) {
+      vector_t offset = vec_subtract(closest_polygon, closest_round);
+      return (collision_info_t){.collided = best < body_get_radius(round),
+                                .axis = vec_multiply(1 / best, offset)};
+    }
+  }
+
+  // The core is inside the polygon, so take the axis of least overlap
+  // among the polygon's normals and the capsule's segment normal
+  collision_info_t info = {.collided = true, .axis = {0, 0}};
+  double min_overlap = INFINITY;
+  body_t *bodies[2] = {polygon, round};
+  for (size_t b = 0; b < 2; b++) {
+    size_t num_axes = body_num_axes(bodies[b]);
+    for (size_t i = 0; i < num_axes; i++) {
+      vector_t axis = body_get_axis(bodies[b], i);
+      vector_t proj1 = project_body(round, axis);
+      vector_t proj2 = project_body(polygon, axis);
+      double overlap = fmin(proj1.y, proj2.y) - fmax(proj1.x, proj2.x);
+      if (overlap < min_overlap) {
+        min_overlap = overlap;
+        info.axis = axis;
+      }
+    }
+  }
+  if (vec_dot(info.axis, centroid_direction(round, polygon)) < 0) {
+    info.axis = vec_negate(info.axis);
+  }
+  return info;
+}
+
+/**
+ * Runs the narrow phase test suited to the two bodies' shape types.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return whether the shapes are colliding, and the collision axis if so
+ *   or a separating axis if not
+ */
+static collision_info_t shape_collision(body_t *body1, body_t *body2) {
+  bool round1 = body_get_shape_type(body1) != SHAPE_POLYGON;
+  bool round2 = body_get_shape_type(body2) != SHAPE_POLYGON;
+  if (round1 && round2) {
+    return round_collision(body1, body2);
+  }
+  if (round1) {
+    return round_polygon_collision(body1, body2);
+  }
+  if (round2) {
+    collision_info_t info = round_polygon_collision(body2, body1);
+    info.axis = vec_negate(info.axis);
+    return info;
+  }
+  return sat_collision(body1, body2);
+}
+
+collision_info_t find_collision(body_t *body1, body_t *body2) {
+  // Bodies whose boxes are apart cannot intersect, so skip the projections
+  if (!aabb_overlaps(body_get_aabb(body1), body_get_aabb(body2))) {
+    return (collision_info_t){.collided = false, .axis = {0, 0}};
+  }
+  return shape_collision(body1, body2);
+}
+
+collision_info_t find_collision_cached(body_t *body1, body_t *body2,
+                                       axis_cache_t *cache) {
+  if (!aabb_overlaps(body_get_aabb(body1), body_get_aabb(body2))) {
+    return (collision_info_t){.collided = false, .axis = {0, 0}};
+  }
+
+  // Any axis that separates the projections proves the shapes are apart,
+  // even if the bodies have rotated since it was cached
+  if (cache->valid) {
+    vector_t proj1 = project_body(body1, cache->axis);
+    vector_t proj2 = project_body(body2, cache->axis);
+    if (fmin(proj1.y, proj2.y) - fmax(proj1.x, proj2.x) <= 0) {
+      AXIS_CACHE_STATS.hits++;
+      return (collision_info_t){.collided = false, .axis = cache->axis};
+    }
+  }
+  AXIS_CACHE_STATS.misses++;
+
+  collision_info_t info = shape_collision(body1, body2);
+  cache->valid = !info.collided;
+  cache->axis = info.axis;
+  return info;
+}
+
+/**
+ * Runs the separating axis test on two polygons like sat_collision(),
+ * with the first polygon's projections onto its own axes precomputed.
+ *
+ * @param subject the first polygon
+ * @param subject_proj the projections of `subject` onto each of its axes
+ * @param other the second polygon
+ * @return whether the shapes are colliding, and the collision axis if so
+ *   or a separating axis if not
+ */
+static collision_info_t batch_sat_collision(body_t *subject,
+                                            const vector_t *subject_proj,
+                                            body_t *other) {
+  collision_info_t collision1 = {.collided = true, .axis = {0, 0}};
+  double c1_overlap = __DBL_MAX__;
+  const vector_t *vertices = body_get_vertices(other);
+  size_t num_vertices = body_num_vertices(other);
+  size_t num_axes = body_num_axes(subject);
+  for (size_t i = 0; i < num_axes; i++) {
+    vector_t axis = body_get_axis(subject, i);
+    vector_t proj = project_vertices(vertices, num_vertices, axis);
+    double overlap =
+        fmin(subject_proj[i].y, proj.y) - fmax(subject_proj[i].x, proj.x);
+    if (overlap <= 0) {
+      return (collision_info_t){.collided = false, .axis = axis};
+    }
+    if (overlap < c1_overlap) {
+      c1_overlap = overlap;
+      collision1.axis = axis;
+    }
+  }
+
+  double c2_overlap = __DBL_MAX__;
+  collision_info_t collision2 = compare_collision(other, subject, &c2_overlap);
+  if (!collision2.collided) {
+    return collision2;
+  }
+
+  if (c1_overlap < c2_overlap) {
+    return collision1;
+  }
+  return collision2;
+}
+
+/**
+ * Projects a polygon onto each of its own axes. The projections go in
+ * `stack_proj` if they fit, else in `scratch`, grown as needed, else in a
+ * new array the caller must free.
+ *
+ * @param subject the polygon
+ * @param stack_proj an array of BATCH_STACK_AXES projections
+ * @param scratch a scratch buffer for bigger polygons, or NULL
+ * @param allocated set to the new array, if one was allocated
+ * @return the array holding the projections
+ */
+static vector_t *project_onto_own_axes(body_t *subject, vector_t *stack_proj,
+                                       collision_scratch_t *scratch,
+                                       vector_t **allocated) {
+  size_t num_axes = body_num_axes(subject);
+  vector_t *proj = stack_proj;
+  if (num_axes > BATCH_STACK_AXES) {
+    if (scratch == NULL) {
+      proj = malloc(sizeof(vector_t) * num_axes);
+      assert(proj);
+      *allocated = proj;
+    } else {
+      if (scratch->capacity < num_axes) {
+        scratch->projections =
+            realloc(scratch->projections, sizeof(vector_t) * num_axes);
+        assert(scratch->projections);
+        scratch->capacity = num_axes;
+      }
+      proj = scratch->projections;
+    }
+  }
+  for (size_t i = 0; i < num_axes; i++) {
+    proj[i] = project_body(subject, body_get_axis(subject, i));
+  }
+  return proj;
+}
+
+void find_collisions_batch(body_t *subject, body_t **others, size_t num_others,
+                           collision_info_t *out,
+                           collision_scratch_t *scratch) {
+  aabb_t subject_aabb = body_get_aabb(subject);
+  bool subject_polygon = body_get_shape_type(subject) == SHAPE_POLYGON;
+  // Filled in the first time a polygon pair gets past the bounding boxes
+  vector_t stack_proj[BATCH_STACK_AXES];
+  vector_t *subject_proj = NULL;
+  vector_t *allocated_proj = NULL;
+
+  for (size_t i = 0; i < num_others; i++) {
+    body_t *other = others[i];
+    if (!aabb_overlaps(subject_aabb, body_get_aabb(other))) {
+      out[i] = (collision_info_t){.collided = false, .axis = {0, 0}};
+      continue;
+    }
+    if (!subject_polygon || body_get_shape_type(other) != SHAPE_POLYGON) {
+      out[i] = shape_collision(subject, other);
+      continue;
+    }
+
+    if (subject_proj == NULL) {
+      subject_proj = project_onto_own_axes(subject, stack_proj, scratch,
+                                           &allocated_proj);
+    }
+    out[i] = batch_sat_collision(subject, subject_proj, other);
+  }
+  free(allocated_proj);
+}
+
+void collision_scratch_free(collision_scratch_t *scratch) {
+  free(scratch->projections);
+  scratch->projections = NULL;
+  scratch->capacity = 0;
+}
+
+axis_cache_stats_t collision_get_axis_cache_stats(void) {
+  return AXIS_CACHE_STATS;
+}
+
+void collision_reset_axis_cache_stats(void) {
+  AXIS_CACHE_STATS = (axis_cache_stats_t){.hits = 0, .misses = 0};
+}
+
+/**
+ * Narrows the interval of times during which two moving shapes overlap
+ * along one axis. Body2 moves relative to body1; both start at time 0
+ * and finish their motion at time 1.
+ *
+ * @param body1 the first body, at the end of its motion
+ * @param body2 the second body, at the end of its motion
+ * @param axis the unit axis to test
+ * @param relative the displacement of body2 relative to body1
+ * @param t_enter the latest entry time so far, updated in place
+ * @param t_exit the earliest exit time so far, updated in place
+ * @param enter_axis set to `axis` if it has the latest entry time
+ * @return false if the shapes can never overlap along this axis
+ */
+static bool sweep_axis(body_t *body1, body_t *body2, vector_t axis,
+                       vector_t relative, double *t_enter, double *t_exit,
+                       vector_t *enter_axis) {
+  vector_t proj1 = project_body(body1, axis);
+  vector_t proj2 = project_body(body2, axis);
+  double speed = vec_dot(relative, axis);
+  // Rewind body2 to where it started relative to body1
+  double min2 = proj2.x - speed;
+  double max2 = proj2.y - speed;
+
+  if (speed == 0) {
+    return min2 < proj1.y && proj1.x < max2;
+  }
+
+  double enter, exit;
+  if (speed > 0) {
+    enter = (proj1.x - max2) / speed;
+    exit = (proj1.y - min2) / speed;
+  } else {
+    enter = (proj1.y - min2) / speed;
+    exit = (proj1.x - max2) / speed;
+  }
+  if (enter > *t_enter) {
+    *t_enter = enter;
+    *enter_axis = axis;
+  }
+  if (exit < *t_exit) {
+    *t_exit = exit;
+  }
+  return *t_enter < *t_exit;
+}
+
+/**
+ * Returns the smallest box containing a body over its whole motion.
+ *
+ * @param body the body, at the end of its motion
+ * @param displacement how far the body moved
+ * @return the box swept out by the body's bounding box
+ */
+static aabb_t swept_aabb(body_t *body, vector_t displacement) {
+  aabb_t aabb = body_get_aabb(body);
+  aabb.min.x -= fmax(displacement.x, 0);
+  aabb.max.x -= fmin(displacement.x, 0);
+  aabb.min.y -= fmax(displacement.y, 0);
+  aabb.max.y -= fmin(displacement.y, 0);
+  return aabb;
+}
+
+swept_collision_info_t find_swept_collision(body_t *body1,
+                                            vector_t displacement1,
+                                            body_t *body2,
+                                            vector_t displacement2) {
+  swept_collision_info_t info = {.collided = false, .axis = {0, 0}, .time = 0};
+  if (!aabb_overlaps(swept_aabb(body1, displacement1),
+                     swept_aabb(body2, displacement2))) {
+    return info;
+  }
+
+  vector_t relative = vec_subtract(displacement2, displacement1);
+  double t_enter = -INFINITY;
+  double t_exit = INFINITY;
+  vector_t enter_axis = {0, 0};
+  size_t num_axes1 = body_num_axes(body1);
+  for (size_t i = 0; i < num_axes1; i++) {
+    if (!sweep_axis(body1, body2, body_get_axis(body1, i), relative, &t_enter,
+                    &t_exit, &enter_axis)) {
+      return info;
+    }
+  }
+  size_t num_axes2 = body_num_axes(body2);
+  for (size_t i = 0; i < num_axes2; i++) {
+    if (!sweep_axis(body1, body2, body_get_axis(body2, i), relative, &t_enter,
+                    &t_exit, &enter_axis)) {
+      return info;
+    }
+  }
+
+  // Curved shapes have no finite set of edge normals, so also test the axis
+  // across the motion and the axis between the bodies. This may report a
+  // near miss as a contact, but never misses a real one.
+  if (body_get_shape_type(body1) != SHAPE_POLYGON ||
+      body_get_shape_type(body2) != SHAPE_POLYGON) {
+    double speed = vec_get_length(relative);
+    vector_t round_axes[2] = {centroid_direction(body1, body2), {0, 0}};
+    size_t num_round_axes = 1;
+    if (speed > 0) {
+      round_axes[num_round_axes++] =
+          (vector_t){.x = -relative.y / speed, .y = relative.x / speed};
+    }
+    for (size_t i = 0; i < num_round_axes; i++) {
+      if (!sweep_axis(body1, body2, round_axes[i], relative, &t_enter,
+                      &t_exit, &enter_axis)) {
+        return info;
+      }
+    }
+  }
+
+  // The overlap must start before the end of the tick and end after its start
+  if (t_enter > 1 || t_exit <= 0) {
+    return info;
+  }
+
+  info.collided = true;
+  info.time = fmax(t_enter, 0);
+  if (t_enter == -INFINITY) {
+    // Neither body moved along any axis, so this is a static overlap
+    info.axis = find_collision(body1, body2).axis;
+  } else {
+    info.axis = enter_axis;
+  }
+  return info;
+}
+
+/**
+ * Clips a ray against a convex polygon, one edge at a time.
+ *
+ * @param vertices the vertices of the polygon, in either winding order
+ * @param num_vertices the number of vertices; at least 3
+ * @param origin the start of the ray
+ * @param direction the unit direction of the ray
+ * @param max_distance how far along the ray to look
+ * @param distance set to the distance at which the ray enters the polygon,
+ *   or 0 if it starts inside
+ * @return whether the ray meets the polygon within `max_distance`
+ */
+static bool ray_polygon(const vector_t *vertices, size_t num_vertices,
+                        vector_t origin, vector_t direction,
+                        double max_distance, double *distance) {
+  // Outward normals point right of each edge for counterclockwise polygons
+  double area = 0;
+  for (size_t i = 0; i < num_vertices; i++) {
+    area += vec_cross(vertices[i], vertices[(i + 1) % num_vertices]);
+  }
+  double outward = area > 0 ? 1 : -1;
+
+  double t_enter = 0;
+  double t_exit = max_distance;
+  for (size_t i = 0; i < num_vertices; i++) {
+    vector_t edge = vec_subtract(vertices[(i + 1) % num_vertices], vertices[i]);
+    vector_t normal = {.x = outward * edge.y, .y = -outward * edge.x};
+    // The ray is inside this edge's half-plane where along < gap
+    double gap = vec_dot(normal, vec_subtract(vertices[i], origin));
+    double along = vec_dot(normal, direction);
+    if (along == 0) {
+      if (gap < 0) {
+        return false;
+      }
+    } else if (along < 0) {
+      t_enter = fmax(t_enter, gap / along);
+    } else {
+      t_exit = fmin(t_exit, gap / along);
+    }
+    if (t_enter > t_exit) {
+      return false;
+    }
+  }
+  *distance = t_enter;
+  return true;
+}
+
+/**
+ * Intersects a ray with a disc.
+ *
+ * @param center the center of the disc
+ * @param radius the radius of the disc
+ * @param origin the start of the ray
+ * @param direction the unit direction of the ray
+ * @param max_distance how far along the ray to look
+ * @param distance set to the distance at which the ray enters the disc,
+ *   or 0 if it starts inside
+ * @return whether the ray meets the disc within `max_distance`
+ */
+static bool ray_circle(vector_t center, double radius, vector_t origin,
+                       vector_t direction, double max_distance,
+                       double *distance) {
+  vector_t offset = vec_subtract(origin, center);
+  double c = vec_dot(offset, offset) - radius * radius;
+  if (c <= 0) {
+    *distance = 0;
+    return true;
+  }
+  double b = vec_dot(offset, direction);
+  double discriminant = b * b - c;
+  if (b > 0 || discriminant < 0) {
+    return false;
+  }
+  double t = -b - sqrt(discriminant);
+  if (t > max_distance) {
+    return false;
+  }
+  *distance = t;
+  return true;
+}
+
+bool find_ray_collision(body_t *body, vector_t origin, vector_t direction,
+                        double max_distance, double *distance) {
+  if (body_get_shape_type(body) == SHAPE_POLYGON) {
+    return ray_polygon(body_get_vertices(body), body_num_vertices(body),
+                       origin, direction, max_distance, distance);
+  }
+
+  // A capsule is two discs joined by a rectangle around its segment
+  vector_t start, end;
+  get_core_segment(body, &start, &end);
+  double radius = body_get_radius(body);
+  bool hit = false;
+  double best = max_distance;
+  double t;
+  if (ray_circle(start, radius, origin, direction, best, &t)) {
+    hit = true;
+    best = t;
+  }
+  if (body_get_shape_type(body) == SHAPE_CAPSULE) {
+    if (ray_circle(end, radius, origin, direction, best, &t)) {
+      hit = true;
+      best = t;
+    }
+    vector_t normal = vec_multiply(radius, body_get_axis(body, 0));
+    vector_t rectangle[4] = {
+        vec_add(start, normal), vec_subtract(start, normal),
+        vec_subtract(end, normal), vec_add(end, normal)};
+    if (ray_polygon(rectangle, 4, origin, direction, best, &t)) {
+      hit = true;
+      best = fmin(best, t);
+    }
+  }
+  if (hit) {
+    *distance = best;
+  }
+  return hit;
+}
@@ -0,0 +1,184 @@
+#include "collision_group.h"
+#include "list.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Initial number of slots in a group's hash table. Must be a power of two.
+ */
+const size_t COLLISION_GROUP_INIT_CAPACITY = 16;
+
+/**
+ * Every group that has not been freed, so body_remove() can find them.
+ * The list does not own the groups.
+ */
+static list_t *GROUP_LIST = NULL;
+
+struct collision_group {
+  // The members, packed at the front of the array in no particular order
+  body_t **members;
+  size_t size;
+  // Open-addressing table of indices into members, plus one; 0 marks an
+  // empty slot. Has twice as many slots as members has room for.
+  size_t *slots;
+  size_t capacity;
+};
+
+collision_group_t *collision_group_init(void) {
+  collision_group_t *group = malloc(sizeof(collision_group_t));
+  assert(group);
+  group->capacity = COLLISION_GROUP_INIT_CAPACITY;
+  group->members = malloc(sizeof(body_t *) * group->capacity / 2);
+  assert(group->members);
+  group->slots = calloc(group->capacity, sizeof(size_t));
+  assert(group->slots);
+  group->size = 0;
+
+  if (GROUP_LIST == NULL) {
+    GROUP_LIST = list_init(1, NULL);
+  }
+  list_add(GROUP_LIST, group);
+  return group;
+}
+
+/**
+ * Finds the home slot of a body in a group's hash table.
+ *
+ * @param group the pointer to the group
+ * @param body the body
+ * @return the index of the first slot to probe for the body
+ */
+static size_t home_slot(collision_group_t *group, body_t *body) {
+  uint64_t h = (uint64_t)(uintptr_t)body * 0x9E3779B97F4A7C15ULL;
+  return (h ^ (h >> 29)) & (group->capacity - 1);
+}
+
+/**
+ * Finds the slot referring to a body, or the empty slot where it would go.
+ *
+ * @param group the pointer to the group
+ * @param body the body
+ * @return the index of the slot in the hash table
+ */
+static size_t find_slot(collision_group_t *group, body_t *body) {
+  size_t mask = group->capacity - 1;
+  size_t i = home_slot(group, body);
+  while (group->slots[i] != 0 &&
+         group->members[group->slots[i] - 1] != body) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+/**
+ * Doubles the capacity of a group, rebuilding the hash table.
+ *
+ * @param group the pointer to the group
+ */
+static void grow(collision_group_t *group) {
+  group->capacity *= 2;
+  group->members =
+      realloc(group->members, sizeof(body_t *) * group->capacity / 2);
+  assert(group->members);
+  free(group->slots);
+  group->slots = calloc(group->capacity, sizeof(size_t));
+  assert(group->slots);
+  for (size_t i = 0; i < group->size; i++) {
+    group->slots[find_slot(group, group->members[i])] = i + 1;
+  }
+}
+
+/**
+ * Empties a slot, shifting later entries of the same probe run back
+ * so every remaining member can still be found without tombstones.
+ *
+ * @param group the pointer to the group
+ * @param hole the index of the slot to empty
+ */
+static void clear_slot(collision_group_t *group, size_t hole) {
+  size_t mask = group->capacity - 1;
+  group->slots[hole] = 0;
+  for (size_t i = (hole + 1) & mask; group->slots[i] != 0;
+       i = (i + 1) & mask) {
+    size_t home = home_slot(group, group->members[group->slots[i] - 1]);
+    // Move the entry back unless its home lies cyclically in (hole, i]
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      group->slots[hole] = group->slots[i];
+      group->slots[i] = 0;
+      hole = i;
+    }
+  }
+}
+
+void collision_group_add(collision_group_t *group, body_t *body) {
+  size_t slot = find_slot(group, body);
+  if (group->slots[slot] != 0) {
+    return;
+  }
+  // Keep the load factor at most one half so probes stay short
+  if (group->size == group->capacity / 2) {
+    grow(group);
+    slot = find_slot(group, body);
+  }
+  group->members[group->size++] = body;
+  group->slots[slot] = group->size;
+}
+
+void collision_group_remove(collision_group_t *group, body_t *body) {
+  size_t slot = find_slot(group, body);
+  if (group->slots[slot] == 0) {
+    return;
+  }
+  size_t index = group->slots[slot] - 1;
+  clear_slot(group, slot);
+
+  // Fill the gap with the last member so the array stays packed
+  size_t last = group->size - 1;
+  if (index != last) {
+    body_t *moved = group->members[last];
+    group->members[index] = moved;
+    group->slots[find_slot(group, moved)] = index + 1;
+  }
+  group->size--;
+}
+
+bool collision_group_contains(collision_group_t *group, body_t *body) {
+  return group->slots[find_slot(group, body)] != 0;
+}
+
+size_t collision_group_size(collision_group_t *group) { return group->size; }
+
+body_t *collision_group_get(collision_group_t *group, size_t index) {
+  assert(index < group->size);
+  return group->members[index];
+}
+
+void collision_group_remove_body(body_t *body) {
+  if (GROUP_LIST == NULL) {
+    return;
+  }
+  size_t num_groups = list_size(GROUP_LIST);
+  for (size_t i = 0; i < num_groups; i++) {
+    collision_group_remove(list_get(GROUP_LIST, i), body);
+  }
+}
+
+void collision_group_free(collision_group_t *group) {
+  size_t num_groups = list_size(GROUP_LIST);
+  for (size_t i = 0; i < num_groups; i++) {
+    if (list_get(GROUP_LIST, i) == group) {
+      list_remove(GROUP_LIST, i);
+      break;
+    }
+  }
+  if (list_size(GROUP_LIST) == 0) {
+    list_free(GROUP_LIST);
+    GROUP_LIST = NULL;
+  }
+
+  free(group->members);
+  free(group->slots);
+  free(group);
+}
@@ -0,0 +1,94 @@
+#include "contact_queue.h"
+#include "list.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+/**
+ * The initial number of events a contact queue has room for.
+ */
+const size_t CONTACT_QUEUE_INIT_CAPACITY = 16;
+
+/**
+ * Every queue that has not been freed, so body_remove() can find them.
+ * The list does not own the queues.
+ */
+static list_t *QUEUE_LIST = NULL;
+
+struct contact_queue {
+  // Pending events in the order they were pushed. Dropped events stay in
+  // place with both bodies set to NULL, so draining can continue past them.
+  contact_event_t *events;
+  size_t size;
+  size_t capacity;
+};
+
+contact_queue_t *contact_queue_init(void) {
+  contact_queue_t *queue = malloc(sizeof(contact_queue_t));
+  assert(queue);
+  queue->capacity = CONTACT_QUEUE_INIT_CAPACITY;
+  queue->events = malloc(sizeof(contact_event_t) * queue->capacity);
+  assert(queue->events);
+  queue->size = 0;
+
+  if (QUEUE_LIST == NULL) {
+    QUEUE_LIST = list_init(1, NULL);
+  }
+  list_add(QUEUE_LIST, queue);
+  return queue;
+}
+
+void contact_queue_push(contact_queue_t *queue, contact_event_t event) {
+  if (queue->size == queue->capacity) {
+    queue->capacity *= 2;
+    queue->events =
+        realloc(queue->events, sizeof(contact_event_t) * queue->capacity);
+    assert(queue->events);
+  }
+  queue->events[queue->size++] = event;
+}
+
+void contact_queue_drain(contact_queue_t *queue, contact_handler_t handler,
+                         void *aux) {
+  for (size_t i = 0; i < queue->size; i++) {
+    contact_event_t event = queue->events[i];
+    if (event.body1 != NULL) {
+      handler(event, aux);
+    }
+  }
+  queue->size = 0;
+}
+
+void contact_queue_remove_body(body_t *body) {
+  if (QUEUE_LIST == NULL) {
+    return;
+  }
+  size_t num_queues = list_size(QUEUE_LIST);
+  for (size_t i = 0; i < num_queues; i++) {
+    contact_queue_t *queue = list_get(QUEUE_LIST, i);
+    for (size_t j = 0; j < queue->size; j++) {
+      contact_event_t *event = &queue->events[j];
+      if (event->body1 == body || event->body2 == body) {
+        event->body1 = NULL;
+        event->body2 = NULL;
+      }
+    }
+  }
+}
+
+void contact_queue_free(contact_queue_t *queue) {
+  size_t num_queues = list_size(QUEUE_LIST);
+  for (size_t i = 0; i < num_queues; i++) {
+    if (list_get(QUEUE_LIST, i) == queue) {
+      list_remove(QUEUE_LIST, i);
+      break;
+    }
+  }
+  if (list_size(QUEUE_LIST) == 0) {
+    list_free(QUEUE_LIST);
+    QUEUE_LIST = NULL;
+  }
+
+  free(queue->events);
+  free(queue);
+}
@@ -0,0 +1,627 @@
+#include "forces.h"
+#include "collision_group.h"
+#include "contact_queue.h"
+#include "pair_set.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+/**
+ * Below this distance gravity is not applied, since it blows up near 0.
+ */
+const double MIN_GRAVITY_DIST = 5;
+
+/**
+ * The initial number of candidate pairs a filtered or group collision pass
+ * has room for; the buffers grow as needed and are kept between ticks.
+ */
+const size_t PASS_INIT_CANDIDATES = 32;
+
+/**
+ * The aux value of a gravity, spring, or drag force creator.
+ */
+typedef struct aux {
+  double force_const;
+} aux_t;
+
+/**
+ * The aux value of a collision force creator.
+ */
+typedef struct collision_aux {
+  double force_const;
+  collision_handler_t handler;
+  // If non-NULL, called instead of handler, with the time of first contact
+  swept_collision_handler_t swept_handler;
+  // Whether the bodies were colliding on the last tick
+  bool collided;
+  void *aux;
+  free_func_t freer;
+  scene_t *scene;
+  // The axis that separated the bodies last tick
+  axis_cache_t axis_cache;
+  // Whether to sweep the bodies along their motion since the last tick
+  bool swept;
+  // The centroids at the last tick, valid once `has_last_centroids` is set
+  bool has_last_centroids;
+  vector_t last_centroid1;
+  vector_t last_centroid2;
+} collision_aux_t;
+
+/**
+ * The aux value of a collision pass that tests many pairs in one force
+ * creator: either a filtered pass or a group pass.
+ */
+typedef struct pass_collision_aux {
+  double force_const;
+  collision_handler_t handler;
+  void *aux;
+  free_func_t freer;
+  scene_t *scene;
+  // The groups tested against each other; NULL for a filtered pass
+  collision_group_t *group_a;
+  collision_group_t *group_b;
+  // If non-NULL, contact events are pushed here instead of calling handler
+  contact_queue_t *queue;
+  // Whether to push stay events to the queue for pairs still colliding
+  bool stay_events;
+  // Pairs that were colliding on the last tick
+  pair_set_t *colliding;
+  // Pairs found colliding so far this tick
+  pair_set_t *next_colliding;
+  // Candidate pairs gathered each tick and tested in batches that share
+  // a first body; reused between ticks
+  body_t **firsts;
+  body_t **seconds;
+  collision_info_t *results;
+  size_t num_candidates;
+  size_t candidates_capacity;
+  // Holds the projections of a batch subject too big for the stack
+  collision_scratch_t scratch;
+} pass_collision_aux_t;
+
+/**
+ * Allocates the aux value of a gravity, spring, or drag force creator.
+ *
+ * @param force_const the constant of the force
+ * @return a pointer to the newly allocated aux value
+ */
+static aux_t *aux_init(double force_const) {
+  aux_t *aux = malloc(sizeof(aux_t));
+  assert(aux);
+  aux->force_const = force_const;
+  return aux;
+}
+
+/**
+ * Frees the aux value of a collision force creator,
+ * along with the handler's aux value.
+ *
+ * @param collision_aux the aux value to free
+ */
+static void collision_aux_free(collision_aux_t *collision_aux) {
+  if (collision_aux->freer != NULL) {
+    collision_aux->freer(collision_aux->aux);
+  }
+  free(collision_aux);
+}
+
+/**
+ * Builds the list of bodies a force creator acts on.
+ * The list does not own the bodies.
+ *
+ * @param body1 the first body
+ * @param body2 the second body, or NULL for a single-body force
+ * @return a newly allocated list of the bodies
+ */
+static list_t *make_body_list(body_t *body1, body_t *body2) {
+  list_t *bodies = list_init(2, NULL);
+  list_add(bodies, body1);
+  if (body2 != NULL) {
+    list_add(bodies, body2);
+  }
+  return bodies;
+}
+
+/**
+ * Applies Newtonian gravity between two bodies.
+ *
+ * @param aux the gravity aux value holding G
+ * @param bodies the two bodies
+ */
+static void newtonian_gravity(aux_t *aux, list_t *bodies) {
+  body_t *body1 = list_get(bodies, 0);
+  body_t *body2 = list_get(bodies, 1);
+  vector_t displacement =
+      vec_subtract(body_get_centroid(body1), body_get_centroid(body2));
+  double dist_squared = vec_dot(displacement, displacement);
+  double dist = sqrt(dist_squared);
+  if (dist <= MIN_GRAVITY_DIST) {
+    return;
+  }
+
+  double magnitude = aux->force_const * body_get_mass(body1) *
+                     body_get_mass(body2) / dist_squared;
+  vector_t force = vec_multiply(magnitude / dist, displacement);
+  body_add_force(body2, force);
+  body_add_force(body1, vec_negate(force));
+}
+
+void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
+                              body_t *body2) {
+  scene_add_isolated_force_creator(scene, (force_creator_t)newtonian_gravity,
+                                   aux_init(G), make_body_list(body1, body2),
+                                   free);
+}
+
+/**
+ * Applies a Hooke's-Law spring force between two bodies.
+ *
+ * @param aux the spring aux value holding k
+ * @param bodies the two bodies
+ */
+static void spring(aux_t *aux, list_t *bodies) {
+  body_t *body1 = list_get(bodies, 0);
+  body_t *body2 = list_get(bodies, 1);
+  vector_t displacement =
+      vec_subtract(body_get_centroid(body2), body_get_centroid(body1));
+  vector_t force = vec_multiply(aux->force_const, displacement);
+  body_add_force(body1, force);
+  body_add_force(body2, vec_negate(force));
+}
+
+void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
+  scene_add_isolated_force_creator(scene, (force_creator_t)spring,
+                                   aux_init(k), make_body_list(body1, body2),
+                                   free);
+}
+
+/**
+ * Applies a drag force opposite a body's velocity.
+ *
+ * @param aux the drag aux value holding gamma
+ * @param bodies the single body to slow down
+ */
+static void drag(aux_t *aux, list_t *bodies) {
+  body_t *body = list_get(bodies, 0);
+  body_add_force(body,
+                 vec_multiply(-aux->force_const, body_get_velocity(body)));
+}
+
+void create_drag(scene_t *scene, double gamma, body_t *body) {
+  scene_add_isolated_force_creator(scene, (force_creator_t)drag,
+                                   aux_init(gamma), make_body_list(body, NULL),
+                                   free);
+}
+
+/**
+ * Tests two bodies for a swept collision along the straight paths they
+ * took since the force creator last ran, then remembers where they are now.
+ *
+ * @param collision_aux the collision aux value
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return whether, along which axis and when the bodies touched during
+ *   the tick
+ */
+static collision_info_t find_swept_tick_collision(
+    collision_aux_t *collision_aux, body_t *body1, body_t *body2) {
+  vector_t centroid1 = body_get_centroid(body1);
+  vector_t centroid2 = body_get_centroid(body2);
+  vector_t displacement1 = VEC_ZERO;
+  vector_t displacement2 = VEC_ZERO;
+  if (collision_aux->has_last_centroids) {
+    displacement1 = vec_subtract(centroid1, collision_aux->last_centroid1);
+    displacement2 = vec_subtract(centroid2, collision_aux->last_centroid2);
+  }
+  collision_aux->last_centroid1 = centroid1;
+  collision_aux->last_centroid2 = centroid2;
+  collision_aux->has_last_centroids = true;
+
+  swept_collision_info_t swept =
+      find_swept_collision(body1, displacement1, body2, displacement2);
+  return (collision_info_t){
+      .collided = swept.collided, .axis = swept.axis, .time = swept.time};
+}
+
+/**
+ * Calls the collision handler when two bodies start colliding.
+ * Pairs the scene's broad phase rules out skip the SAT test entirely,
+ * and the rest try last tick's separating axis before the full test.
+ * Swept pairs always run their own test, since the broad phase only
+ * sees where the bodies ended up.
+ *
+ * @param collision_aux the collision aux value
+ * @param bodies the two bodies
+ */
+static void collision_force_creator(collision_aux_t *collision_aux,
+                                    list_t *bodies) {
+  body_t *body1 = list_get(bodies, 0);
+  body_t *body2 = list_get(bodies, 1);
+
+  collision_info_t info = {.collided = false};
+  if (collision_aux->swept) {
+    info = find_swept_tick_collision(collision_aux, body1, body2);
+  } else if (scene_bodies_may_collide(collision_aux->scene, body1, body2)) {
+    info = find_collision_cached(body1, body2, &collision_aux->axis_cache);
+  }
+  if (info.collided && !collision_aux->collided) {
+    if (collision_aux->swept_handler != NULL) {
+      collision_aux->swept_handler(body1, body2, info.axis, info.time,
+                                   collision_aux->aux,
+                                   collision_aux->force_const);
+    } else {
+      collision_aux->handler(body1, body2, info.axis, collision_aux->aux,
+                             collision_aux->force_const);
+    }
+  }
+  collision_aux->collided = info.collided;
+}
+
+/**
+ * Registers a collision force creator, either instantaneous or swept.
+ * Exactly one of `handler` and `swept_handler` is non-NULL, and
+ * `swept_handler` is only set for swept collisions.
+ */
+static void add_collision(scene_t *scene, body_t *body1, body_t *body2,
+                          collision_handler_t handler,
+                          swept_collision_handler_t swept_handler, void *aux,
+                          double force_const, free_func_t freer, bool swept) {
+  assert((handler == NULL) != (swept_handler == NULL));
+  assert(swept || swept_handler == NULL);
+  collision_aux_t *collision_aux = malloc(sizeof(collision_aux_t));
+  assert(collision_aux);
+  collision_aux->force_const = force_const;
+  collision_aux->handler = handler;
+  collision_aux->swept_handler = swept_handler;
+  collision_aux->collided = false;
+  collision_aux->aux = aux;
+  collision_aux->freer = freer;
+  collision_aux->scene = scene;
+  collision_aux->axis_cache = (axis_cache_t){.valid = false};
+  collision_aux->swept = swept;
+  collision_aux->has_last_centroids = false;
+  scene_add_force_creator(scene, (force_creator_t)collision_force_creator,
+                          collision_aux, make_body_list(body1, body2),
+                          (free_func_t)collision_aux_free);
+}
+
+void create_collision(scene_t *scene, body_t *body1, body_t *body2,
+                      collision_handler_t handler, void *aux,
+                      double force_const, free_func_t freer) {
+  add_collision(scene, body1, body2, handler, NULL, aux, force_const, freer,
+                false);
+}
+
+void create_swept_collision(scene_t *scene, body_t *body1, body_t *body2,
+                            collision_handler_t handler, void *aux,
+                            double force_const, free_func_t freer) {
+  add_collision(scene, body1, body2, handler, NULL, aux, force_const, freer,
+                true);
+}
+
+void create_timed_swept_collision(scene_t *scene, body_t *body1, body_t *body2,
+                                  swept_collision_handler_t handler, void *aux,
+                                  double force_const, free_func_t freer) {
+  add_collision(scene, body1, body2, NULL, handler, aux, force_const, freer,
+                true);
+}
+
+/**
+ * Allocates the aux value of a collision pass with no candidates yet.
+ *
+ * @param scene the scene the pass runs in
+ * @param handler the function to call when a pair starts colliding
+ * @param aux an auxiliary value to pass to the handler
+ * @param force_const a constant to pass to the handler
+ * @param freer a function to free the handler's aux value
+ * @return a pointer to the newly allocated aux value
+ */
+static pass_collision_aux_t *pass_collision_aux_init(
+    scene_t *scene, collision_handler_t handler, void *aux, double force_const,
+    free_func_t freer) {
+  pass_collision_aux_t *pass_aux = malloc(sizeof(pass_collision_aux_t));
+  assert(pass_aux);
+  pass_aux->force_const = force_const;
+  pass_aux->handler = handler;
+  pass_aux->aux = aux;
+  pass_aux->freer = freer;
+  pass_aux->scene = scene;
+  pass_aux->group_a = NULL;
+  pass_aux->group_b = NULL;
+  pass_aux->queue = NULL;
+  pass_aux->stay_events = false;
+  pass_aux->colliding = pair_set_init();
+  pass_aux->next_colliding = pair_set_init();
+  pass_aux->candidates_capacity = PASS_INIT_CANDIDATES;
+  pass_aux->num_candidates = 0;
+  pass_aux->firsts = malloc(sizeof(body_t *) * PASS_INIT_CANDIDATES);
+  pass_aux->seconds = malloc(sizeof(body_t *) * PASS_INIT_CANDIDATES);
+  pass_aux->results = malloc(sizeof(collision_info_t) * PASS_INIT_CANDIDATES);
+  assert(pass_aux->firsts && pass_aux->seconds && pass_aux->results);
+  pass_aux->scratch = (collision_scratch_t){.projections = NULL,
+                                            .capacity = 0};
+  return pass_aux;
+}
+
+/**
+ * Frees the aux value of a collision pass,
+ * along with the handler's aux value.
+ * The groups of a group pass belong to the caller and are not freed.
+ *
+ * @param aux the aux value to free
+ */
+static void pass_collision_aux_free(pass_collision_aux_t *aux) {
+  if (aux->freer != NULL) {
+    aux->freer(aux->aux);
+  }
+  pair_set_free(aux->colliding);
+  pair_set_free(aux->next_colliding);
+  free(aux->firsts);
+  free(aux->seconds);
+  free(aux->results);
+  collision_scratch_free(&aux->scratch);
+  free(aux);
+}
+
+/**
+ * Appends a pair to the candidates a collision pass tests this tick.
+ *
+ * @param pass_aux the aux value of the pass
+ * @param body1 the first body, passed to the handler first
+ * @param body2 the second body
+ */
+static void add_candidate(pass_collision_aux_t *pass_aux, body_t *body1,
+                          body_t *body2) {
+  if (pass_aux->num_candidates == pass_aux->candidates_capacity) {
+    size_t capacity = pass_aux->candidates_capacity * 2;
+    pass_aux->firsts = realloc(pass_aux->firsts, sizeof(body_t *) * capacity);
+    pass_aux->seconds =
+        realloc(pass_aux->seconds, sizeof(body_t *) * capacity);
+    pass_aux->results =
+        realloc(pass_aux->results, sizeof(collision_info_t) * capacity);
+    assert(pass_aux->firsts && pass_aux->seconds && pass_aux->results);
+    pass_aux->candidates_capacity = capacity;
+  }
+  pass_aux->firsts[pass_aux->num_candidates] = body1;
+  pass_aux->seconds[pass_aux->num_candidates] = body2;
+  pass_aux->num_candidates++;
+}
+
+/**
+ * Pushes an end event for each pair that was colliding last tick but not
+ * this tick. Pairs whose bodies have left the pass's groups are skipped;
+ * that happens when a body is removed, and it may already be freed.
+ *
+ * @param pass_aux the aux value of a group pass with a contact queue
+ */
+static void push_end_events(pass_collision_aux_t *pass_aux) {
+  size_t num_colliding = pair_set_size(pass_aux->colliding);
+  for (size_t i = 0; i < num_colliding; i++) {
+    void *body1, *body2;
+    pair_set_get(pass_aux->colliding, i, &body1, &body2);
+    if (!pair_set_contains(pass_aux->next_colliding, body1, body2) &&
+        collision_group_contains(pass_aux->group_a, body1) &&
+        collision_group_contains(pass_aux->group_b, body2)) {
+      contact_queue_push(pass_aux->queue,
+                         (contact_event_t){.type = CONTACT_END,
+                                           .body1 = body1,
+                                           .body2 = body2,
+                                           .axis = {0, 0}});
+    }
+  }
+}
+
+/**
+ * Tests the candidates gathered by a collision pass and calls the handler
+ * on each pair that started colliding this tick, or pushes begin, end and
+ * (if enabled) stay events if the pass has a contact queue.
+ * Consecutive candidates with the same first body (e.g. the player against
+ * every hazard near it) are tested with one find_collisions_batch() call.
+ *
+ * @param pass_aux the aux value of the pass
+ */
+static void run_candidates(pass_collision_aux_t *pass_aux) {
+  size_t num_candidates = pass_aux->num_candidates;
+  size_t start = 0;
+  while (start < num_candidates) {
+    body_t *subject = pass_aux->firsts[start];
+    size_t end = start + 1;
+    while (end < num_candidates && pass_aux->firsts[end] == subject) {
+      end++;
+    }
+    find_collisions_batch(subject, pass_aux->seconds + start, end - start,
+                          pass_aux->results + start, &pass_aux->scratch);
+    start = end;
+  }
+
+  pair_set_clear(pass_aux->next_colliding);
+  for (size_t i = 0; i < num_candidates; i++) {
+    body_t *body1 = pass_aux->firsts[i];
+    body_t *body2 = pass_aux->seconds[i];
+    // A handler earlier in the pass may have removed one of the bodies
+    if (!pass_aux->results[i].collided || body_is_removed(body1) ||
+        body_is_removed(body2)) {
+      continue;
+    }
+    if (!pair_set_add(pass_aux->next_colliding, body1, body2)) {
+      continue;
+    }
+    bool was_colliding = pair_set_contains(pass_aux->colliding, body1, body2);
+    if (pass_aux->queue != NULL) {
+      if (was_colliding && !pass_aux->stay_events) {
+        continue;
+      }
+      contact_queue_push(
+          pass_aux->queue,
+          (contact_event_t){.type = was_colliding ? CONTACT_STAY
+                                                  : CONTACT_BEGIN,
+                            .body1 = body1,
+                            .body2 = body2,
+                            .axis = pass_aux->results[i].axis});
+    } else if (!was_colliding) {
+      pass_aux->handler(body1, body2, pass_aux->results[i].axis,
+                        pass_aux->aux, pass_aux->force_const);
+    }
+  }
+  if (pass_aux->queue != NULL) {
+    push_end_events(pass_aux);
+  }
+
+  pair_set_t *temp = pass_aux->colliding;
+  pass_aux->colliding = pass_aux->next_colliding;
+  pass_aux->next_colliding = temp;
+}
+
+/**
+ * Gathers one candidate pair in a filtered collision pass.
+ * Pairs whose categories and masks do not match are skipped before any
+ * geometry is touched.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param pass_aux the aux value of the pass
+ */
+static void filter_collision_pair(body_t *body1, body_t *body2,
+                                  pass_collision_aux_t *pass_aux) {
+  if (!(body_get_category(body1) & body_get_collision_mask(body2)) ||
+      !(body_get_category(body2) & body_get_collision_mask(body1))) {
+    return;
+  }
+  // Pass the bodies in a fixed order so handlers know which is which
+  if (body_get_category(body2) < body_get_category(body1)) {
+    add_candidate(pass_aux, body2, body1);
+  } else {
+    add_candidate(pass_aux, body1, body2);
+  }
+}
+
+/**
+ * Runs a filtered collision pass over every candidate pair in the scene.
+ *
+ * @param pass_aux the aux value of the pass
+ * @param bodies unused; the pass applies to the whole scene
+ */
+static void filtered_collision_force_creator(pass_collision_aux_t *pass_aux,
+                                             list_t *bodies) {
+  pass_aux->num_candidates = 0;
+  scene_for_each_candidate_pair(pass_aux->scene,
+                                (body_pair_func_t)filter_collision_pair,
+                                pass_aux);
+  run_candidates(pass_aux);
+}
+
+void create_filtered_collision(scene_t *scene, collision_handler_t handler,
+                               void *aux, double force_const,
+                               free_func_t freer) {
+  pass_collision_aux_t *pass_aux =
+      pass_collision_aux_init(scene, handler, aux, force_const, freer);
+  // With no bodies, the pass stays registered until the scene is freed
+  scene_add_force_creator(scene,
+                          (force_creator_t)filtered_collision_force_creator,
+                          pass_aux, list_init(1, NULL),
+                          (free_func_t)pass_collision_aux_free);
+}
+
+/**
+ * Runs a group collision pass over every pair of members of its two groups
+ * that the scene's broad phase does not rule out.
+ *
+ * @param pass_aux the aux value of the pass
+ * @param bodies unused; the pass applies to the groups' current members
+ */
+static void group_collision_force_creator(pass_collision_aux_t *pass_aux,
+                                          list_t *bodies) {
+  pass_aux->num_candidates = 0;
+  size_t size_a = collision_group_size(pass_aux->group_a);
+  size_t size_b = collision_group_size(pass_aux->group_b);
+  bool same_group = pass_aux->group_a == pass_aux->group_b;
+  for (size_t i = 0; i < size_a; i++) {
+    body_t *body1 = collision_group_get(pass_aux->group_a, i);
+    // Within one group, visit each unordered pair once
+    for (size_t j = same_group ? i + 1 : 0; j < size_b; j++) {
+      body_t *body2 = collision_group_get(pass_aux->group_b, j);
+      if (body1 != body2 &&
+          scene_bodies_may_collide(pass_aux->scene, body1, body2)) {
+        add_candidate(pass_aux, body1, body2);
+      }
+    }
+  }
+  run_candidates(pass_aux);
+}
+
+void create_group_collision(scene_t *scene, collision_group_t *group_a,
+                            collision_group_t *group_b,
+                            collision_handler_t handler, void *aux,
+                            double force_const, free_func_t freer) {
+  pass_collision_aux_t *pass_aux =
+      pass_collision_aux_init(scene, handler, aux, force_const, freer);
+  pass_aux->group_a = group_a;
+  pass_aux->group_b = group_b;
+  // With no bodies, the pass stays registered until the scene is freed
+  scene_add_force_creator(scene,
+                          (force_creator_t)group_collision_force_creator,
+                          pass_aux, list_init(1, NULL),
+                          (free_func_t)pass_collision_aux_free);
+}
+
+void create_group_contact_events(scene_t *scene, collision_group_t *group_a,
+                                 collision_group_t *group_b,
+                                 contact_queue_t *queue, bool stay_events) {
+  pass_collision_aux_t *pass_aux =
+      pass_collision_aux_init(scene, NULL, NULL, 0, NULL);
+  pass_aux->group_a = group_a;
+  pass_aux->group_b = group_b;
+  pass_aux->queue = queue;
+  pass_aux->stay_events = stay_events;
+  // With no bodies, the pass stays registered until the scene is freed
+  scene_add_force_creator(scene,
+                          (force_creator_t)group_collision_force_creator,
+                          pass_aux, list_init(1, NULL),
+                          (free_func_t)pass_collision_aux_free);
+}
+
+/**
+ * Collision handler that removes both bodies.
+ */
+static void destructive_collision(body_t *body1, body_t *body2, vector_t axis,
+                                  void *aux, double force_const) {
+  body_remove(body1);
+  body_remove(body2);
+}
+
+void create_destructive_collision(scene_t *scene, body_t *body1,
+                                  body_t *body2) {
+  create_collision(scene, body1, body2, destructive_collision, NULL, 0, NULL);
+}
+
+/**
+ * Collision handler that applies equal and opposite impulses along the
+ * collision axis. The force constant is the coefficient of restitution.
+ */
+static void physics_collision_handler(body_t *body1, body_t *body2,
+                                      vector_t axis, void *aux,
+                                      double elasticity) {
+  double mass1 = body_get_mass(body1);
+  double mass2 = body_get_mass(body2);
+  double reduced_mass;
+  if (mass1 == INFINITY) {
+    reduced_mass = mass2;
+  } else if (mass2 == INFINITY) {
+    reduced_mass = mass1;
+  } else {
+    reduced_mass = mass1 * mass2 / (mass1 + mass2);
+  }
+
+  double u1 = vec_dot(body_get_velocity(body1), axis);
+  double u2 = vec_dot(body_get_velocity(body2), axis);
+  double impulse = reduced_mass * (1 + elasticity) * (u2 - u1);
+  body_add_impulse(body1, vec_multiply(impulse, axis));
+  body_add_impulse(body2, vec_negate(vec_multiply(impulse, axis)));
+}
+
+void create_physics_collision(scene_t *scene, body_t *body1, body_t *body2,
+                              double elasticity) {
+  create_collision(scene, body1, body2, physics_collision_handler, NULL,
+                   elasticity, NULL);
+}
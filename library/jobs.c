@@ -0,0 +1,325 @@
+#include "jobs.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define JOBS_USE_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Initial number of jobs each deque has room for.
+ */
+const size_t JOB_DEQUE_INIT_CAPACITY = 16;
+
+/**
+ * A range of indices to run a job function on.
+ */
+typedef struct job {
+  job_func_t func;
+  void *aux;
+  size_t start;
+  size_t end;
+} job_t;
+
+/**
+ * The jobs waiting to run on one thread. The owner takes jobs from the
+ * back, and other threads steal from the front, so a thief takes the jobs
+ * the owner would have reached last.
+ */
+typedef struct job_deque {
+#ifdef JOBS_USE_THREADS
+  pthread_mutex_t lock;
+#endif
+  job_t *jobs;
+  size_t front;
+  size_t back;
+  size_t capacity;
+} job_deque_t;
+
+struct job_pool {
+  size_t num_threads;
+  // One deque per thread; the submitting thread uses deques[0]
+  job_deque_t *deques;
+  bool single_threaded;
+#ifdef JOBS_USE_THREADS
+  pthread_t *threads;
+  // Guards the fields below
+  pthread_mutex_t lock;
+  // Signalled when a new batch is submitted or the pool is shutting down
+  pthread_cond_t batch_ready;
+  // Signalled when the last job of a batch finishes
+  pthread_cond_t batch_done;
+  // Counts batches, so workers can tell a new batch from a spurious wakeup
+  size_t batch;
+  // The number of jobs in the current batch that have not finished
+  size_t pending;
+  bool shutting_down;
+#endif
+};
+
+/**
+ * The arguments a worker thread is started with.
+ */
+typedef struct worker {
+  job_pool_t *pool;
+  size_t index;
+} worker_t;
+
+/**
+ * Adds a job to the back of a deque, growing it if needed.
+ *
+ * @param deque the deque
+ * @param job the job
+ */
+static void deque_push(job_deque_t *deque, job_t job) {
+#ifdef JOBS_USE_THREADS
+  pthread_mutex_lock(&deque->lock);
+#endif
+  if (deque->back == deque->capacity) {
+    deque->capacity *= 2;
+    deque->jobs = realloc(deque->jobs, sizeof(job_t) * deque->capacity);
+    assert(deque->jobs);
+  }
+  deque->jobs[deque->back++] = job;
+#ifdef JOBS_USE_THREADS
+  pthread_mutex_unlock(&deque->lock);
+#endif
+}
+
+/**
+ * Takes a job from one end of a deque.
+ *
+ * @param deque the deque
+ * @param from_back whether to take the newest job, as the owner does,
+ *   rather than the oldest, as a thief does
+ * @param job set to the job taken
+ * @return whether there was a job to take
+ */
+static bool deque_take(job_deque_t *deque, bool from_back, job_t *job) {
+  bool found = false;
+#ifdef JOBS_USE_THREADS
+  pthread_mutex_lock(&deque->lock);
+#endif
+  if (deque->front < deque->back) {
+    *job = from_back ? deque->jobs[--deque->back]
+                     : deque->jobs[deque->front++];
+    found = true;
+  }
+  if (deque->front == deque->back) {
+    deque->front = 0;
+    deque->back = 0;
+  }
+#ifdef JOBS_USE_THREADS
+  pthread_mutex_unlock(&deque->lock);
+#endif
+  return found;
+}
+
+/**
+ * Takes the next job for a thread: its own newest job if it has any,
+ * and otherwise the oldest job of the next thread that does.
+ *
+ * @param pool the pointer to the job pool
+ * @param index the thread's index
+ * @param job set to the job taken
+ * @return whether any thread had a job left
+ */
+static bool take_job(job_pool_t *pool, size_t index, job_t *job) {
+  if (deque_take(&pool->deques[index], true, job)) {
+    return true;
+  }
+  for (size_t i = 1; i < pool->num_threads; i++) {
+    size_t victim = (index + i) % pool->num_threads;
+    if (deque_take(&pool->deques[victim], false, job)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#ifdef JOBS_USE_THREADS
+/**
+ * Runs jobs on a thread until every deque is empty,
+ * counting each one off the current batch.
+ *
+ * @param pool the pointer to the job pool
+ * @param index the thread's index
+ */
+static void run_jobs(job_pool_t *pool, size_t index) {
+  job_t job;
+  while (take_job(pool, index, &job)) {
+    job.func(job.aux, job.start, job.end);
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->pending == 0) {
+      pthread_cond_broadcast(&pool->batch_done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+/**
+ * The loop each worker thread runs: waits for a batch, helps run it,
+ * and repeats until the pool is freed.
+ *
+ * @param arg the worker_t for the thread, which it frees
+ * @return NULL
+ */
+static void *worker_main(void *arg) {
+  worker_t *worker = arg;
+  job_pool_t *pool = worker->pool;
+  size_t index = worker->index;
+  free(worker);
+
+  size_t seen_batch = 0;
+  pthread_mutex_lock(&pool->lock);
+  while (true) {
+    while (pool->batch == seen_batch && !pool->shutting_down) {
+      pthread_cond_wait(&pool->batch_ready, &pool->lock);
+    }
+    if (pool->shutting_down) {
+      break;
+    }
+    seen_batch = pool->batch;
+    pthread_mutex_unlock(&pool->lock);
+    run_jobs(pool, index);
+    pthread_mutex_lock(&pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+/**
+ * Gets the number of processor cores available to the program.
+ *
+ * @return the number of cores, at least 1
+ */
+static size_t count_cores(void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores < 1 ? 1 : (size_t)cores;
+}
+#endif
+
+job_pool_t *job_pool_init(size_t num_threads) {
+  job_pool_t *pool = malloc(sizeof(job_pool_t));
+  assert(pool);
+#ifdef JOBS_USE_THREADS
+  pool->num_threads = num_threads == 0 ? count_cores() : num_threads;
+#else
+  pool->num_threads = 1;
+#endif
+  pool->single_threaded = false;
+  pool->deques = malloc(sizeof(job_deque_t) * pool->num_threads);
+  assert(pool->deques);
+  for (size_t i = 0; i < pool->num_threads; i++) {
+    job_deque_t *deque = &pool->deques[i];
+    deque->jobs = malloc(sizeof(job_t) * JOB_DEQUE_INIT_CAPACITY);
+    assert(deque->jobs);
+    deque->front = 0;
+    deque->back = 0;
+    deque->capacity = JOB_DEQUE_INIT_CAPACITY;
+#ifdef JOBS_USE_THREADS
+    pthread_mutex_init(&deque->lock, NULL);
+#endif
+  }
+
+#ifdef JOBS_USE_THREADS
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->batch_ready, NULL);
+  pthread_cond_init(&pool->batch_done, NULL);
+  pool->batch = 0;
+  pool->pending = 0;
+  pool->shutting_down = false;
+  // The submitting thread is thread 0, so only the others are started
+  pool->threads = malloc(sizeof(pthread_t) * pool->num_threads);
+  assert(pool->threads);
+  for (size_t i = 1; i < pool->num_threads; i++) {
+    worker_t *worker = malloc(sizeof(worker_t));
+    assert(worker);
+    worker->pool = pool;
+    worker->index = i;
+    int error = pthread_create(&pool->threads[i], NULL, worker_main, worker);
+    assert(error == 0);
+  }
+#endif
+  return pool;
+}
+
+size_t job_pool_num_threads(job_pool_t *pool) {
+  return pool->single_threaded ? 1 : pool->num_threads;
+}
+
+void job_pool_set_single_threaded(job_pool_t *pool, bool single_threaded) {
+  pool->single_threaded = single_threaded;
+}
+
+void job_pool_parallel_for(job_pool_t *pool, size_t count, size_t chunk_size,
+                           job_func_t func, void *aux) {
+  assert(chunk_size > 0);
+  if (count == 0) {
+    return;
+  }
+  if (job_pool_num_threads(pool) == 1 || count <= chunk_size) {
+    for (size_t start = 0; start < count; start += chunk_size) {
+      size_t end = start + chunk_size < count ? start + chunk_size : count;
+      func(aux, start, end);
+    }
+    return;
+  }
+
+#ifdef JOBS_USE_THREADS
+  // A worker still looking for work from the last batch may take these
+  // jobs as soon as they are pushed, so they are counted first
+  size_t num_jobs = (count + chunk_size - 1) / chunk_size;
+  pthread_mutex_lock(&pool->lock);
+  pool->pending = num_jobs;
+  pthread_mutex_unlock(&pool->lock);
+
+  // Deal the chunks out round robin; stealing evens out the rest
+  for (size_t i = 0; i < num_jobs; i++) {
+    size_t start = i * chunk_size;
+    size_t end = start + chunk_size < count ? start + chunk_size : count;
+    job_t job = {.func = func, .aux = aux, .start = start, .end = end};
+    deque_push(&pool->deques[i % pool->num_threads], job);
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->batch++;
+  pthread_cond_broadcast(&pool->batch_ready);
+  pthread_mutex_unlock(&pool->lock);
+
+  run_jobs(pool, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->pending > 0) {
+    pthread_cond_wait(&pool->batch_done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+void job_pool_free(job_pool_t *pool) {
+#ifdef JOBS_USE_THREADS
+  pthread_mutex_lock(&pool->lock);
+  pool->shutting_down = true;
+  pthread_cond_broadcast(&pool->batch_ready);
+  pthread_mutex_unlock(&pool->lock);
+  for (size_t i = 1; i < pool->num_threads; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  free(pool->threads);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->batch_ready);
+  pthread_cond_destroy(&pool->batch_done);
+#endif
+  for (size_t i = 0; i < pool->num_threads; i++) {
+#ifdef JOBS_USE_THREADS
+    pthread_mutex_destroy(&pool->deques[i].lock);
+#endif
+    free(pool->deques[i].jobs);
+  }
+  free(pool->deques);
+  free(pool);
+}
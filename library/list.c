@@ -0,0 +1,66 @@
+#include "list.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The factor a full list's capacity grows by.
+ */
+const size_t LIST_GROWTH_FACTOR = 2;
+
+struct list {
+  void **elements;
+  size_t size;
+  size_t capacity;
+  free_func_t freer;
+};
+
+list_t *list_init(size_t initial_capacity, free_func_t freer) {
+  assert(initial_capacity > 0);
+  list_t *list = malloc(sizeof(list_t));
+  assert(list);
+  list->elements = malloc(sizeof(void *) * initial_capacity);
+  assert(list->elements);
+  list->size = 0;
+  list->capacity = initial_capacity;
+  list->freer = freer;
+  return list;
+}
+
+void list_free(list_t *list) {
+  if (list->freer != NULL) {
+    for (size_t i = 0; i < list->size; i++) {
+      list->freer(list->elements[i]);
+    }
+  }
+  free(list->elements);
+  free(list);
+}
+
+size_t list_size(list_t *list) { return list->size; }
+
+void *list_get(list_t *list, size_t index) {
+  assert(index < list->size);
+  return list->elements[index];
+}
+
+void list_add(list_t *list, void *value) {
+  assert(value != NULL);
+  if (list->size == list->capacity) {
+    list->capacity *= LIST_GROWTH_FACTOR;
+    list->elements =
+        realloc(list->elements, sizeof(void *) * list->capacity);
+    assert(list->elements);
+  }
+  list->elements[list->size++] = value;
+}
+
+void *list_remove(list_t *list, size_t index) {
+  assert(index < list->size);
+  void *value = list->elements[index];
+  list->size--;
+  memmove(list->elements + index, list->elements + index + 1,
+          sizeof(void *) * (list->size - index));
+  return value;
+}
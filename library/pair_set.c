@@ -0,0 +1,137 @@
+#include "pair_set.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Initial number of slots in the hash table. Must be a power of two.
+ */
+const size_t PAIR_SET_INIT_CAPACITY = 64;
+
+/**
+ * A pair, stored in the order it was first added.
+ */
+typedef struct pair {
+  void *first;
+  void *second;
+} pair_t;
+
+struct pair_set {
+  // The pairs in insertion order
+  pair_t *pairs;
+  size_t size;
+  // Open-addressing table of indices into pairs, plus one; 0 marks an empty
+  // slot. Has twice as many slots as pairs has room for.
+  size_t *slots;
+  size_t capacity;
+};
+
+pair_set_t *pair_set_init(void) {
+  pair_set_t *set = malloc(sizeof(pair_set_t));
+  assert(set);
+  set->capacity = PAIR_SET_INIT_CAPACITY;
+  set->pairs = malloc(sizeof(pair_t) * set->capacity / 2);
+  assert(set->pairs);
+  set->slots = calloc(set->capacity, sizeof(size_t));
+  assert(set->slots);
+  set->size = 0;
+  return set;
+}
+
+/**
+ * Hashes an unordered pair of pointers, so (a, b) and (b, a) hash the same.
+ *
+ * @param pair the pair
+ * @return the hash of the pair
+ */
+static uint64_t hash_pair(pair_t pair) {
+  uintptr_t low = (uintptr_t)pair.first;
+  uintptr_t high = (uintptr_t)pair.second;
+  if (high < low) {
+    low = (uintptr_t)pair.second;
+    high = (uintptr_t)pair.first;
+  }
+  uint64_t h = (uint64_t)low * 0x9E3779B97F4A7C15ULL;
+  h ^= (uint64_t)high * 0xC2B2AE3D27D4EB4FULL;
+  return h ^ (h >> 29);
+}
+
+/**
+ * Finds the slot referring to a pair, or the empty slot where it would go.
+ *
+ * @param set the pointer to the pair set
+ * @param pair the pair, in either order
+ * @return a pointer to the slot in the hash table
+ */
+static size_t *find_slot(pair_set_t *set, pair_t pair) {
+  size_t mask = set->capacity - 1;
+  size_t i = hash_pair(pair) & mask;
+  while (set->slots[i] != 0) {
+    pair_t stored = set->pairs[set->slots[i] - 1];
+    if ((stored.first == pair.first && stored.second == pair.second) ||
+        (stored.first == pair.second && stored.second == pair.first)) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return &set->slots[i];
+}
+
+/**
+ * Doubles the capacity of a set, rebuilding the hash table.
+ *
+ * @param set the pointer to the pair set
+ */
+static void grow(pair_set_t *set) {
+  set->capacity *= 2;
+  set->pairs = realloc(set->pairs, sizeof(pair_t) * set->capacity / 2);
+  assert(set->pairs);
+  free(set->slots);
+  set->slots = calloc(set->capacity, sizeof(size_t));
+  assert(set->slots);
+  for (size_t i = 0; i < set->size; i++) {
+    *find_slot(set, set->pairs[i]) = i + 1;
+  }
+}
+
+bool pair_set_add(pair_set_t *set, void *first, void *second) {
+  pair_t pair = {.first = first, .second = second};
+  size_t *slot = find_slot(set, pair);
+  if (*slot != 0) {
+    return false;
+  }
+  // Keep the load factor at most one half so probes stay short
+  if (set->size == set->capacity / 2) {
+    grow(set);
+    slot = find_slot(set, pair);
+  }
+  set->pairs[set->size++] = pair;
+  *slot = set->size;
+  return true;
+}
+
+bool pair_set_contains(pair_set_t *set, void *first, void *second) {
+  pair_t pair = {.first = first, .second = second};
+  return *find_slot(set, pair) != 0;
+}
+
+size_t pair_set_size(pair_set_t *set) { return set->size; }
+
+void pair_set_get(pair_set_t *set, size_t index, void **first, void **second) {
+  assert(index < set->size);
+  *first = set->pairs[index].first;
+  *second = set->pairs[index].second;
+}
+
+void pair_set_clear(pair_set_t *set) {
+  memset(set->slots, 0, sizeof(size_t) * set->capacity);
+  set->size = 0;
+}
+
+void pair_set_free(pair_set_t *set) {
+  free(set->pairs);
+  free(set->slots);
+  free(set);
+}
@@ -0,0 +1,110 @@
+#include "pool.h"
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * Initial number of slabs a pool has room to track.
+ */
+const size_t POOL_INIT_SLABS = 4;
+
+/**
+ * A free block, linked to the next free block in its pool.
+ */
+typedef struct free_block {
+  struct free_block *next;
+} free_block_t;
+
+struct pool {
+  // Block size rounded up so every block in a slab stays aligned
+  size_t block_size;
+  size_t blocks_per_slab;
+  void **slabs;
+  size_t num_slabs;
+  size_t slabs_capacity;
+  free_block_t *free_list;
+  size_t in_use;
+  size_t peak_in_use;
+};
+
+pool_t *pool_init(size_t block_size, size_t blocks_per_slab) {
+  assert(block_size > 0 && blocks_per_slab > 0);
+  pool_t *pool = malloc(sizeof(pool_t));
+  assert(pool);
+  size_t align = alignof(max_align_t);
+  if (block_size < sizeof(free_block_t)) {
+    block_size = sizeof(free_block_t);
+  }
+  pool->block_size = (block_size + align - 1) / align * align;
+  pool->blocks_per_slab = blocks_per_slab;
+  pool->slabs = malloc(sizeof(void *) * POOL_INIT_SLABS);
+  assert(pool->slabs);
+  pool->num_slabs = 0;
+  pool->slabs_capacity = POOL_INIT_SLABS;
+  pool->free_list = NULL;
+  pool->in_use = 0;
+  pool->peak_in_use = 0;
+  return pool;
+}
+
+/**
+ * Allocates another slab and threads its blocks onto the free list.
+ *
+ * @param pool the pointer to the pool
+ */
+static void add_slab(pool_t *pool) {
+  if (pool->num_slabs == pool->slabs_capacity) {
+    pool->slabs_capacity *= 2;
+    pool->slabs = realloc(pool->slabs, sizeof(void *) * pool->slabs_capacity);
+    assert(pool->slabs);
+  }
+  char *slab = malloc(pool->block_size * pool->blocks_per_slab);
+  assert(slab);
+  pool->slabs[pool->num_slabs++] = slab;
+
+  // Push in reverse so blocks are handed out in address order
+  for (size_t i = pool->blocks_per_slab; i-- > 0;) {
+    free_block_t *block = (free_block_t *)(slab + i * pool->block_size);
+    block->next = pool->free_list;
+    pool->free_list = block;
+  }
+}
+
+void *pool_alloc(pool_t *pool) {
+  if (pool->free_list == NULL) {
+    add_slab(pool);
+  }
+  free_block_t *block = pool->free_list;
+  pool->free_list = block->next;
+  pool->in_use++;
+  if (pool->in_use > pool->peak_in_use) {
+    pool->peak_in_use = pool->in_use;
+  }
+  return block;
+}
+
+void pool_release(pool_t *pool, void *block) {
+  assert(pool->in_use > 0);
+  free_block_t *freed = block;
+  freed->next = pool->free_list;
+  pool->free_list = freed;
+  pool->in_use--;
+}
+
+pool_stats_t pool_get_stats(pool_t *pool) {
+  return (pool_stats_t){.block_size = pool->block_size,
+                        .num_slabs = pool->num_slabs,
+                        .capacity = pool->num_slabs * pool->blocks_per_slab,
+                        .in_use = pool->in_use,
+                        .peak_in_use = pool->peak_in_use};
+}
+
+void pool_free(pool_t *pool) {
+  for (size_t i = 0; i < pool->num_slabs; i++) {
+    free(pool->slabs[i]);
+  }
+  free(pool->slabs);
+  free(pool);
+}
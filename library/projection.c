@@ -0,0 +1,117 @@
+#include "projection.h"
+
+#include <assert.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// vector_t is read as two packed doubles, so it must have no padding
+_Static_assert(sizeof(vector_t) == 2 * sizeof(double),
+               "vector_t must be two packed doubles");
+
+/**
+ * Extends a projection range with the vertices from `start` onwards,
+ * one vertex at a time.
+ *
+ * @param vertices the array of vertices
+ * @param start the index of the first vertex to project
+ * @param num_vertices the number of vertices
+ * @param unit_axis the axis to project on
+ * @param min the running minimum projection, updated in place
+ * @param max the running maximum projection, updated in place
+ */
+static void project_scalar(const vector_t *vertices, size_t start,
+                           size_t num_vertices, vector_t unit_axis,
+                           double *min, double *max) {
+  for (size_t i = start; i < num_vertices; i++) {
+    double projection =
+        vertices[i].x * unit_axis.x + vertices[i].y * unit_axis.y;
+    if (projection < *min) {
+      *min = projection;
+    }
+    if (projection > *max) {
+      *max = projection;
+    }
+  }
+}
+
+#if defined(__AVX__)
+
+vector_t project_vertices(const vector_t *vertices, size_t num_vertices,
+                          vector_t unit_axis) {
+  assert(num_vertices > 0);
+  const double *coords = (const double *)vertices;
+  __m256d axis_x = _mm256_set1_pd(unit_axis.x);
+  __m256d axis_y = _mm256_set1_pd(unit_axis.y);
+  __m256d min = _mm256_set1_pd(__DBL_MAX__);
+  __m256d max = _mm256_set1_pd(-__DBL_MAX__);
+
+  size_t i = 0;
+  for (; i + 4 <= num_vertices; i += 4) {
+    // Four interleaved vertices become (x0, x2, x1, x3), (y0, y2, y1, y3);
+    // the lane order does not matter for a min/max reduction
+    __m256d v01 = _mm256_loadu_pd(coords + 2 * i);
+    __m256d v23 = _mm256_loadu_pd(coords + 2 * i + 4);
+    __m256d xs = _mm256_unpacklo_pd(v01, v23);
+    __m256d ys = _mm256_unpackhi_pd(v01, v23);
+    __m256d projection = _mm256_add_pd(_mm256_mul_pd(xs, axis_x),
+                                       _mm256_mul_pd(ys, axis_y));
+    min = _mm256_min_pd(min, projection);
+    max = _mm256_max_pd(max, projection);
+  }
+
+  __m128d min2 = _mm_min_pd(_mm256_castpd256_pd128(min),
+                            _mm256_extractf128_pd(min, 1));
+  __m128d max2 = _mm_max_pd(_mm256_castpd256_pd128(max),
+                            _mm256_extractf128_pd(max, 1));
+  double lo = _mm_cvtsd_f64(_mm_min_sd(min2, _mm_unpackhi_pd(min2, min2)));
+  double hi = _mm_cvtsd_f64(_mm_max_sd(max2, _mm_unpackhi_pd(max2, max2)));
+  project_scalar(vertices, i, num_vertices, unit_axis, &lo, &hi);
+  return (vector_t){.x = lo, .y = hi};
+}
+
+#elif defined(__SSE2__)
+
+vector_t project_vertices(const vector_t *vertices, size_t num_vertices,
+                          vector_t unit_axis) {
+  assert(num_vertices > 0);
+  const double *coords = (const double *)vertices;
+  __m128d axis_x = _mm_set1_pd(unit_axis.x);
+  __m128d axis_y = _mm_set1_pd(unit_axis.y);
+  __m128d min = _mm_set1_pd(__DBL_MAX__);
+  __m128d max = _mm_set1_pd(-__DBL_MAX__);
+
+  size_t i = 0;
+  for (; i + 2 <= num_vertices; i += 2) {
+    // Two interleaved vertices (x0, y0), (x1, y1) become (x0, x1), (y0, y1)
+    __m128d v0 = _mm_loadu_pd(coords + 2 * i);
+    __m128d v1 = _mm_loadu_pd(coords + 2 * i + 2);
+    __m128d xs = _mm_unpacklo_pd(v0, v1);
+    __m128d ys = _mm_unpackhi_pd(v0, v1);
+    __m128d projection =
+        _mm_add_pd(_mm_mul_pd(xs, axis_x), _mm_mul_pd(ys, axis_y));
+    min = _mm_min_pd(min, projection);
+    max = _mm_max_pd(max, projection);
+  }
+
+  double lo = _mm_cvtsd_f64(_mm_min_sd(min, _mm_unpackhi_pd(min, min)));
+  double hi = _mm_cvtsd_f64(_mm_max_sd(max, _mm_unpackhi_pd(max, max)));
+  project_scalar(vertices, i, num_vertices, unit_axis, &lo, &hi);
+  return (vector_t){.x = lo, .y = hi};
+}
+
+#else
+
+vector_t project_vertices(const vector_t *vertices, size_t num_vertices,
+                          vector_t unit_axis) {
+  assert(num_vertices > 0);
+  double lo = __DBL_MAX__;
+  double hi = -__DBL_MAX__;
+  project_scalar(vertices, 0, num_vertices, unit_axis, &lo, &hi);
+  return (vector_t){.x = lo, .y = hi};
+}
+
+#endif
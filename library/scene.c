@@ -0,0 +1,1336 @@
+#include "scene.h"
+#include "asset.h"
+#include "collision.h"
+#include "spatial_hash.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t SCENE_INIT_SIZE = 10;
+
+const body_handle_t BODY_HANDLE_NONE = {.index = 0, .generation = 0};
+
+/**
+ * Tags must be less than this, so the bucket array stays small.
+ */
+const uint32_t SCENE_MAX_TAGS = 256;
+
+/**
+ * Marks the end of the list of free handle slots.
+ */
+const uint32_t NO_FREE_SLOT = UINT32_MAX;
+
+/**
+ * Initial number of entries in the table from bodies to their handle slots.
+ * Must be a power of two.
+ */
+const size_t SCENE_BODY_TABLE_INIT_CAPACITY = 32;
+
+/**
+ * The most isolated force creators one job runs when a scene is ticked
+ * on a job pool.
+ */
+const size_t SCENE_CREATOR_CHUNK_SIZE = 64;
+
+struct force;
+
+/**
+ * A force creator acting on a body, listed in the body's handle slot.
+ */
+typedef struct creator_ref {
+  struct force *force;
+  // The index of the matching link in the force creator's links
+  size_t link;
+} creator_ref_t;
+
+/**
+ * A body a force creator acts on: the body's handle slot and where the
+ * force creator is listed in that slot.
+ */
+typedef struct creator_link {
+  uint32_t slot;
+  size_t position;
+} creator_link_t;
+
+/**
+ * An entry in the handle table. A slot is reused for a new body once its
+ * body is freed, with a new generation so old handles stop resolving.
+ */
+typedef struct handle_slot {
+  // The body the slot refers to, or NULL while the slot is free
+  body_t *body;
+  // Odd while the slot is in use; handles never have generation 0
+  uint32_t generation;
+  // The next free slot, while this slot is free
+  uint32_t next_free;
+  // Where the body is in the bucket for its tag, if it has one
+  size_t tag_position;
+  // The force creators acting on the body, so removing it only has to
+  // visit those
+  creator_ref_t *creators;
+  size_t num_creators;
+  size_t creators_capacity;
+  // While isolated force creators are scheduled, one past the level of the
+  // last one acting on the body; 0 otherwise
+  size_t creator_level;
+  // The number of snapshots holding the body
+  size_t pins;
+  // Whether the body was removed from the scene but is kept, along with the
+  // slot, for the snapshots holding it
+  bool retired;
+  // Set while scene_restore() keeps the body
+  bool restoring;
+} handle_slot_t;
+
+/**
+ * The handle slots of every body in a scene with one tag.
+ */
+typedef struct tag_bucket {
+  uint32_t *slots;
+  size_t size;
+  size_t capacity;
+} tag_bucket_t;
+
+/**
+ * A force creator registered with the scene, along with the bodies it acts on.
+ */
+typedef struct force {
+  force_creator_t force_creator;
+  void *aux;
+  list_t *bodies;
+  free_func_t freer;
+  // The handle slots of the bodies that were in the scene when the force
+  // creator was added
+  creator_link_t *links;
+  size_t num_links;
+  // Whether some of the bodies were not in the scene yet, so removals
+  // must also check the list of bodies
+  bool unlinked;
+  // Whether one of the bodies was removed; freed at the end of the tick
+  bool removed;
+  // Whether the force creator only touches its own bodies' motion state,
+  // so it can run alongside creators acting on other bodies
+  bool isolated;
+  // The round the force creator runs in, while isolated creators are
+  // scheduled
+  size_t level;
+  // The number of snapshots holding the force creator; while it is held,
+  // it is kept after its bodies are removed
+  size_t pins;
+  // Set while scene_restore() keeps the force creator
+  bool restoring;
+} force_t;
+
+struct scene {
+  size_t num_bodies;
+  // The bodies in the order they were added
+  body_t **bodies;
+  // The handle slot of each body, parallel to bodies
+  uint32_t *body_slots;
+  size_t bodies_capacity;
+  handle_slot_t *slots;
+  size_t num_slots;
+  size_t slots_capacity;
+  uint32_t first_free_slot;
+  // Buckets indexed by tag, up to the largest tag seen
+  tag_bucket_t *tag_buckets;
+  size_t num_tag_buckets;
+  // The bodies' motion state, integrated in one pass each tick
+  body_store_t *body_store;
+  // Open-addressing table of handle slots, plus one, keyed by body;
+  // 0 marks an empty entry. Has at least twice as many entries as bodies.
+  uint32_t *body_table;
+  size_t body_table_capacity;
+  // The force creators in the order they were added
+  force_t **forces;
+  size_t num_forces;
+  size_t forces_capacity;
+  size_t num_unlinked_forces;
+  // Runs isolated force creators and body integration in parallel,
+  // or NULL to tick on the calling thread
+  job_pool_t *job_pool;
+  // Isolated force creators grouped by level, and where each level starts
+  force_t **schedule;
+  size_t *level_starts;
+  size_t schedule_capacity;
+  // Broad phase for collision creators; NULL unless enabled
+  spatial_hash_t *spatial_hash;
+  // Whether spatial_hash reflects the current body positions
+  bool spatial_hash_ready;
+  // Whether spatial_hash can answer spatial queries. scene_tick() keeps
+  // the grid up to date; otherwise it is built by the next query.
+  bool query_index_ready;
+  // Bodies at this index or later were added since the grid was built
+  size_t num_indexed_bodies;
+  // Scratch space for the bodies found along a ray
+  body_t **query_buffer;
+  size_t query_buffer_capacity;
+  // The number of snapshots of the scene that have not been freed
+  size_t num_snapshots;
+};
+
+/**
+ * A body held by a snapshot, along with its handle slot and the state to
+ * put it back in.
+ */
+typedef struct snapshot_body {
+  body_t *body;
+  uint32_t slot;
+  body_state_t state;
+} snapshot_body_t;
+
+struct scene_snapshot {
+  scene_t *scene;
+  // The bodies in the order they were in the scene, in one array
+  snapshot_body_t *bodies;
+  size_t num_bodies;
+  // The force creators in the order they were in the scene
+  force_t **forces;
+  size_t num_forces;
+};
+
+/**
+ * Frees a force creator's aux value and its list of bodies.
+ *
+ * @param force the force creator to free
+ */
+static void force_free(force_t *force) {
+  if (force->freer != NULL) {
+    force->freer(force->aux);
+  }
+  list_free(force->bodies);
+  free(force->links);
+  free(force);
+}
+
+scene_t *scene_init(void) {
+  scene_t *scene = malloc(sizeof(scene_t));
+  assert(scene);
+  scene->num_bodies = 0;
+  scene->bodies = malloc(sizeof(body_t *) * SCENE_INIT_SIZE);
+  scene->body_slots = malloc(sizeof(uint32_t) * SCENE_INIT_SIZE);
+  scene->bodies_capacity = SCENE_INIT_SIZE;
+  scene->slots = malloc(sizeof(handle_slot_t) * SCENE_INIT_SIZE);
+  assert(scene->bodies && scene->body_slots && scene->slots);
+  scene->num_slots = 0;
+  scene->slots_capacity = SCENE_INIT_SIZE;
+  scene->first_free_slot = NO_FREE_SLOT;
+  scene->tag_buckets = NULL;
+  scene->num_tag_buckets = 0;
+  scene->body_store = body_store_init();
+  scene->body_table =
+      calloc(SCENE_BODY_TABLE_INIT_CAPACITY, sizeof(uint32_t));
+  scene->body_table_capacity = SCENE_BODY_TABLE_INIT_CAPACITY;
+  scene->forces = malloc(sizeof(force_t *) * SCENE_INIT_SIZE);
+  assert(scene->body_table && scene->forces);
+  scene->num_forces = 0;
+  scene->forces_capacity = SCENE_INIT_SIZE;
+  scene->num_unlinked_forces = 0;
+  scene->job_pool = NULL;
+  scene->schedule = NULL;
+  scene->level_starts = NULL;
+  scene->schedule_capacity = 0;
+  scene->spatial_hash = NULL;
+  scene->spatial_hash_ready = false;
+  scene->query_index_ready = false;
+  scene->num_indexed_bodies = 0;
+  scene->query_buffer = malloc(sizeof(body_t *) * SCENE_INIT_SIZE);
+  assert(scene->query_buffer);
+  scene->query_buffer_capacity = SCENE_INIT_SIZE;
+  scene->num_snapshots = 0;
+  return scene;
+}
+
+size_t scene_bodies(scene_t *scene) { return scene->num_bodies; }
+
+body_t *scene_get_body(scene_t *scene, size_t index) {
+  assert(index < scene->num_bodies);
+  return scene->bodies[index];
+}
+
+/**
+ * Takes a free handle slot for a body, growing the table if none is free.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body the body the slot will refer to
+ * @return the index of the slot
+ */
+static uint32_t take_slot(scene_t *scene, body_t *body) {
+  uint32_t index = scene->first_free_slot;
+  if (index != NO_FREE_SLOT) {
+    scene->first_free_slot = scene->slots[index].next_free;
+  } else {
+    if (scene->num_slots == scene->slots_capacity) {
+      scene->slots_capacity *= 2;
+      scene->slots = realloc(scene->slots,
+                             sizeof(handle_slot_t) * scene->slots_capacity);
+      assert(scene->slots);
+    }
+    index = scene->num_slots++;
+    scene->slots[index].generation = 0;
+    scene->slots[index].creators = NULL;
+    scene->slots[index].num_creators = 0;
+    scene->slots[index].creators_capacity = 0;
+    scene->slots[index].creator_level = 0;
+    scene->slots[index].pins = 0;
+    scene->slots[index].retired = false;
+    scene->slots[index].restoring = false;
+  }
+  scene->slots[index].body = body;
+  scene->slots[index].generation++;
+  return index;
+}
+
+/**
+ * Returns a handle slot to the free list once its body is freed.
+ * Bumps the generation so handles to the old body no longer resolve.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the index of the slot
+ */
+static void release_slot(scene_t *scene, uint32_t index) {
+  handle_slot_t *slot = &scene->slots[index];
+  slot->body = NULL;
+  slot->generation++;
+  slot->next_free = scene->first_free_slot;
+  scene->first_free_slot = index;
+}
+
+/**
+ * Hashes a body pointer for the table from bodies to handle slots.
+ *
+ * @param body a pointer to a body
+ * @return the hash of the pointer
+ */
+static uint64_t hash_body(body_t *body) {
+  uint64_t h = (uint64_t)(uintptr_t)body * 0x9E3779B97F4A7C15ULL;
+  return h ^ (h >> 29);
+}
+
+/**
+ * Finds the table entry for a body, or the empty entry where it would go.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body a pointer to a body
+ * @return the index of the entry in the body table
+ */
+static size_t find_body_entry(scene_t *scene, body_t *body) {
+  size_t mask = scene->body_table_capacity - 1;
+  size_t i = hash_body(body) & mask;
+  while (scene->body_table[i] != 0 &&
+         scene->slots[scene->body_table[i] - 1].body != body) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+/**
+ * Records which handle slot a body is in, growing the body table if needed.
+ * The table is kept at most half full so probes stay short.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param slot the index of the body's handle slot
+ */
+static void map_body_slot(scene_t *scene, uint32_t slot) {
+  if (2 * (scene->num_bodies + 1) > scene->body_table_capacity) {
+    uint32_t *old_table = scene->body_table;
+    size_t old_capacity = scene->body_table_capacity;
+    scene->body_table_capacity *= 2;
+    scene->body_table = calloc(scene->body_table_capacity, sizeof(uint32_t));
+    assert(scene->body_table);
+    for (size_t i = 0; i < old_capacity; i++) {
+      if (old_table[i] != 0) {
+        body_t *body = scene->slots[old_table[i] - 1].body;
+        scene->body_table[find_body_entry(scene, body)] = old_table[i];
+      }
+    }
+    free(old_table);
+  }
+  body_t *body = scene->slots[slot].body;
+  scene->body_table[find_body_entry(scene, body)] = slot + 1;
+}
+
+/**
+ * Finds the handle slot of a body in a scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body a pointer to a body
+ * @return the index of the body's handle slot,
+ *   or NO_FREE_SLOT if the body is not in the scene
+ */
+static uint32_t find_body_slot(scene_t *scene, body_t *body) {
+  return scene->body_table[find_body_entry(scene, body)] - 1;
+}
+
+/**
+ * Removes a body from the body table. Shifts later entries of the same
+ * probe sequence back so lookups never stop at the gap.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body a pointer to a body in the scene
+ */
+static void unmap_body_slot(scene_t *scene, body_t *body) {
+  size_t mask = scene->body_table_capacity - 1;
+  size_t gap = find_body_entry(scene, body);
+  assert(scene->body_table[gap] != 0);
+  for (size_t i = (gap + 1) & mask; scene->body_table[i] != 0;
+       i = (i + 1) & mask) {
+    body_t *other = scene->slots[scene->body_table[i] - 1].body;
+    size_t home = hash_body(other) & mask;
+    // The entry can fill the gap unless its home lies between the two
+    if (((i - home) & mask) >= ((i - gap) & mask)) {
+      scene->body_table[gap] = scene->body_table[i];
+      gap = i;
+    }
+  }
+  scene->body_table[gap] = 0;
+}
+
+/**
+ * Lists a force creator in the handle slot of one of its bodies.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param force the force creator
+ * @param slot the index of the body's handle slot
+ */
+static void link_creator(scene_t *scene, force_t *force, uint32_t slot) {
+  handle_slot_t *handle_slot = &scene->slots[slot];
+  if (handle_slot->num_creators == handle_slot->creators_capacity) {
+    handle_slot->creators_capacity = handle_slot->creators_capacity == 0
+                                         ? SCENE_INIT_SIZE
+                                         : 2 * handle_slot->creators_capacity;
+    handle_slot->creators =
+        realloc(handle_slot->creators,
+                sizeof(creator_ref_t) * handle_slot->creators_capacity);
+    assert(handle_slot->creators);
+  }
+  size_t link = force->num_links++;
+  force->links[link] = (creator_link_t){
+      .slot = slot, .position = handle_slot->num_creators};
+  handle_slot->creators[handle_slot->num_creators++] =
+      (creator_ref_t){.force = force, .link = link};
+}
+
+/**
+ * Marks a force creator as removed and takes it out of the handle slots of
+ * its bodies. Each slot moves its last entry into the gap, so this is
+ * constant time per body.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param force the force creator
+ */
+static void unlink_creator(scene_t *scene, force_t *force) {
+  for (size_t i = 0; i < force->num_links; i++) {
+    creator_link_t link = force->links[i];
+    handle_slot_t *handle_slot = &scene->slots[link.slot];
+    size_t last = --handle_slot->num_creators;
+    if (link.position != last) {
+      creator_ref_t moved = handle_slot->creators[last];
+      handle_slot->creators[link.position] = moved;
+      moved.force->links[moved.link].position = link.position;
+    }
+  }
+  force->num_links = 0;
+  force->removed = true;
+}
+
+/**
+ * Adds a body's handle slot to the bucket for its tag,
+ * creating buckets up to that tag if needed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param slot the index of the body's handle slot
+ * @param tag the body's tag; not BODY_TAG_NONE
+ */
+static void add_to_tag_bucket(scene_t *scene, uint32_t slot, uint32_t tag) {
+  assert(tag < SCENE_MAX_TAGS);
+  if (tag >= scene->num_tag_buckets) {
+    scene->tag_buckets =
+        realloc(scene->tag_buckets, sizeof(tag_bucket_t) * (tag + 1));
+    assert(scene->tag_buckets);
+    for (size_t i = scene->num_tag_buckets; i <= tag; i++) {
+      scene->tag_buckets[i] = (tag_bucket_t){
+          .slots = NULL, .size = 0, .capacity = 0};
+    }
+    scene->num_tag_buckets = tag + 1;
+  }
+  tag_bucket_t *bucket = &scene->tag_buckets[tag];
+  if (bucket->size == bucket->capacity) {
+    bucket->capacity =
+        bucket->capacity == 0 ? SCENE_INIT_SIZE : bucket->capacity * 2;
+    bucket->slots =
+        realloc(bucket->slots, sizeof(uint32_t) * bucket->capacity);
+    assert(bucket->slots);
+  }
+  scene->slots[slot].tag_position = bucket->size;
+  bucket->slots[bucket->size++] = slot;
+}
+
+/**
+ * Removes a body's handle slot from the bucket for its tag,
+ * moving the bucket's last entry into its place.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param slot the index of the body's handle slot
+ * @param tag the body's tag; not BODY_TAG_NONE
+ */
+static void remove_from_tag_bucket(scene_t *scene, uint32_t slot,
+                                   uint32_t tag) {
+  tag_bucket_t *bucket = &scene->tag_buckets[tag];
+  size_t position = scene->slots[slot].tag_position;
+  uint32_t moved = bucket->slots[--bucket->size];
+  bucket->slots[position] = moved;
+  scene->slots[moved].tag_position = position;
+}
+
+/**
+ * Appends a body to a scene under a handle slot already taken for it,
+ * indexes it, and moves its motion state into the scene's store.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body the body
+ * @param slot the index of the body's handle slot
+ */
+static void insert_body(scene_t *scene, body_t *body, uint32_t slot) {
+  if (scene->num_bodies == scene->bodies_capacity) {
+    scene->bodies_capacity *= 2;
+    scene->bodies = realloc(scene->bodies,
+                            sizeof(body_t *) * scene->bodies_capacity);
+    scene->body_slots = realloc(scene->body_slots,
+                                sizeof(uint32_t) * scene->bodies_capacity);
+    assert(scene->bodies && scene->body_slots);
+  }
+  map_body_slot(scene, slot);
+  scene->bodies[scene->num_bodies] = body;
+  scene->body_slots[scene->num_bodies] = slot;
+  scene->num_bodies++;
+  if (body_get_tag(body) != BODY_TAG_NONE) {
+    add_to_tag_bucket(scene, slot, body_get_tag(body));
+  }
+  body_store_add(scene->body_store, body);
+}
+
+body_handle_t scene_add_body(scene_t *scene, body_t *body) {
+  uint32_t slot = take_slot(scene, body);
+  insert_body(scene, body, slot);
+  return (body_handle_t){.index = slot,
+                         .generation = scene->slots[slot].generation};
+}
+
+body_t *scene_resolve(scene_t *scene, body_handle_t handle) {
+  if (handle.index >= scene->num_slots) {
+    return NULL;
+  }
+  handle_slot_t *slot = &scene->slots[handle.index];
+  if (slot->generation != handle.generation || body_is_removed(slot->body)) {
+    return NULL;
+  }
+  return slot->body;
+}
+
+bool scene_remove_handle(scene_t *scene, body_handle_t handle) {
+  body_t *body = scene_resolve(scene, handle);
+  if (body == NULL) {
+    return false;
+  }
+  body_remove(body);
+  return true;
+}
+
+size_t scene_count_tagged(scene_t *scene, uint32_t tag) {
+  if (tag >= scene->num_tag_buckets) {
+    return 0;
+  }
+  return scene->tag_buckets[tag].size;
+}
+
+void scene_for_each_tagged(scene_t *scene, uint32_t tag, body_func_t func,
+                           void *aux) {
+  // func may add bodies, which are left for the next call, and may grow
+  // the buckets, so the bucket is looked up again for each body
+  size_t count = scene_count_tagged(scene, tag);
+  for (size_t i = 0; i < count; i++) {
+    uint32_t slot = scene->tag_buckets[tag].slots[i];
+    body_t *body = scene->slots[slot].body;
+    if (!body_is_removed(body)) {
+      func(body, aux);
+    }
+  }
+}
+
+void scene_remove_body(scene_t *scene, size_t index) {
+  assert(index < scene->num_bodies);
+  body_remove(scene->bodies[index]);
+}
+
+/**
+ * Indexes a force creator under each of its bodies that is in the scene,
+ * and records whether any of them are not.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param force a force creator that is not indexed under any body
+ */
+static void link_force(scene_t *scene, force_t *force) {
+  force->unlinked = false;
+  size_t num_bodies = list_size(force->bodies);
+  for (size_t i = 0; i < num_bodies; i++) {
+    uint32_t slot = find_body_slot(scene, list_get(force->bodies, i));
+    if (slot == NO_FREE_SLOT) {
+      force->unlinked = true;
+    } else {
+      link_creator(scene, force, slot);
+    }
+  }
+}
+
+/**
+ * Registers a force creator with a scene and indexes it under its bodies.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param force_creator a force creator function
+ * @param aux an auxiliary value to pass to `force_creator` when it is called
+ * @param bodies the list of bodies affected by the force creator
+ * @param freer the function to free the aux object if it is not NULL
+ * @param isolated whether the force creator only touches its bodies
+ */
+static void add_force(scene_t *scene, force_creator_t force_creator,
+                      void *aux, list_t *bodies, free_func_t freer,
+                      bool isolated) {
+  force_t *force = malloc(sizeof(force_t));
+  assert(force);
+  force->force_creator = force_creator;
+  force->aux = aux;
+  force->bodies = bodies;
+  force->freer = freer;
+  size_t num_bodies = list_size(bodies);
+  force->links =
+      num_bodies == 0 ? NULL : malloc(sizeof(creator_link_t) * num_bodies);
+  assert(num_bodies == 0 || force->links);
+  force->num_links = 0;
+  force->removed = false;
+  force->isolated = isolated;
+  force->level = 0;
+  force->pins = 0;
+  force->restoring = false;
+  link_force(scene, force);
+  if (force->unlinked) {
+    scene->num_unlinked_forces++;
+  }
+
+  if (scene->num_forces == scene->forces_capacity) {
+    scene->forces_capacity *= 2;
+    scene->forces =
+        realloc(scene->forces, sizeof(force_t *) * scene->forces_capacity);
+    assert(scene->forces);
+  }
+  scene->forces[scene->num_forces++] = force;
+}
+
+void scene_add_force_creator(scene_t *scene, force_creator_t force_creator,
+                             void *aux, list_t *bodies, free_func_t freer) {
+  add_force(scene, force_creator, aux, bodies, freer, false);
+}
+
+void scene_add_isolated_force_creator(scene_t *scene,
+                                      force_creator_t force_creator,
+                                      void *aux, list_t *bodies,
+                                      free_func_t freer) {
+  add_force(scene, force_creator, aux, bodies, freer, true);
+}
+
+void scene_set_job_pool(scene_t *scene, job_pool_t *pool) {
+  scene->job_pool = pool;
+}
+
+void scene_enable_spatial_hash(scene_t *scene, double cell_size) {
+  if (scene->spatial_hash != NULL) {
+    spatial_hash_free(scene->spatial_hash);
+  }
+  scene->spatial_hash = spatial_hash_init(cell_size);
+  scene->spatial_hash_ready = false;
+  scene->query_index_ready = false;
+}
+
+bool scene_bodies_may_collide(scene_t *scene, body_t *body1, body_t *body2) {
+  if (!scene->spatial_hash_ready) {
+    return true;
+  }
+  return spatial_hash_may_collide(scene->spatial_hash, body1, body2);
+}
+
+void scene_for_each_candidate_pair(scene_t *scene, body_pair_func_t func,
+                                   void *aux) {
+  if (scene->spatial_hash_ready) {
+    size_t num_pairs = spatial_hash_num_pairs(scene->spatial_hash);
+    for (size_t i = 0; i < num_pairs; i++) {
+      body_t *body1, *body2;
+      spatial_hash_get_pair(scene->spatial_hash, i, &body1, &body2);
+      if (!body_is_removed(body1) && !body_is_removed(body2)) {
+        func(body1, body2, aux);
+      }
+    }
+    return;
+  }
+
+  // func may add bodies, which are left for the next call
+  size_t num_bodies = scene->num_bodies;
+  for (size_t i = 0; i < num_bodies; i++) {
+    body_t *body1 = scene->bodies[i];
+    for (size_t j = i + 1; j < num_bodies && !body_is_removed(body1); j++) {
+      body_t *body2 = scene->bodies[j];
+      if (!body_is_removed(body2)) {
+        func(body1, body2, aux);
+      }
+    }
+  }
+}
+
+/**
+ * Builds the grid for spatial queries if it is missing or stale.
+ * Does nothing if the spatial hash is disabled.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the index of the first body not in the grid; bodies from there on
+ *   must be searched directly
+ */
+static size_t update_query_index(scene_t *scene) {
+  if (scene->spatial_hash == NULL) {
+    return 0;
+  }
+  if (!scene->query_index_ready) {
+    spatial_hash_index(scene->spatial_hash, scene->bodies,
+                       scene->num_bodies);
+    scene->query_index_ready = true;
+    scene->num_indexed_bodies = scene->num_bodies;
+  }
+  return scene->num_indexed_bodies;
+}
+
+size_t scene_query_aabb(scene_t *scene, aabb_t region, body_t **results,
+                        size_t max_results) {
+  size_t first_unindexed = update_query_index(scene);
+  size_t count = 0;
+  if (scene->spatial_hash != NULL) {
+    count = spatial_hash_query_aabb(scene->spatial_hash, region, results,
+                                    max_results);
+  }
+  for (size_t i = first_unindexed; i < scene->num_bodies; i++) {
+    body_t *body = scene->bodies[i];
+    if (!body_is_removed(body) &&
+        aabb_overlaps(body_get_aabb(body), region)) {
+      if (count < max_results) {
+        results[count] = body;
+      }
+      count++;
+    }
+  }
+  return count;
+}
+
+body_t *scene_nearest(scene_t *scene, vector_t point, double max_distance,
+                      body_filter_t filter, void *aux) {
+  size_t first_unindexed = update_query_index(scene);
+  body_t *best = NULL;
+  double best_distance = max_distance;
+  if (scene->spatial_hash != NULL) {
+    best = spatial_hash_nearest(scene->spatial_hash, point, max_distance,
+                                filter, aux);
+    if (best != NULL) {
+      best_distance =
+          vec_get_length(vec_subtract(body_get_centroid(best), point));
+    }
+  }
+  for (size_t i = first_unindexed; i < scene->num_bodies; i++) {
+    body_t *body = scene->bodies[i];
+    if (body_is_removed(body) || (filter != NULL && !filter(body, aux))) {
+      continue;
+    }
+    double distance =
+        vec_get_length(vec_subtract(body_get_centroid(body), point));
+    bool nearer = best == NULL ? distance <= max_distance
+                               : distance < best_distance;
+    if (nearer) {
+      best = body;
+      best_distance = distance;
+    }
+  }
+  return best;
+}
+
+/**
+ * Casts a ray at one body, adding it to a sorted list of hits if the ray
+ * meets it nearer than the farthest hit kept. A body already in the list
+ * is not added again.
+ *
+ * @param body the body to test
+ * @param origin the start of the ray
+ * @param direction the unit direction of the ray
+ * @param max_distance how far along the ray to look
+ * @param hits the hits found so far, nearest first
+ * @param num_hits the number of hits found so far, updated in place
+ * @param max_hits the size of `hits`
+ */
+static void add_ray_hit(body_t *body, vector_t origin, vector_t direction,
+                        double max_distance, raycast_hit_t *hits,
+                        size_t *num_hits, size_t max_hits) {
+  if (body_is_removed(body)) {
+    return;
+  }
+  for (size_t i = 0; i < *num_hits; i++) {
+    if (hits[i].body == body) {
+      return;
+    }
+  }
+  if (*num_hits == max_hits) {
+    max_distance = fmin(max_distance, hits[max_hits - 1].distance);
+  }
+  double distance;
+  if (!find_ray_collision(body, origin, direction, max_distance, &distance)) {
+    return;
+  }
+  if (*num_hits == max_hits) {
+    if (distance >= hits[max_hits - 1].distance) {
+      return;
+    }
+    (*num_hits)--;
+  }
+  size_t i = *num_hits;
+  for (; i > 0 && hits[i - 1].distance > distance; i--) {
+    hits[i] = hits[i - 1];
+  }
+  hits[i] = (raycast_hit_t){.body = body, .distance = distance};
+  (*num_hits)++;
+}
+
+/**
+ * Finds the bodies whose bounding boxes overlap a region, storing them in
+ * the scene's query buffer, which grows to fit them all.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param region the region to search
+ * @return the number of bodies in the query buffer
+ */
+static size_t query_into_buffer(scene_t *scene, aabb_t region) {
+  size_t count =
+      spatial_hash_query_aabb(scene->spatial_hash, region,
+                              scene->query_buffer,
+                              scene->query_buffer_capacity);
+  if (count > scene->query_buffer_capacity) {
+    while (scene->query_buffer_capacity < count) {
+      scene->query_buffer_capacity *= 2;
+    }
+    scene->query_buffer =
+        realloc(scene->query_buffer,
+                sizeof(body_t *) * scene->query_buffer_capacity);
+    assert(scene->query_buffer);
+    count = spatial_hash_query_aabb(scene->spatial_hash, region,
+                                    scene->query_buffer,
+                                    scene->query_buffer_capacity);
+  }
+  return count;
+}
+
+size_t scene_raycast(scene_t *scene, vector_t origin, vector_t direction,
+                     double max_distance, raycast_hit_t *hits,
+                     size_t max_hits) {
+  assert(isfinite(max_distance) && max_distance >= 0);
+  double length = vec_get_length(direction);
+  assert(length > 0);
+  direction = vec_multiply(1 / length, direction);
+  if (max_hits == 0) {
+    return 0;
+  }
+
+  size_t first_unindexed = update_query_index(scene);
+  size_t num_hits = 0;
+  if (scene->spatial_hash != NULL) {
+    // March along the ray one cell at a time, testing the bodies near each
+    // step. A body's nearest hit lies in the step that first finds it, so
+    // the march can stop once the hit list is full of nearer hits.
+    double step = spatial_hash_cell_size(scene->spatial_hash);
+    double start = 0;
+    do {
+      double end = fmin(start + step, max_distance);
+      vector_t from = vec_add(origin, vec_multiply(start, direction));
+      vector_t to = vec_add(origin, vec_multiply(end, direction));
+      aabb_t region = {.min = {fmin(from.x, to.x), fmin(from.y, to.y)},
+                       .max = {fmax(from.x, to.x), fmax(from.y, to.y)}};
+      size_t count = query_into_buffer(scene, region);
+      for (size_t i = 0; i < count; i++) {
+        add_ray_hit(scene->query_buffer[i], origin, direction, max_distance,
+                    hits, &num_hits, max_hits);
+      }
+      if (num_hits == max_hits && hits[num_hits - 1].distance <= end) {
+        break;
+      }
+      start = end;
+    } while (start < max_distance);
+  }
+  for (size_t i = first_unindexed; i < scene->num_bodies; i++) {
+    add_ray_hit(scene->bodies[i], origin, direction, max_distance,
+                hits, &num_hits, max_hits);
+  }
+  return num_hits;
+}
+
+/**
+ * Returns whether a body is in a list of bodies.
+ *
+ * @param bodies the list to search
+ * @param body the body to look for
+ * @return whether `body` is in `bodies`
+ */
+static bool contains_body(list_t *bodies, body_t *body) {
+  size_t size = list_size(bodies);
+  for (size_t i = 0; i < size; i++) {
+    if (list_get(bodies, i) == body) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Returns whether a force creator can run alongside others this tick.
+ * Waking a sleeping body moves other bodies around the body store,
+ * so creators acting on sleeping bodies run on their own.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param force the force creator
+ * @return whether the force creator is isolated and all its bodies are
+ *   indexed and awake
+ */
+static bool can_run_in_parallel(scene_t *scene, force_t *force) {
+  if (!force->isolated || force->unlinked) {
+    return false;
+  }
+  for (size_t i = 0; i < force->num_links; i++) {
+    if (body_is_sleeping(scene->slots[force->links[i].slot].body)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Runs a range of the force creators in the schedule.
+ *
+ * @param aux the first force creator of a level in the schedule
+ * @param start the index of the first force creator to run in the level
+ * @param end one past the index of the last force creator to run
+ */
+static void run_scheduled_creators(void *aux, size_t start, size_t end) {
+  force_t **level = aux;
+  for (size_t i = start; i < end; i++) {
+    level[i]->force_creator(level[i]->aux, level[i]->bodies);
+  }
+}
+
+/**
+ * Runs a run of consecutive isolated force creators on the scene's job
+ * pool. Each creator is put one level after the last earlier creator that
+ * shares a body with it, and the levels run one after another, so creators
+ * in a level act on disjoint bodies and each body receives its forces in
+ * the same order as on one thread.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param start the index of the first force creator in the run
+ * @param end one past the index of the last force creator in the run
+ */
+static void run_isolated_creators(scene_t *scene, size_t start, size_t end) {
+  size_t count = end - start;
+  if (count > scene->schedule_capacity) {
+    scene->schedule_capacity = count;
+    scene->schedule =
+        realloc(scene->schedule, sizeof(force_t *) * count);
+    scene->level_starts =
+        realloc(scene->level_starts, sizeof(size_t) * (count + 1));
+    assert(scene->schedule && scene->level_starts);
+  }
+
+  size_t num_levels = 0;
+  for (size_t i = start; i < end; i++) {
+    force_t *force = scene->forces[i];
+    size_t level = 0;
+    for (size_t j = 0; j < force->num_links; j++) {
+      size_t after = scene->slots[force->links[j].slot].creator_level;
+      level = after > level ? after : level;
+    }
+    for (size_t j = 0; j < force->num_links; j++) {
+      scene->slots[force->links[j].slot].creator_level = level + 1;
+    }
+    force->level = level;
+    num_levels = level + 1 > num_levels ? level + 1 : num_levels;
+  }
+
+  // Group the creators by level, keeping their order within each level
+  size_t *level_starts = scene->level_starts;
+  for (size_t level = 0; level <= num_levels; level++) {
+    level_starts[level] = 0;
+  }
+  for (size_t i = start; i < end; i++) {
+    level_starts[scene->forces[i]->level + 1]++;
+  }
+  for (size_t level = 0; level < num_levels; level++) {
+    level_starts[level + 1] += level_starts[level];
+  }
+  for (size_t i = start; i < end; i++) {
+    force_t *force = scene->forces[i];
+    scene->schedule[level_starts[force->level]++] = force;
+  }
+  // Each start was advanced to the next level's start; shift them back
+  for (size_t level = num_levels; level > 0; level--) {
+    level_starts[level] = level_starts[level - 1];
+  }
+  level_starts[0] = 0;
+
+  for (size_t level = 0; level < num_levels; level++) {
+    size_t level_size = level_starts[level + 1] - level_starts[level];
+    job_pool_parallel_for(scene->job_pool, level_size,
+                          SCENE_CREATOR_CHUNK_SIZE, run_scheduled_creators,
+                          scene->schedule + level_starts[level]);
+  }
+
+  for (size_t i = start; i < end; i++) {
+    force_t *force = scene->forces[i];
+    for (size_t j = 0; j < force->num_links; j++) {
+      scene->slots[force->links[j].slot].creator_level = 0;
+    }
+  }
+}
+
+/**
+ * Drops the force creators marked as removed, keeping the others in order.
+ * Each one is freed unless a snapshot holds it.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+static void free_removed_forces(scene_t *scene) {
+  size_t num_kept_forces = 0;
+  for (size_t i = 0; i < scene->num_forces; i++) {
+    force_t *force = scene->forces[i];
+    if (!force->removed) {
+      scene->forces[num_kept_forces++] = force;
+      continue;
+    }
+    if (force->unlinked) {
+      scene->num_unlinked_forces--;
+    }
+    if (force->pins == 0) {
+      force_free(force);
+    }
+  }
+  scene->num_forces = num_kept_forces;
+}
+
+/**
+ * Frees the bodies marked for removal, along with the force creators acting
+ * on them and the assets drawn on them, and packs the rest down in one pass,
+ * keeping their order so indices only shift past removed bodies. A body a
+ * snapshot holds is taken out of the scene but keeps its handle slot, so
+ * scene_restore() can put it back.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+static void free_removed_bodies(scene_t *scene) {
+  // Assets still point at the bodies, so they go first
+  asset_sweep_removed_bodies();
+  size_t num_kept = 0;
+  size_t num_indexed_kept = 0;
+  size_t num_removed_forces = 0;
+  bool removed_any = false;
+  for (size_t i = 0; i < scene->num_bodies; i++) {
+    body_t *body = scene->bodies[i];
+    if (body_is_removed(body)) {
+      // The query grid must let go of the removed bodies before any is freed
+      if (!removed_any && scene->query_index_ready) {
+        spatial_hash_remove_marked(scene->spatial_hash);
+      }
+      removed_any = true;
+      uint32_t slot = scene->body_slots[i];
+      while (scene->slots[slot].num_creators > 0) {
+        unlink_creator(scene, scene->slots[slot].creators[0].force);
+        num_removed_forces++;
+      }
+      // Only force creators added before their bodies need a full scan
+      if (scene->num_unlinked_forces > 0) {
+        for (size_t j = 0; j < scene->num_forces; j++) {
+          force_t *force = scene->forces[j];
+          if (force->unlinked && !force->removed &&
+              contains_body(force->bodies, body)) {
+            unlink_creator(scene, force);
+            num_removed_forces++;
+          }
+        }
+      }
+      if (body_get_tag(body) != BODY_TAG_NONE) {
+        remove_from_tag_bucket(scene, slot, body_get_tag(body));
+      }
+      unmap_body_slot(scene, body);
+      if (scene->slots[slot].pins > 0) {
+        body_store_remove(body);
+        scene->slots[slot].retired = true;
+      } else {
+        release_slot(scene, slot);
+        body_free(body);
+      }
+    } else {
+      scene->bodies[num_kept] = body;
+      scene->body_slots[num_kept] = scene->body_slots[i];
+      num_kept++;
+      if (i < scene->num_indexed_bodies) {
+        num_indexed_kept++;
+      }
+    }
+  }
+  scene->num_bodies = num_kept;
+  scene->num_indexed_bodies = num_indexed_kept;
+
+  if (num_removed_forces > 0) {
+    free_removed_forces(scene);
+  }
+}
+
+void scene_tick(scene_t *scene, double dt) {
+  // Frames drawn before the next tick interpolate from here
+  body_store_save_poses(scene->body_store);
+
+  if (scene->spatial_hash != NULL) {
+    // The last tick left the grid up to date, apart from bodies added or
+    // moved since, so only those need bucketing
+    if (scene->query_index_ready) {
+      spatial_hash_refresh(scene->spatial_hash, scene->bodies,
+                           scene->num_bodies, scene->num_indexed_bodies);
+    } else {
+      spatial_hash_rebuild(scene->spatial_hash, scene->bodies,
+                           scene->num_bodies);
+    }
+    scene->spatial_hash_ready = true;
+    scene->query_index_ready = true;
+    scene->num_indexed_bodies = scene->num_bodies;
+  }
+
+  // Force creators may add more force creators, which run this tick too.
+  // With a job pool, each run of isolated creators is run in parallel;
+  // the other creators run one at a time between the runs.
+  bool parallel =
+      scene->job_pool != NULL && job_pool_num_threads(scene->job_pool) > 1;
+  size_t i = 0;
+  while (i < scene->num_forces) {
+    size_t end = i;
+    if (parallel) {
+      while (end < scene->num_forces &&
+             can_run_in_parallel(scene, scene->forces[end])) {
+        end++;
+      }
+    }
+    if (end - i > SCENE_CREATOR_CHUNK_SIZE) {
+      run_isolated_creators(scene, i, end);
+      i = end;
+      continue;
+    }
+    // Too few creators to be worth scheduling, so run them one at a time
+    end = end > i ? end : i + 1;
+    for (; i < end; i++) {
+      force_t *force = scene->forces[i];
+      force->force_creator(force->aux, force->bodies);
+    }
+  }
+
+  // Bodies move and may be freed below, so the candidate pairs must not
+  // outlive the force pass
+  scene->spatial_hash_ready = false;
+
+  free_removed_bodies(scene);
+
+  // Only live bodies are left, so the store can tick all of them at once
+  body_store_tick_with_jobs(scene->body_store, dt, scene->job_pool);
+
+  // Bring the query grid up to date, so queries before the next tick
+  // do not have to rebuild it
+  if (scene->query_index_ready) {
+    spatial_hash_update(scene->spatial_hash,
+                        scene->bodies + scene->num_indexed_bodies,
+                        scene->num_bodies - scene->num_indexed_bodies);
+    scene->num_indexed_bodies = scene->num_bodies;
+  }
+}
+
+void scene_begin_interpolation(scene_t *scene, double alpha) {
+  body_store_begin_interpolation(scene->body_store, alpha);
+}
+
+void scene_end_interpolation(scene_t *scene) {
+  body_store_end_interpolation(scene->body_store);
+}
+
+scene_snapshot_t *scene_snapshot(scene_t *scene) {
+  scene_snapshot_t *snapshot = malloc(sizeof(scene_snapshot_t));
+  assert(snapshot);
+  snapshot->scene = scene;
+  snapshot->bodies = malloc(sizeof(snapshot_body_t) * scene->num_bodies);
+  snapshot->forces = malloc(sizeof(force_t *) * scene->num_forces);
+  assert((snapshot->bodies || scene->num_bodies == 0) &&
+         (snapshot->forces || scene->num_forces == 0));
+
+  // Bodies already marked for removal are left out, along with the force
+  // creators acting on them
+  snapshot->num_bodies = 0;
+  for (size_t i = 0; i < scene->num_bodies; i++) {
+    body_t *body = scene->bodies[i];
+    if (body_is_removed(body)) {
+      continue;
+    }
+    uint32_t slot = scene->body_slots[i];
+    scene->slots[slot].pins++;
+    snapshot->bodies[snapshot->num_bodies++] = (snapshot_body_t){
+        .body = body, .slot = slot, .state = body_get_state(body)};
+  }
+  snapshot->num_forces = 0;
+  for (size_t i = 0; i < scene->num_forces; i++) {
+    force_t *force = scene->forces[i];
+    bool live = true;
+    for (size_t j = 0; j < list_size(force->bodies) && live; j++) {
+      live = !body_is_removed(list_get(force->bodies, j));
+    }
+    if (live) {
+      force->pins++;
+      snapshot->forces[snapshot->num_forces++] = force;
+    }
+  }
+  scene->num_snapshots++;
+  return snapshot;
+}
+
+void scene_restore(scene_t *scene, scene_snapshot_t *snapshot) {
+  assert(snapshot->scene == scene);
+
+  // Remove the bodies added since the snapshot, along with their force
+  // creators. Bodies the snapshot holds stay, or are kept if removed.
+  for (size_t i = 0; i < snapshot->num_bodies; i++) {
+    scene->slots[snapshot->bodies[i].slot].restoring = true;
+  }
+  for (size_t i = 0; i < scene->num_bodies; i++) {
+    if (!scene->slots[scene->body_slots[i]].restoring) {
+      body_remove(scene->bodies[i]);
+    }
+  }
+  for (size_t i = 0; i < snapshot->num_bodies; i++) {
+    scene->slots[snapshot->bodies[i].slot].restoring = false;
+  }
+  free_removed_bodies(scene);
+
+  // Put back the bodies removed since, under their old handles
+  for (size_t i = 0; i < snapshot->num_bodies; i++) {
+    snapshot_body_t *entry = &snapshot->bodies[i];
+    if (scene->slots[entry->slot].retired) {
+      scene->slots[entry->slot].retired = false;
+      insert_body(scene, entry->body, entry->slot);
+    }
+  }
+
+  // The scene now holds exactly the snapshot's bodies, so their order and
+  // state can be copied back in one pass
+  assert(scene->num_bodies == snapshot->num_bodies);
+  for (size_t i = 0; i < snapshot->num_bodies; i++) {
+    snapshot_body_t *entry = &snapshot->bodies[i];
+    scene->bodies[i] = entry->body;
+    scene->body_slots[i] = entry->slot;
+    body_set_state(entry->body, &entry->state);
+    body_reset_interpolation(entry->body);
+  }
+
+  // Drop the force creators added since, then put back the ones dropped
+  for (size_t i = 0; i < snapshot->num_forces; i++) {
+    snapshot->forces[i]->restoring = true;
+  }
+  bool dropped = false;
+  for (size_t i = 0; i < scene->num_forces; i++) {
+    force_t *force = scene->forces[i];
+    if (!force->restoring) {
+      unlink_creator(scene, force);
+      dropped = true;
+    }
+  }
+  if (dropped) {
+    free_removed_forces(scene);
+  }
+  if (snapshot->num_forces > scene->forces_capacity) {
+    scene->forces_capacity = snapshot->num_forces;
+    scene->forces =
+        realloc(scene->forces, sizeof(force_t *) * scene->forces_capacity);
+    assert(scene->forces);
+  }
+  scene->num_unlinked_forces = 0;
+  for (size_t i = 0; i < snapshot->num_forces; i++) {
+    force_t *force = snapshot->forces[i];
+    force->restoring = false;
+    if (force->removed) {
+      force->removed = false;
+      link_force(scene, force);
+    }
+    if (force->unlinked) {
+      scene->num_unlinked_forces++;
+    }
+    scene->forces[i] = force;
+  }
+  scene->num_forces = snapshot->num_forces;
+
+  scene->spatial_hash_ready = false;
+  scene->query_index_ready = false;
+}
+
+void scene_snapshot_free(scene_snapshot_t *snapshot) {
+  scene_t *scene = snapshot->scene;
+  for (size_t i = 0; i < snapshot->num_bodies; i++) {
+    snapshot_body_t *entry = &snapshot->bodies[i];
+    handle_slot_t *slot = &scene->slots[entry->slot];
+    if (--slot->pins == 0 && slot->retired) {
+      slot->retired = false;
+      release_slot(scene, entry->slot);
+      body_free(entry->body);
+    }
+  }
+  for (size_t i = 0; i < snapshot->num_forces; i++) {
+    force_t *force = snapshot->forces[i];
+    if (--force->pins == 0 && force->removed) {
+      force_free(force);
+    }
+  }
+  scene->num_snapshots--;
+  free(snapshot->bodies);
+  free(snapshot->forces);
+  free(snapshot);
+}
+
+void scene_free(scene_t *scene) {
+  assert(scene->num_snapshots == 0);
+  asset_sweep_removed_bodies();
+  for (size_t i = 0; i < scene->num_bodies; i++) {
+    body_free(scene->bodies[i]);
+  }
+  free(scene->bodies);
+  free(scene->body_slots);
+  for (size_t i = 0; i < scene->num_slots; i++) {
+    free(scene->slots[i].creators);
+  }
+  free(scene->slots);
+  free(scene->body_table);
+  for (size_t i = 0; i < scene->num_tag_buckets; i++) {
+    free(scene->tag_buckets[i].slots);
+  }
+  free(scene->tag_buckets);
+  body_store_free(scene->body_store);
+  for (size_t i = 0; i < scene->num_forces; i++) {
+    force_free(scene->forces[i]);
+  }
+  free(scene->forces);
+  free(scene->schedule);
+  free(scene->level_starts);
+  if (scene->spatial_hash != NULL) {
+    spatial_hash_free(scene->spatial_hash);
+  }
+  free(scene->query_buffer);
+  free(scene);
+}
@@ -182,8 +182,8 @@ void sdl_draw_body(body_t *body) {
     }
   }
 
-  list_t *points = body_get_shape(body);
-  size_t n = list_size(points);
+  shape_view_t shape = body_get_shape_view(body);
+  size_t n = shape.num_vertices;
   assert(n >= 3);
 
   color_t color = body_get_color(body);
@@ -199,8 +199,7 @@ void sdl_draw_body(body_t *body) {
   assert(x_points != NULL && y_points != NULL);
 
   for (size_t i = 0; i < n; i++) {
-    vector_t *vertex = list_get(points, i);
-    vector_t pixel = get_window_position(*vertex, window_center);
+    vector_t pixel = get_window_position(shape.vertices[i], window_center);
     x_points[i] = (int16_t)pixel.x;
     y_points[i] = (int16_t)pixel.y;
   }
@@ -216,7 +215,6 @@ void sdl_draw_body(body_t *body) {
 
   free(x_points);
   free(y_points);
-  list_free(points);
 }
 
 SDL_Texture *sdl_get_image_texture(const char *image_path) {
@@ -262,7 +260,10 @@ void sdl_render_scene(scene_t *scene) {
   size_t body_count = scene_bodies(scene);
   for (size_t i = 0; i < body_count; i++) {
     body_t *body = scene_get_body(scene, i);
-    sdl_draw_body(body);
+    // Removed bodies stay in the scene until its next tick
+    if (!body_is_removed(body)) {
+      sdl_draw_body(body);
+    }
   }
   // sdl_show();
 }
@@ -288,25 +289,17 @@ void sdl_render_text(TTF_Font *font, const char *text, SDL_Rect *rect,
 }
 
 SDL_Rect sdl_get_body_bounding_box(body_t *body) {
-  list_t *verts = body_get_shape(body);
+  aabb_t aabb = body_get_aabb(body);
   vector_t window_center = get_window_center();
 
-  double min_x = __DBL_MAX__, min_y = __DBL_MAX__;
-  double max_x = -__DBL_MAX__, max_y = -__DBL_MAX__;
-
-  for (size_t i = 0; i < list_size(verts); i++) {
-    vector_t scene_v = *(vector_t *)list_get(verts, i);
-    vector_t pixel_v = get_window_position(scene_v, window_center);
-
-    if (pixel_v.x < min_x)
-      min_x = pixel_v.x;
-    if (pixel_v.x > max_x)
-      max_x = pixel_v.x;
-    if (pixel_v.y < min_y)
-      min_y = pixel_v.y;
-    if (pixel_v.y > max_y)
-      max_y = pixel_v.y;
-  }
+  // The y axis is flipped on screen, so the top-left pixel comes from
+  // the box's minimum x and maximum y
+  vector_t top_left =
+      get_window_position((vector_t){aabb.min.x, aabb.max.y}, window_center);
+  vector_t bottom_right =
+      get_window_position((vector_t){aabb.max.x, aabb.min.y}, window_center);
+  double min_x = top_left.x, min_y = top_left.y;
+  double max_x = bottom_right.x, max_y = bottom_right.y;
 
   SDL_Rect box;
   box.x = (int)round(min_x);
@@ -0,0 +1,765 @@
+#include "spatial_hash.h"
+#include "pair_set.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Initial number of (cell, body) entries the grid has room for.
+ */
+const size_t CELL_ENTRIES_INIT_CAPACITY = 64;
+
+/**
+ * Bodies covering more cells than this are not bucketed; instead they are
+ * paired with every other body.
+ */
+const size_t SPATIAL_HASH_MAX_CELLS_PER_BODY = 256;
+
+/**
+ * Cell coordinates are clamped to this magnitude so they fit in 32 bits.
+ */
+const double CELL_COORD_LIMIT = 1e9;
+
+/**
+ * Marks a bucketed body that is dropped when the grid is compacted.
+ */
+const size_t DROPPED_BODY = SIZE_MAX;
+
+/**
+ * A body bucketed into one grid cell.
+ */
+typedef struct cell_entry {
+  uint64_t cell;
+  body_t *body;
+  // The lowest cell indices the body touches, so a region query can report
+  // the body from just one of its cells
+  int32_t first_x;
+  int32_t first_y;
+  // The body's index in the grid's list of bucketed bodies
+  uint32_t body_index;
+} cell_entry_t;
+
+/**
+ * A body bucketed into the grid, with the range of cells it is in,
+ * so an update can tell whether it has moved to other cells.
+ */
+typedef struct bucketed_body {
+  body_t *body;
+  int32_t min_x;
+  int32_t min_y;
+  int32_t max_x;
+  int32_t max_y;
+} bucketed_body_t;
+
+struct spatial_hash {
+  double cell_size;
+  cell_entry_t *entries;
+  size_t num_entries;
+  size_t entries_capacity;
+  // The range of cells holding entries, valid when num_entries > 0
+  int32_t min_cell_x;
+  int32_t min_cell_y;
+  int32_t max_cell_x;
+  int32_t max_cell_y;
+  // The bodies with entries in the grid, in the order they were bucketed,
+  // and scratch space for the index each one has after compaction
+  bucketed_body_t *bucketed;
+  size_t *new_indices;
+  size_t num_bucketed;
+  size_t bucketed_capacity;
+  // Bodies too big to bucket
+  body_t **large;
+  size_t num_large;
+  size_t large_capacity;
+  // Scratch space for spatial_hash_update(): the bodies to bucket again,
+  // and the sorted new entries to merge into the grid
+  body_t **moved;
+  size_t moved_capacity;
+  cell_entry_t *merge_buffer;
+  size_t merge_buffer_capacity;
+  // Bodies bucketed by the last rebuild, each stored paired with itself
+  pair_set_t *indexed;
+  // Distinct pairs of bodies that may be colliding
+  pair_set_t *pairs;
+};
+
+spatial_hash_t *spatial_hash_init(double cell_size) {
+  assert(cell_size > 0);
+  spatial_hash_t *hash = malloc(sizeof(spatial_hash_t));
+  assert(hash);
+  hash->cell_size = cell_size;
+  hash->entries = malloc(sizeof(cell_entry_t) * CELL_ENTRIES_INIT_CAPACITY);
+  assert(hash->entries);
+  hash->num_entries = 0;
+  hash->entries_capacity = CELL_ENTRIES_INIT_CAPACITY;
+  hash->large = malloc(sizeof(body_t *) * CELL_ENTRIES_INIT_CAPACITY);
+  assert(hash->large);
+  hash->num_large = 0;
+  hash->large_capacity = CELL_ENTRIES_INIT_CAPACITY;
+  hash->bucketed = malloc(sizeof(bucketed_body_t) * CELL_ENTRIES_INIT_CAPACITY);
+  hash->new_indices = malloc(sizeof(size_t) * CELL_ENTRIES_INIT_CAPACITY);
+  assert(hash->bucketed && hash->new_indices);
+  hash->num_bucketed = 0;
+  hash->bucketed_capacity = CELL_ENTRIES_INIT_CAPACITY;
+  hash->moved = NULL;
+  hash->moved_capacity = 0;
+  hash->merge_buffer = NULL;
+  hash->merge_buffer_capacity = 0;
+  hash->indexed = pair_set_init();
+  hash->pairs = pair_set_init();
+  return hash;
+}
+
+/**
+ * Converts a world coordinate to the index of the cell containing it.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param coord the x or y world coordinate
+ * @return the cell index along that axis
+ */
+static int32_t cell_coord(spatial_hash_t *hash, double coord) {
+  double cell = floor(coord / hash->cell_size);
+  if (cell > CELL_COORD_LIMIT) {
+    cell = CELL_COORD_LIMIT;
+  } else if (cell < -CELL_COORD_LIMIT) {
+    cell = -CELL_COORD_LIMIT;
+  }
+  return (int32_t)cell;
+}
+
+/**
+ * Packs a pair of cell indices into a single key.
+ *
+ * @param x the cell's x index
+ * @param y the cell's y index
+ * @return a key unique to the cell
+ */
+static uint64_t cell_key(int32_t x, int32_t y) {
+  return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+/**
+ * Gets the x index of a cell from its key.
+ *
+ * @param cell the key of the cell
+ * @return the cell's x index
+ */
+static int32_t cell_x(uint64_t cell) { return (int32_t)(uint32_t)(cell >> 32); }
+
+/**
+ * Gets the y index of a cell from its key.
+ *
+ * @param cell the key of the cell
+ * @return the cell's y index
+ */
+static int32_t cell_y(uint64_t cell) { return (int32_t)(uint32_t)cell; }
+
+/**
+ * Orders two cell entries by cell, for qsort().
+ */
+static int compare_entries(const void *a, const void *b) {
+  uint64_t cell_a = ((const cell_entry_t *)a)->cell;
+  uint64_t cell_b = ((const cell_entry_t *)b)->cell;
+  return (cell_a > cell_b) - (cell_a < cell_b);
+}
+
+/**
+ * Adds an entry to the grid for a body in a cell.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param entry the entry to add
+ */
+static void add_entry(spatial_hash_t *hash, cell_entry_t entry) {
+  if (hash->num_entries == hash->entries_capacity) {
+    hash->entries_capacity *= 2;
+    hash->entries = realloc(hash->entries,
+                            sizeof(cell_entry_t) * hash->entries_capacity);
+    assert(hash->entries);
+  }
+  hash->entries[hash->num_entries++] = entry;
+}
+
+/**
+ * Gets the range of cells touched by a body's bounding box.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param body the body
+ * @param min_x set to the lowest x index
+ * @param min_y set to the lowest y index
+ * @param max_x set to the highest x index
+ * @param max_y set to the highest y index
+ */
+static void get_cell_range(spatial_hash_t *hash, body_t *body,
+                           int32_t *min_x, int32_t *min_y, int32_t *max_x,
+                           int32_t *max_y) {
+  aabb_t aabb = body_get_aabb(body);
+  *min_x = cell_coord(hash, aabb.min.x);
+  *min_y = cell_coord(hash, aabb.min.y);
+  *max_x = cell_coord(hash, aabb.max.x);
+  *max_y = cell_coord(hash, aabb.max.y);
+}
+
+/**
+ * Widens the range of occupied cells to include a body's cells.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param body the bucketed body
+ * @param first whether this is the first body in the grid, so the range
+ *   is reset to its cells
+ */
+static void include_cells(spatial_hash_t *hash, bucketed_body_t *body,
+                          bool first) {
+  if (first) {
+    hash->min_cell_x = body->min_x;
+    hash->min_cell_y = body->min_y;
+    hash->max_cell_x = body->max_x;
+    hash->max_cell_y = body->max_y;
+    return;
+  }
+  if (body->min_x < hash->min_cell_x) {
+    hash->min_cell_x = body->min_x;
+  }
+  if (body->min_y < hash->min_cell_y) {
+    hash->min_cell_y = body->min_y;
+  }
+  if (body->max_x > hash->max_cell_x) {
+    hash->max_cell_x = body->max_x;
+  }
+  if (body->max_y > hash->max_cell_y) {
+    hash->max_cell_y = body->max_y;
+  }
+}
+
+/**
+ * Buckets a body into every cell touched by its bounding box
+ * and marks it as indexed. Oversized bodies are kept in a separate list.
+ * The new entries are appended, so the caller must sort them.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param body the body to index
+ */
+static void insert_body(spatial_hash_t *hash, body_t *body) {
+  bucketed_body_t bucketed = {.body = body};
+  get_cell_range(hash, body, &bucketed.min_x, &bucketed.min_y,
+                 &bucketed.max_x, &bucketed.max_y);
+  int64_t num_cells = ((int64_t)bucketed.max_x - bucketed.min_x + 1) *
+                      ((int64_t)bucketed.max_y - bucketed.min_y + 1);
+  pair_set_add(hash->indexed, body, body);
+  if (num_cells > (int64_t)SPATIAL_HASH_MAX_CELLS_PER_BODY) {
+    if (hash->num_large == hash->large_capacity) {
+      hash->large_capacity *= 2;
+      hash->large =
+          realloc(hash->large, sizeof(body_t *) * hash->large_capacity);
+      assert(hash->large);
+    }
+    hash->large[hash->num_large++] = body;
+    return;
+  }
+
+  if (hash->num_bucketed == hash->bucketed_capacity) {
+    hash->bucketed_capacity *= 2;
+    hash->bucketed = realloc(hash->bucketed, sizeof(bucketed_body_t) *
+                                                 hash->bucketed_capacity);
+    hash->new_indices = realloc(hash->new_indices,
+                                sizeof(size_t) * hash->bucketed_capacity);
+    assert(hash->bucketed && hash->new_indices);
+  }
+  include_cells(hash, &bucketed, hash->num_bucketed == 0);
+  uint32_t body_index = hash->num_bucketed;
+  hash->bucketed[hash->num_bucketed++] = bucketed;
+  for (int32_t x = bucketed.min_x; x <= bucketed.max_x; x++) {
+    for (int32_t y = bucketed.min_y; y <= bucketed.max_y; y++) {
+      add_entry(hash, (cell_entry_t){.cell = cell_key(x, y),
+                                     .body = body,
+                                     .first_x = bucketed.min_x,
+                                     .first_y = bucketed.min_y,
+                                     .body_index = body_index});
+    }
+  }
+}
+
+void spatial_hash_clear(spatial_hash_t *hash) {
+  hash->num_entries = 0;
+  hash->num_bucketed = 0;
+  hash->num_large = 0;
+  pair_set_clear(hash->indexed);
+  pair_set_clear(hash->pairs);
+}
+
+void spatial_hash_index(spatial_hash_t *hash, body_t *const *bodies,
+                        size_t num_bodies) {
+  spatial_hash_clear(hash);
+  for (size_t i = 0; i < num_bodies; i++) {
+    body_t *body = bodies[i];
+    if (!body_is_removed(body)) {
+      insert_body(hash, body);
+    }
+  }
+  qsort(hash->entries, hash->num_entries, sizeof(cell_entry_t),
+        compare_entries);
+}
+
+/**
+ * Adds a body to the list of bodies for spatial_hash_update() to bucket
+ * again.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param num_moved the number of bodies in the list, updated in place
+ * @param body the body to add
+ */
+static void add_moved(spatial_hash_t *hash, size_t *num_moved, body_t *body) {
+  if (*num_moved == hash->moved_capacity) {
+    hash->moved_capacity = hash->moved_capacity > 0
+                               ? hash->moved_capacity * 2
+                               : CELL_ENTRIES_INIT_CAPACITY;
+    hash->moved =
+        realloc(hash->moved, sizeof(body_t *) * hash->moved_capacity);
+    assert(hash->moved);
+  }
+  hash->moved[(*num_moved)++] = body;
+}
+
+/**
+ * Drops bodies from the grid, along with their entries, keeping the rest
+ * in order. Bodies marked for removal are always dropped.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param drop_moved whether to also drop the bodies whose bounding boxes
+ *   now touch other cells, listing them in `hash->moved`
+ * @return the number of moved bodies listed
+ */
+static size_t drop_bodies(spatial_hash_t *hash, bool drop_moved) {
+  size_t num_moved = 0;
+  size_t num_kept = 0;
+  for (size_t i = 0; i < hash->num_bucketed; i++) {
+    bucketed_body_t body = hash->bucketed[i];
+    hash->new_indices[i] = DROPPED_BODY;
+    if (body_is_removed(body.body)) {
+      continue;
+    }
+    if (drop_moved) {
+      int32_t min_x, min_y, max_x, max_y;
+      get_cell_range(hash, body.body, &min_x, &min_y, &max_x, &max_y);
+      if (min_x != body.min_x || min_y != body.min_y ||
+          max_x != body.max_x || max_y != body.max_y) {
+        add_moved(hash, &num_moved, body.body);
+        continue;
+      }
+    }
+    include_cells(hash, &body, num_kept == 0);
+    hash->new_indices[i] = num_kept;
+    hash->bucketed[num_kept++] = body;
+  }
+  hash->num_bucketed = num_kept;
+
+  size_t num_entries = 0;
+  for (size_t i = 0; i < hash->num_entries; i++) {
+    cell_entry_t entry = hash->entries[i];
+    size_t new_index = hash->new_indices[entry.body_index];
+    if (new_index != DROPPED_BODY) {
+      entry.body_index = new_index;
+      hash->entries[num_entries++] = entry;
+    }
+  }
+  hash->num_entries = num_entries;
+  return num_moved;
+}
+
+void spatial_hash_remove_marked(spatial_hash_t *hash) {
+  drop_bodies(hash, false);
+  size_t num_kept = 0;
+  for (size_t i = 0; i < hash->num_large; i++) {
+    if (!body_is_removed(hash->large[i])) {
+      hash->large[num_kept++] = hash->large[i];
+    }
+  }
+  hash->num_large = num_kept;
+  // The sets may name the removed bodies, which are about to be freed
+  pair_set_clear(hash->indexed);
+  pair_set_clear(hash->pairs);
+}
+
+/**
+ * Sorts the entries from `num_sorted` onwards and merges them into the
+ * sorted entries before them.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param num_sorted the number of entries that are already sorted
+ */
+static void merge_new_entries(spatial_hash_t *hash, size_t num_sorted) {
+  size_t num_new = hash->num_entries - num_sorted;
+  if (num_new == 0) {
+    return;
+  }
+  if (num_new > hash->merge_buffer_capacity) {
+    hash->merge_buffer_capacity = num_new;
+    hash->merge_buffer =
+        realloc(hash->merge_buffer, sizeof(cell_entry_t) * num_new);
+    assert(hash->merge_buffer);
+  }
+  cell_entry_t *new_entries = hash->merge_buffer;
+  memcpy(new_entries, hash->entries + num_sorted,
+         sizeof(cell_entry_t) * num_new);
+  qsort(new_entries, num_new, sizeof(cell_entry_t), compare_entries);
+
+  // Merge from the back, so no old entry is overwritten before it moves
+  size_t i = num_sorted;
+  size_t j = num_new;
+  size_t k = hash->num_entries;
+  while (j > 0) {
+    if (i > 0 && hash->entries[i - 1].cell > new_entries[j - 1].cell) {
+      hash->entries[--k] = hash->entries[--i];
+    } else {
+      hash->entries[--k] = new_entries[--j];
+    }
+  }
+}
+
+void spatial_hash_update(spatial_hash_t *hash, body_t *const *new_bodies,
+                         size_t num_new_bodies) {
+  // Keep the bodies still in the same cells, with their entries in order
+  size_t num_moved = drop_bodies(hash, true);
+  size_t num_sorted = hash->num_entries;
+
+  // Large bodies may have shrunk enough to bucket, so they are all redone
+  for (size_t i = 0; i < hash->num_large; i++) {
+    if (!body_is_removed(hash->large[i])) {
+      add_moved(hash, &num_moved, hash->large[i]);
+    }
+  }
+  hash->num_large = 0;
+
+  for (size_t i = 0; i < num_moved; i++) {
+    insert_body(hash, hash->moved[i]);
+  }
+  for (size_t i = 0; i < num_new_bodies; i++) {
+    if (!body_is_removed(new_bodies[i])) {
+      insert_body(hash, new_bodies[i]);
+    }
+  }
+  merge_new_entries(hash, num_sorted);
+
+  // The candidate pairs are out of date until the next rebuild, so every
+  // pair counts as a candidate until then
+  pair_set_clear(hash->indexed);
+  pair_set_clear(hash->pairs);
+}
+
+/**
+ * Recomputes the candidate pairs from the bodies in the grid, which must
+ * be sorted.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param bodies the bodies that oversized bodies are paired with
+ * @param num_bodies the number of bodies
+ */
+static void find_pairs(spatial_hash_t *hash, body_t *const *bodies,
+                       size_t num_bodies) {
+  pair_set_clear(hash->pairs);
+
+  // Sorting grouped the entries by cell; each body appears once per cell,
+  // so every pair within a run shares that cell.
+  size_t run_start = 0;
+  for (size_t i = 1; i <= hash->num_entries; i++) {
+    if (i < hash->num_entries &&
+        hash->entries[i].cell == hash->entries[run_start].cell) {
+      continue;
+    }
+    for (size_t j = run_start; j < i; j++) {
+      for (size_t k = j + 1; k < i; k++) {
+        pair_set_add(hash->pairs, hash->entries[j].body,
+                     hash->entries[k].body);
+      }
+    }
+    run_start = i;
+  }
+
+  // Bodies too big for the grid are candidates with everything
+  for (size_t i = 0; i < hash->num_large; i++) {
+    body_t *body = hash->large[i];
+    for (size_t j = 0; j < num_bodies; j++) {
+      body_t *other = bodies[j];
+      if (other != body && !body_is_removed(other)) {
+        pair_set_add(hash->pairs, body, other);
+      }
+    }
+  }
+}
+
+void spatial_hash_rebuild(spatial_hash_t *hash, body_t *const *bodies,
+                          size_t num_bodies) {
+  spatial_hash_index(hash, bodies, num_bodies);
+  find_pairs(hash, bodies, num_bodies);
+}
+
+void spatial_hash_refresh(spatial_hash_t *hash, body_t *const *bodies,
+                          size_t num_bodies, size_t num_indexed) {
+  assert(num_indexed <= num_bodies);
+  spatial_hash_update(hash, bodies + num_indexed, num_bodies - num_indexed);
+  for (size_t i = 0; i < hash->num_bucketed; i++) {
+    body_t *body = hash->bucketed[i].body;
+    pair_set_add(hash->indexed, body, body);
+  }
+  for (size_t i = 0; i < hash->num_large; i++) {
+    pair_set_add(hash->indexed, hash->large[i], hash->large[i]);
+  }
+  find_pairs(hash, bodies, num_bodies);
+}
+
+/**
+ * Finds the first entry in a cell, or where it would be.
+ * The entries must be sorted.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param cell the key of the cell
+ * @return the index of the first entry whose cell is not less than `cell`
+ */
+static size_t find_cell(spatial_hash_t *hash, uint64_t cell) {
+  size_t low = 0;
+  size_t high = hash->num_entries;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (hash->entries[mid].cell < cell) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * Reports a body from a region query if its box overlaps the region.
+ *
+ * @param body the body
+ * @param region the query region
+ * @param results the array of results
+ * @param max_results the size of `results`
+ * @param count the number of bodies found so far, updated in place
+ */
+static void report_body(body_t *body, aabb_t region, body_t **results,
+                        size_t max_results, size_t *count) {
+  if (body_is_removed(body) || !aabb_overlaps(body_get_aabb(body), region)) {
+    return;
+  }
+  if (*count < max_results) {
+    results[*count] = body;
+  }
+  (*count)++;
+}
+
+/**
+ * Reports the body in an entry from a region query, unless it is reported
+ * from another of its cells. Each body is reported from the lowest of its
+ * cells inside the region.
+ *
+ * @param entry the entry
+ * @param min_x the lowest x index of the cells in the region
+ * @param min_y the lowest y index of the cells in the region
+ * @param region the query region
+ * @param results the array of results
+ * @param max_results the size of `results`
+ * @param count the number of bodies found so far, updated in place
+ */
+static void report_entry(cell_entry_t *entry, int32_t min_x, int32_t min_y,
+                         aabb_t region, body_t **results, size_t max_results,
+                         size_t *count) {
+  int32_t report_x = entry->first_x > min_x ? entry->first_x : min_x;
+  int32_t report_y = entry->first_y > min_y ? entry->first_y : min_y;
+  if (cell_x(entry->cell) == report_x && cell_y(entry->cell) == report_y) {
+    report_body(entry->body, region, results, max_results, count);
+  }
+}
+
+size_t spatial_hash_query_aabb(spatial_hash_t *hash, aabb_t region,
+                               body_t **results, size_t max_results) {
+  size_t count = 0;
+  for (size_t i = 0; i < hash->num_large; i++) {
+    report_body(hash->large[i], region, results, max_results, &count);
+  }
+
+  int32_t min_x = cell_coord(hash, region.min.x);
+  int32_t min_y = cell_coord(hash, region.min.y);
+  int32_t max_x = cell_coord(hash, region.max.x);
+  int32_t max_y = cell_coord(hash, region.max.y);
+  int64_t num_cells =
+      ((int64_t)max_x - min_x + 1) * ((int64_t)max_y - min_y + 1);
+
+  // A region covering more cells than there are entries is cheaper to
+  // answer by scanning the entries
+  if (num_cells > (int64_t)hash->num_entries) {
+    for (size_t i = 0; i < hash->num_entries; i++) {
+      cell_entry_t *entry = &hash->entries[i];
+      int32_t x = cell_x(entry->cell);
+      int32_t y = cell_y(entry->cell);
+      if (min_x <= x && x <= max_x && min_y <= y && y <= max_y) {
+        report_entry(entry, min_x, min_y, region, results, max_results,
+                     &count);
+      }
+    }
+    return count;
+  }
+
+  for (int32_t x = min_x; x <= max_x; x++) {
+    for (int32_t y = min_y; y <= max_y; y++) {
+      uint64_t cell = cell_key(x, y);
+      for (size_t i = find_cell(hash, cell);
+           i < hash->num_entries && hash->entries[i].cell == cell; i++) {
+        report_entry(&hash->entries[i], min_x, min_y, region, results,
+                     max_results, &count);
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * Considers a body as the nearest match to a point.
+ *
+ * @param body the body
+ * @param point the query point
+ * @param filter if non-NULL, the predicate the body must satisfy
+ * @param aux the auxiliary value for `filter`
+ * @param best the nearest body so far, updated in place
+ * @param best_distance the distance to `best`, or the maximum distance if
+ *   there is no match yet, updated in place
+ */
+static void consider_nearest(body_t *body, vector_t point,
+                             body_filter_t filter, void *aux, body_t **best,
+                             double *best_distance) {
+  if (body_is_removed(body) || (filter != NULL && !filter(body, aux))) {
+    return;
+  }
+  double distance =
+      vec_get_length(vec_subtract(body_get_centroid(body), point));
+  bool nearer = *best == NULL ? distance <= *best_distance
+                              : distance < *best_distance;
+  if (nearer) {
+    *best = body;
+    *best_distance = distance;
+  }
+}
+
+/**
+ * Considers every body in one cell as the nearest match to a point.
+ *
+ * @param hash the pointer to the spatial hash
+ * @param x the cell's x index
+ * @param y the cell's y index
+ * @param point the query point
+ * @param filter if non-NULL, the predicate the body must satisfy
+ * @param aux the auxiliary value for `filter`
+ * @param best the nearest body so far, updated in place
+ * @param best_distance the distance to `best`, updated in place
+ */
+static void consider_cell(spatial_hash_t *hash, int32_t x, int32_t y,
+                          vector_t point, body_filter_t filter, void *aux,
+                          body_t **best, double *best_distance) {
+  uint64_t cell = cell_key(x, y);
+  for (size_t i = find_cell(hash, cell);
+       i < hash->num_entries && hash->entries[i].cell == cell; i++) {
+    consider_nearest(hash->entries[i].body, point, filter, aux, best,
+                     best_distance);
+  }
+}
+
+/**
+ * Gets the smaller of two cell indices.
+ */
+static int64_t min_i64(int64_t a, int64_t b) { return a < b ? a : b; }
+
+/**
+ * Gets the larger of two cell indices.
+ */
+static int64_t max_i64(int64_t a, int64_t b) { return a > b ? a : b; }
+
+body_t *spatial_hash_nearest(spatial_hash_t *hash, vector_t point,
+                             double max_distance, body_filter_t filter,
+                             void *aux) {
+  body_t *best = NULL;
+  double best_distance = max_distance;
+  for (size_t i = 0; i < hash->num_large; i++) {
+    consider_nearest(hash->large[i], point, filter, aux, &best,
+                     &best_distance);
+  }
+  if (hash->num_entries == 0) {
+    return best;
+  }
+
+  // Search square rings of cells outwards from the point's cell. Every
+  // centroid in ring r is at least (r - 1) cells away, so the search stops
+  // once that is farther than the best match.
+  int64_t px = cell_coord(hash, point.x);
+  int64_t py = cell_coord(hash, point.y);
+  int64_t max_ring = max_i64(llabs(px - hash->min_cell_x),
+                             llabs(px - hash->max_cell_x));
+  max_ring = max_i64(max_ring, llabs(py - hash->min_cell_y));
+  max_ring = max_i64(max_ring, llabs(py - hash->max_cell_y));
+  for (int64_t ring = 0; ring <= max_ring; ring++) {
+    if (ring > 0 && (ring - 1) * hash->cell_size > best_distance) {
+      break;
+    }
+    // Only visit the part of the ring that overlaps the occupied cells
+    int64_t min_x = max_i64(px - ring, hash->min_cell_x);
+    int64_t max_x = min_i64(px + ring, hash->max_cell_x);
+    int64_t min_y = max_i64(py - ring, hash->min_cell_y);
+    int64_t max_y = min_i64(py + ring, hash->max_cell_y);
+    for (int64_t x = min_x; x <= max_x; x++) {
+      if (py - ring >= hash->min_cell_y) {
+        consider_cell(hash, x, py - ring, point, filter, aux, &best,
+                      &best_distance);
+      }
+      if (ring > 0 && py + ring <= hash->max_cell_y) {
+        consider_cell(hash, x, py + ring, point, filter, aux, &best,
+                      &best_distance);
+      }
+    }
+    for (int64_t y = max_i64(min_y, py - ring + 1);
+         y <= min_i64(max_y, py + ring - 1); y++) {
+      if (px - ring >= hash->min_cell_x) {
+        consider_cell(hash, px - ring, y, point, filter, aux, &best,
+                      &best_distance);
+      }
+      if (ring > 0 && px + ring <= hash->max_cell_x) {
+        consider_cell(hash, px + ring, y, point, filter, aux, &best,
+                      &best_distance);
+      }
+    }
+  }
+  return best;
+}
+
+double spatial_hash_cell_size(spatial_hash_t *hash) { return hash->cell_size; }
+
+bool spatial_hash_may_collide(spatial_hash_t *hash, body_t *body1,
+                              body_t *body2) {
+  if (!pair_set_contains(hash->indexed, body1, body1) ||
+      !pair_set_contains(hash->indexed, body2, body2)) {
+    return true;
+  }
+  return pair_set_contains(hash->pairs, body1, body2);
+}
+
+size_t spatial_hash_num_pairs(spatial_hash_t *hash) {
+  return pair_set_size(hash->pairs);
+}
+
+void spatial_hash_get_pair(spatial_hash_t *hash, size_t index, body_t **body1,
+                           body_t **body2) {
+  pair_set_get(hash->pairs, index, (void **)body1, (void **)body2);
+}
+
+void spatial_hash_free(spatial_hash_t *hash) {
+  free(hash->entries);
+  free(hash->bucketed);
+  free(hash->new_indices);
+  free(hash->large);
+  free(hash->moved);
+  free(hash->merge_buffer);
+  pair_set_free(hash->indexed);
+  pair_set_free(hash->pairs);
+  free(hash);
+}
@@ -0,0 +1,56 @@
+#include "timestep.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+struct timestep {
+  double step;
+  size_t max_steps;
+  // Frame time not yet simulated, in seconds; less than one step between
+  // calls to timestep_advance()
+  double accumulator;
+};
+
+timestep_t *timestep_init(double step, size_t max_steps) {
+  assert(step > 0);
+  assert(max_steps > 0);
+  timestep_t *timestep = malloc(sizeof(timestep_t));
+  assert(timestep);
+  timestep->step = step;
+  timestep->max_steps = max_steps;
+  timestep->accumulator = 0;
+  return timestep;
+}
+
+size_t timestep_advance(timestep_t *timestep, double dt) {
+  timestep->accumulator += dt;
+  size_t steps = 0;
+  while (timestep->accumulator >= timestep->step &&
+         steps < timestep->max_steps) {
+    timestep->accumulator -= timestep->step;
+    steps++;
+  }
+  if (timestep->accumulator >= timestep->step) {
+    // Too far behind to catch up, so drop the whole steps left over
+    timestep->accumulator = fmod(timestep->accumulator, timestep->step);
+  }
+  return steps;
+}
+
+double timestep_get_alpha(timestep_t *timestep) {
+  return timestep->accumulator / timestep->step;
+}
+
+double timestep_get_step(timestep_t *timestep) { return timestep->step; }
+
+void timestep_set_step(timestep_t *timestep, double step) {
+  assert(step > 0);
+  timestep->step = step;
+  // Keep the carried over time short of a step
+  timestep->accumulator = fmod(timestep->accumulator, step);
+}
+
+void timestep_reset(timestep_t *timestep) { timestep->accumulator = 0; }
+
+void timestep_free(timestep_t *timestep) { free(timestep); }
@@ -0,0 +1,34 @@
+#include "vector.h"
+
+#include <math.h>
+
+const vector_t VEC_ZERO = {.x = 0, .y = 0};
+
+vector_t vec_add(vector_t v1, vector_t v2) {
+  return (vector_t){.x = v1.x + v2.x, .y = v1.y + v2.y};
+}
+
+vector_t vec_subtract(vector_t v1, vector_t v2) {
+  return (vector_t){.x = v1.x - v2.x, .y = v1.y - v2.y};
+}
+
+vector_t vec_negate(vector_t v) { return (vector_t){.x = -v.x, .y = -v.y}; }
+
+vector_t vec_multiply(double scalar, vector_t v) {
+  return (vector_t){.x = scalar * v.x, .y = scalar * v.y};
+}
+
+double vec_dot(vector_t v1, vector_t v2) { return v1.x * v2.x + v1.y * v2.y; }
+
+double vec_cross(vector_t v1, vector_t v2) {
+  return v1.x * v2.y - v1.y * v2.x;
+}
+
+vector_t vec_rotate(vector_t v, double angle) {
+  double cos_angle = cos(angle);
+  double sin_angle = sin(angle);
+  return (vector_t){.x = v.x * cos_angle - v.y * sin_angle,
+                    .y = v.x * sin_angle + v.y * cos_angle};
+}
+
+double vec_get_length(vector_t v) { return sqrt(vec_dot(v, v)); }
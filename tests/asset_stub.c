@@ -0,0 +1,10 @@
+#include "asset.h"
+
+/**
+ * Stands in for asset.c in the native tests, which link the bodies without
+ * SDL's renderer or emscripten and have no assets to sweep.
+ */
+
+void asset_schedule_sweep() {}
+
+void asset_sweep_removed_bodies() {}
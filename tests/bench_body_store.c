@@ -0,0 +1,106 @@
+#include "body.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Benchmarks integrating 10k free-moving bodies, first one body_tick() call
+ * at a time with the motion state in each body, then with body_store_tick()
+ * over a store's contiguous arrays. Both runs start from the same state,
+ * and their final states are checked to be identical.
+ */
+
+const size_t NUM_BODIES = 10000;
+const size_t NUM_TICKS = 1000;
+const double DT = 1.0 / 120;
+const double BODY_SIZE = 4;
+const double LEVEL_SIZE = 1000;
+const double MAX_SPEED = 100;
+
+const color_t BENCH_COLOR = {0, 0, 0};
+
+/**
+ * Returns a random double in [min, max].
+ */
+static double rand_double(double min, double max) {
+  return min + (max - min) * rand() / (double)RAND_MAX;
+}
+
+/**
+ * Makes `NUM_BODIES` square bodies with random positions and velocities,
+ * the same ones each time it is called.
+ */
+static body_t **make_bodies(void) {
+  srand(1);
+  body_t **bodies = malloc(sizeof(body_t *) * NUM_BODIES);
+  assert(bodies);
+  vector_t corners[] = {
+      {0, 0}, {BODY_SIZE, 0}, {BODY_SIZE, BODY_SIZE}, {0, BODY_SIZE}};
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    list_t *shape = list_init(4, free);
+    for (size_t j = 0; j < 4; j++) {
+      vector_t *v = malloc(sizeof(vector_t));
+      *v = corners[j];
+      list_add(shape, v);
+    }
+    bodies[i] = body_init(shape, 1, BENCH_COLOR);
+    body_set_centroid(bodies[i], (vector_t){rand_double(0, LEVEL_SIZE),
+                                            rand_double(0, LEVEL_SIZE)});
+    vector_t velocity = {rand_double(-MAX_SPEED, MAX_SPEED),
+                         rand_double(-MAX_SPEED, MAX_SPEED)};
+    body_set_velocity(bodies[i], velocity);
+  }
+  return bodies;
+}
+
+/**
+ * Frees an array from make_bodies().
+ */
+static void free_bodies(body_t **bodies) {
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    body_free(bodies[i]);
+  }
+  free(bodies);
+}
+
+/**
+ * Prints a run's throughput.
+ */
+static void print_rate(const char *name, clock_t start) {
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("%-16s %8.1f M body-steps/s\n", name,
+         NUM_BODIES * NUM_TICKS / seconds / 1e6);
+}
+
+int main() {
+  body_t **separate = make_bodies();
+  clock_t start = clock();
+  for (size_t t = 0; t < NUM_TICKS; t++) {
+    for (size_t i = 0; i < NUM_BODIES; i++) {
+      body_tick(separate[i], DT);
+    }
+  }
+  print_rate("body_tick", start);
+
+  body_t **stored = make_bodies();
+  body_store_t *store = body_store_init();
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    body_store_add(store, stored[i]);
+  }
+  start = clock();
+  for (size_t t = 0; t < NUM_TICKS; t++) {
+    body_store_tick(store, DT);
+  }
+  print_rate("body_store_tick", start);
+  body_store_free(store);
+
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    vector_t c1 = body_get_centroid(separate[i]);
+    vector_t c2 = body_get_centroid(stored[i]);
+    assert(c1.x == c2.x && c1.y == c2.y);
+  }
+  free_bodies(separate);
+  free_bodies(stored);
+}
@@ -0,0 +1,224 @@
+#include "body.h"
+#include "collision.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Benchmarks the narrow phase on the game's most common pair: the character
+ * rectangle against a 12-sided coin. Prints the heap allocations and the
+ * time per test for find_collision() and for the copy-based SAT test it
+ * replaced, which is kept below for comparison.
+ *
+ * Link with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (the Makefile's
+ * bench target does) so allocations made inside the library are counted.
+ * Build with NO_ASAN=true for meaningful timings.
+ */
+
+const double CHARACTER_WIDTH = 45;
+const double CHARACTER_HEIGHT = 70;
+const double COIN_RADIUS = 15;
+const size_t COIN_NUM_POINTS = 12;
+const size_t NUM_COINS = 64;
+const size_t NUM_TESTS = 1000000;
+
+/**
+ * Coins are spread over a square of this half-width around the character,
+ * so about half of the tests find a collision.
+ */
+const double COIN_SPREAD = 60;
+
+const color_t BENCH_COLOR = {0, 0, 0};
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+/**
+ * The number of heap allocations made so far.
+ */
+static size_t num_allocations = 0;
+
+void *__wrap_malloc(size_t size) {
+  num_allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  num_allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  num_allocations++;
+  return __real_realloc(ptr, size);
+}
+
+/**
+ * Returns a random double in [min, max].
+ */
+static double rand_double(double min, double max) {
+  return min + (max - min) * rand() / (double)RAND_MAX;
+}
+
+/**
+ * Returns a list of a shape's edges. Part of the old copy-based SAT test.
+ */
+static list_t *copy_get_edges(list_t *shape) {
+  size_t n = list_size(shape);
+  list_t *edges = list_init(n, free);
+  for (size_t i = 0; i < n; i++) {
+    vector_t *vec = malloc(sizeof(vector_t));
+    assert(vec);
+    *vec = vec_subtract(*(vector_t *)list_get(shape, i),
+                        *(vector_t *)list_get(shape, (i + 1) % n));
+    list_add(edges, vec);
+  }
+  return edges;
+}
+
+/**
+ * Returns a shape's (min, max) projection onto a unit axis.
+ * Part of the old copy-based SAT test.
+ */
+static vector_t copy_get_projections(list_t *shape, vector_t unit_axis) {
+  double max = -__DBL_MAX__;
+  double min = __DBL_MAX__;
+  for (size_t i = 0; i < list_size(shape); i++) {
+    double projection = vec_dot(*(vector_t *)list_get(shape, i), unit_axis);
+    min = fmin(min, projection);
+    max = fmax(max, projection);
+  }
+  return (vector_t){min, max};
+}
+
+/**
+ * Tests the first shape's edge normals as separating axes, tracking the
+ * smallest overlap. Part of the old copy-based SAT test.
+ */
+static collision_info_t copy_compare(list_t *shape1, list_t *shape2,
+                                     double *min_overlap) {
+  collision_info_t info = {.collided = true, .axis = {0, 0}};
+  list_t *edges = copy_get_edges(shape1);
+  for (size_t i = 0; i < list_size(edges); i++) {
+    vector_t edge = *(vector_t *)list_get(edges, i);
+    vector_t axis = {.x = -edge.y, .y = edge.x};
+    double len = vec_get_length(axis);
+    if (len == 0) {
+      continue;
+    }
+    axis = vec_multiply(1.0 / len, axis);
+    vector_t proj1 = copy_get_projections(shape1, axis);
+    vector_t proj2 = copy_get_projections(shape2, axis);
+    double overlap = fmin(proj1.y, proj2.y) - fmax(proj1.x, proj2.x);
+    if (overlap <= 0) {
+      info.collided = false;
+      break;
+    }
+    if (overlap < *min_overlap) {
+      *min_overlap = overlap;
+      info.axis = axis;
+    }
+  }
+  list_free(edges);
+  return info;
+}
+
+/**
+ * The narrow phase as it was before find_collision() read vertices in
+ * place: copies both shapes with body_get_shape() and allocates the edges.
+ */
+static collision_info_t copy_find_collision(body_t *body1, body_t *body2) {
+  list_t *shape1 = body_get_shape(body1);
+  list_t *shape2 = body_get_shape(body2);
+  double overlap1 = __DBL_MAX__;
+  double overlap2 = __DBL_MAX__;
+  collision_info_t info1 = copy_compare(shape1, shape2, &overlap1);
+  collision_info_t info2 = copy_compare(shape2, shape1, &overlap2);
+  list_free(shape1);
+  list_free(shape2);
+  if (!info1.collided) {
+    return info1;
+  }
+  if (!info2.collided || overlap1 >= overlap2) {
+    return info2;
+  }
+  return info1;
+}
+
+/**
+ * Runs `NUM_TESTS` tests of the character against the coins with one of the
+ * narrow phases, and prints the collisions, allocations and time per test.
+ */
+static void run_tests(const char *name,
+                      collision_info_t (*find)(body_t *, body_t *),
+                      body_t *character, body_t **coins) {
+  // One untimed pass so any lazily computed shape data is ready
+  for (size_t i = 0; i < NUM_COINS; i++) {
+    find(character, coins[i]);
+  }
+
+  size_t num_collided = 0;
+  size_t allocations_before = num_allocations;
+  clock_t start = clock();
+  for (size_t i = 0; i < NUM_TESTS; i++) {
+    if (find(character, coins[i % NUM_COINS]).collided) {
+      num_collided++;
+    }
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  size_t allocations = num_allocations - allocations_before;
+
+  printf("  %-16s %zu collided, %.2f allocations/test, %.1f ns/test\n", name,
+         num_collided, (double)allocations / NUM_TESTS,
+         seconds * 1e9 / NUM_TESTS);
+}
+
+/**
+ * Makes a body from an array of points.
+ */
+static body_t *make_body(vector_t *points, size_t num_points, vector_t center) {
+  list_t *shape = list_init(num_points, free);
+  for (size_t i = 0; i < num_points; i++) {
+    vector_t *v = malloc(sizeof(vector_t));
+    *v = points[i];
+    list_add(shape, v);
+  }
+  body_t *body = body_init(shape, 1, BENCH_COLOR);
+  body_set_centroid(body, center);
+  return body;
+}
+
+int main() {
+  srand(1);
+  vector_t corners[] = {{0, 0},
+                        {CHARACTER_WIDTH, 0},
+                        {CHARACTER_WIDTH, CHARACTER_HEIGHT},
+                        {0, CHARACTER_HEIGHT}};
+  body_t *character = make_body(corners, 4, VEC_ZERO);
+
+  vector_t coin_points[COIN_NUM_POINTS];
+  for (size_t i = 0; i < COIN_NUM_POINTS; i++) {
+    double angle = 2 * M_PI * i / COIN_NUM_POINTS;
+    coin_points[i] =
+        (vector_t){COIN_RADIUS * cos(angle), COIN_RADIUS * sin(angle)};
+  }
+  body_t *coins[NUM_COINS];
+  for (size_t i = 0; i < NUM_COINS; i++) {
+    vector_t center = {rand_double(-COIN_SPREAD, COIN_SPREAD),
+                       rand_double(-COIN_SPREAD, COIN_SPREAD)};
+    coins[i] = make_body(coin_points, COIN_NUM_POINTS, center);
+  }
+
+  printf("character vs coin, %zu tests:\n", NUM_TESTS);
+  run_tests("copy-based SAT", copy_find_collision, character, coins);
+  run_tests("find_collision", find_collision, character, coins);
+
+  for (size_t i = 0; i < NUM_COINS; i++) {
+    body_free(coins[i]);
+  }
+  body_free(character);
+}
@@ -0,0 +1,69 @@
+#include "body.h"
+#include "scene.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Benchmarks removing 1,000 bodies from a scene with 10,000 bodies and
+ * 10,000 force creators. Each creator acts on a pair of neighbouring bodies.
+ * Prints the time of the tick that frees the removed bodies and their
+ * creators, next to a tick with nothing to remove.
+ */
+
+const size_t NUM_BODIES = 10000;
+const size_t NUM_REMOVED = 1000;
+const double DT = 1.0 / 120;
+const double BODY_RADIUS = 1;
+
+const color_t BENCH_COLOR = {0, 0, 0};
+
+/**
+ * A force creator that does nothing, so the ticks only measure the scene's
+ * own bookkeeping.
+ */
+static void no_force(void *aux, list_t *bodies) {}
+
+/**
+ * Times one scene tick, in milliseconds.
+ */
+static double time_tick(scene_t *scene) {
+  clock_t start = clock();
+  scene_tick(scene, DT);
+  return (double)(clock() - start) / CLOCKS_PER_SEC * 1000;
+}
+
+int main() {
+  scene_t *scene = scene_init();
+  body_t **bodies = malloc(sizeof(body_t *) * NUM_BODIES);
+  assert(bodies);
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    vector_t center = {(double)i * 4 * BODY_RADIUS, 0};
+    bodies[i] = body_init_circle(center, BODY_RADIUS, 1, BENCH_COLOR, NULL,
+                                 NULL);
+    scene_add_body(scene, bodies[i]);
+  }
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    list_t *pair = list_init(2, NULL);
+    list_add(pair, bodies[i]);
+    list_add(pair, bodies[(i + 1) % NUM_BODIES]);
+    scene_add_force_creator(scene, no_force, NULL, pair, NULL);
+  }
+
+  double idle_ms = time_tick(scene);
+  // Spread the removals out, so they are not all at the end of the arrays
+  size_t stride = NUM_BODIES / NUM_REMOVED;
+  for (size_t i = 0; i < NUM_REMOVED; i++) {
+    body_remove(bodies[i * stride]);
+  }
+  double remove_ms = time_tick(scene);
+
+  printf("tick with nothing removed: %.2f ms\n", idle_ms);
+  printf("tick removing %zu of %zu bodies and their creators: %.2f ms\n",
+         NUM_REMOVED, NUM_BODIES, remove_ms);
+
+  free(bodies);
+  scene_free(scene);
+}
@@ -0,0 +1,94 @@
+#include "body.h"
+#include "spatial_hash.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Benchmarks the spatial hash broad phase at increasing body counts.
+ * The bodies are scattered at a fixed density, as in a level that grows
+ * wider, so the candidate pairs should grow linearly with the body count
+ * while the creators an all-pairs setup registers grow quadratically.
+ */
+
+const size_t MIN_BODIES = 1000;
+const size_t MAX_BODIES = 8000;
+const size_t NUM_REBUILDS = 100;
+
+/**
+ * Matches the game's broad phase cell size.
+ */
+const double CELL_SIZE = 100;
+
+/**
+ * The area of the level per body, i.e. about one body per cell.
+ */
+const double AREA_PER_BODY = 100 * 100;
+
+const double MIN_BODY_SIZE = 10;
+const double MAX_BODY_SIZE = 60;
+
+const color_t BENCH_COLOR = {0, 0, 0};
+
+/**
+ * Returns a random double in [min, max].
+ */
+static double rand_double(double min, double max) {
+  return min + (max - min) * rand() / (double)RAND_MAX;
+}
+
+/**
+ * Makes a rectangular body centered on a point.
+ */
+static body_t *make_rectangle(vector_t center, double width, double height) {
+  vector_t corners[] = {{0, 0}, {width, 0}, {width, height}, {0, height}};
+  list_t *shape = list_init(4, free);
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(vector_t));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  body_t *body = body_init(shape, 1, BENCH_COLOR);
+  body_set_centroid(body, center);
+  return body;
+}
+
+int main() {
+  srand(1);
+  printf("%8s %16s %16s %12s %14s\n", "bodies", "all-pairs", "candidates",
+         "per body", "us/rebuild");
+  for (size_t num_bodies = MIN_BODIES; num_bodies <= MAX_BODIES;
+       num_bodies *= 2) {
+    double side = sqrt(num_bodies * AREA_PER_BODY);
+    body_t **bodies = malloc(sizeof(body_t *) * num_bodies);
+    assert(bodies);
+    for (size_t i = 0; i < num_bodies; i++) {
+      vector_t center = {rand_double(0, side), rand_double(0, side)};
+      bodies[i] =
+          make_rectangle(center, rand_double(MIN_BODY_SIZE, MAX_BODY_SIZE),
+                         rand_double(MIN_BODY_SIZE, MAX_BODY_SIZE));
+    }
+
+    spatial_hash_t *hash = spatial_hash_init(CELL_SIZE);
+    clock_t start = clock();
+    for (size_t i = 0; i < NUM_REBUILDS; i++) {
+      spatial_hash_rebuild(hash, bodies, num_bodies);
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    size_t num_pairs = spatial_hash_num_pairs(hash);
+    size_t all_pairs = num_bodies * (num_bodies - 1) / 2;
+    printf("%8zu %16zu %16zu %12.2f %14.1f\n", num_bodies, all_pairs,
+           num_pairs, (double)num_pairs / num_bodies,
+           seconds * 1e6 / NUM_REBUILDS);
+
+    spatial_hash_free(hash);
+    for (size_t i = 0; i < num_bodies; i++) {
+      body_free(bodies[i]);
+    }
+    free(bodies);
+  }
+}
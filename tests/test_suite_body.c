@@ -0,0 +1,272 @@
+#include "body.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+/**
+ * The store tests tick the same bodies in a store and on their own with
+ * body_tick(), and check that they end up in the same place.
+ */
+#define NUM_BODIES 90
+const size_t NUM_TICKS = 200;
+const double DT = 0.01;
+const double BODY_RADIUS = 1;
+const double MAX_SPEED = 3;
+const double MAX_FORCE = 4;
+
+/**
+ * How often, in ticks per body, the random store test pushes a body, stops
+ * it, and changes its motion class.
+ */
+const int PUSH_PERIOD = 50;
+const int STOP_PERIOD = 20;
+const int MOTION_CHANGE_PERIOD = 150;
+
+const vector_t TEST_FORCE = {5, 0};
+const vector_t TEST_VELOCITY = {2, 1};
+
+const color_t TEST_COLOR = {0, 0, 0};
+
+/**
+ * Makes a circle at the origin.
+ */
+static body_t *make_body() {
+  return body_init_circle(VEC_ZERO, BODY_RADIUS, 1, TEST_COLOR, NULL, NULL);
+}
+
+/**
+ * Returns a random double in [min, max].
+ */
+static double rand_double(double min, double max) {
+  return min + (max - min) * rand() / (double)RAND_MAX;
+}
+
+/**
+ * Ticks a store for at least as long as a body at rest takes to fall
+ * asleep.
+ */
+static void tick_until_asleep(body_store_t *store) {
+  size_t num_ticks = (size_t)ceil(BODY_SLEEP_TIME / DT) + 1;
+  for (size_t i = 0; i < num_ticks; i++) {
+    body_store_tick(store, DT);
+  }
+}
+
+void test_static_and_kinematic_ignore_forces() {
+  body_store_t *store = body_store_init();
+  body_t *fixed = make_body();
+  body_t *kinematic = make_body();
+  body_set_motion(fixed, BODY_STATIC);
+  body_set_motion(kinematic, BODY_KINEMATIC);
+  body_set_velocity(kinematic, TEST_VELOCITY);
+  body_store_add(store, fixed);
+  body_store_add(store, kinematic);
+  for (size_t i = 0; i < NUM_TICKS; i++) {
+    body_add_force(fixed, TEST_FORCE);
+    body_add_force(kinematic, TEST_FORCE);
+    body_add_impulse(kinematic, TEST_FORCE);
+    body_store_tick(store, DT);
+  }
+  assert(vec_equal(body_get_centroid(fixed), VEC_ZERO));
+  assert(vec_isclose(body_get_velocity(kinematic), TEST_VELOCITY));
+  assert(vec_isclose(body_get_centroid(kinematic),
+                     vec_multiply(NUM_TICKS * DT, TEST_VELOCITY)));
+  // Neither kind ever sleeps
+  assert(!body_is_sleeping(fixed));
+  assert(!body_is_sleeping(kinematic));
+  body_free(fixed);
+  body_free(kinematic);
+  body_store_free(store);
+}
+
+void test_body_sleeps_at_rest() {
+  body_store_t *store = body_store_init();
+  body_t *body = make_body();
+  body_store_add(store, body);
+  // Not quite long enough
+  size_t num_ticks = (size_t)(BODY_SLEEP_TIME / DT) - 1;
+  for (size_t i = 0; i < num_ticks; i++) {
+    body_store_tick(store, DT);
+  }
+  assert(!body_is_sleeping(body));
+  tick_until_asleep(store);
+  assert(body_is_sleeping(body));
+
+  // A moving body stays awake
+  body_t *moving = make_body();
+  body_set_velocity(moving, TEST_VELOCITY);
+  body_store_add(store, moving);
+  tick_until_asleep(store);
+  assert(!body_is_sleeping(moving));
+
+  // A body outside a store never sleeps
+  body_t *unstored = make_body();
+  for (size_t i = 0; i < NUM_TICKS; i++) {
+    body_tick(unstored, DT);
+  }
+  assert(!body_is_sleeping(unstored));
+
+  body_free(body);
+  body_free(moving);
+  body_free(unstored);
+  body_store_free(store);
+}
+
+void test_sleeping_body_wakes() {
+  body_store_t *store = body_store_init();
+  body_t *body = make_body();
+  body_store_add(store, body);
+
+  tick_until_asleep(store);
+  body_add_force(body, TEST_FORCE);
+  assert(!body_is_sleeping(body));
+  body_store_tick(store, DT);
+  assert(body_get_centroid(body).x > 0);
+
+  body_set_velocity(body, VEC_ZERO);
+  tick_until_asleep(store);
+  vector_t centroid = body_get_centroid(body);
+  body_add_impulse(body, TEST_FORCE);
+  assert(!body_is_sleeping(body));
+  body_store_tick(store, DT);
+  assert(body_get_centroid(body).x > centroid.x);
+
+  body_set_velocity(body, VEC_ZERO);
+  tick_until_asleep(store);
+  body_set_velocity(body, TEST_VELOCITY);
+  assert(!body_is_sleeping(body));
+
+  body_set_velocity(body, VEC_ZERO);
+  tick_until_asleep(store);
+  body_wake(body);
+  assert(!body_is_sleeping(body));
+
+  // Setting a zero velocity does not wake a body up
+  tick_until_asleep(store);
+  body_set_velocity(body, VEC_ZERO);
+  assert(body_is_sleeping(body));
+  // Neither does a force on a static body
+  body_set_motion(body, BODY_STATIC);
+  assert(!body_is_sleeping(body));
+  body_add_force(body, TEST_FORCE);
+  body_store_tick(store, DT);
+  assert(body_get_motion(body) == BODY_STATIC);
+  assert(vec_equal(body_get_velocity(body), VEC_ZERO));
+
+  body_free(body);
+  body_store_free(store);
+}
+
+void test_store_tick_matches_body_tick() {
+  srand(4);
+  body_store_t *store = body_store_init();
+  body_t *stored[NUM_BODIES];
+  body_t *unstored[NUM_BODIES];
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    stored[i] = make_body();
+    unstored[i] = make_body();
+    body_motion_t motion = i % 3;
+    body_set_motion(stored[i], motion);
+    body_set_motion(unstored[i], motion);
+    vector_t velocity = {rand_double(-MAX_SPEED, MAX_SPEED),
+                         rand_double(-MAX_SPEED, MAX_SPEED)};
+    body_set_velocity(stored[i], velocity);
+    body_set_velocity(unstored[i], velocity);
+    body_store_add(store, stored[i]);
+  }
+
+  size_t num_sleeping = 0;
+  for (size_t t = 0; t < NUM_TICKS; t++) {
+    // Moves bodies between the store's ranges as it goes
+    for (size_t i = 0; i < NUM_BODIES; i++) {
+      if (rand() % PUSH_PERIOD == 0) {
+        vector_t force = {rand_double(-MAX_FORCE, MAX_FORCE),
+                          rand_double(-MAX_FORCE, MAX_FORCE)};
+        body_add_force(stored[i], force);
+        body_add_force(unstored[i], force);
+      }
+      if (rand() % STOP_PERIOD == 0) {
+        body_set_velocity(stored[i], VEC_ZERO);
+        body_set_velocity(unstored[i], VEC_ZERO);
+      }
+      if (rand() % MOTION_CHANGE_PERIOD == 0) {
+        body_motion_t motion = rand() % 3;
+        body_set_motion(stored[i], motion);
+        body_set_motion(unstored[i], motion);
+      }
+    }
+    body_store_tick(store, DT);
+    for (size_t i = 0; i < NUM_BODIES; i++) {
+      body_tick(unstored[i], DT);
+      if (body_is_sleeping(stored[i])) {
+        // Sleep stops a body that is barely moving
+        num_sleeping++;
+        body_set_velocity(unstored[i], VEC_ZERO);
+      }
+      assert(vec_isclose(body_get_centroid(stored[i]),
+                         body_get_centroid(unstored[i])));
+    }
+  }
+  assert(num_sleeping > 0);
+
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    body_free(stored[i]);
+    body_free(unstored[i]);
+  }
+  body_store_free(store);
+}
+
+void test_store_remove_keeps_motion() {
+  body_store_t *store = body_store_init();
+  body_t *bodies[3];
+  for (size_t i = 0; i < 3; i++) {
+    bodies[i] = make_body();
+    body_set_motion(bodies[i], i);
+    body_set_velocity(bodies[i], TEST_VELOCITY);
+    body_store_add(store, bodies[i]);
+  }
+  body_store_tick(store, DT);
+  vector_t centroid = body_get_centroid(bodies[BODY_KINEMATIC]);
+
+  // The body that takes over each freed slot keeps its own state
+  body_store_remove(bodies[BODY_DYNAMIC]);
+  assert(body_store_size(store) == 2);
+  assert(body_get_motion(bodies[BODY_DYNAMIC]) == BODY_DYNAMIC);
+  assert(body_get_motion(bodies[BODY_KINEMATIC]) == BODY_KINEMATIC);
+  assert(body_get_motion(bodies[BODY_STATIC]) == BODY_STATIC);
+  assert(vec_equal(body_get_centroid(bodies[BODY_KINEMATIC]), centroid));
+  assert(vec_equal(body_get_centroid(bodies[BODY_STATIC]), VEC_ZERO));
+
+  body_store_remove(bodies[BODY_KINEMATIC]);
+  assert(body_get_motion(bodies[BODY_KINEMATIC]) == BODY_KINEMATIC);
+  assert(vec_equal(body_get_velocity(bodies[BODY_KINEMATIC]),
+                   TEST_VELOCITY));
+  body_tick(bodies[BODY_KINEMATIC], DT);
+  assert(vec_isclose(body_get_centroid(bodies[BODY_KINEMATIC]),
+                     vec_add(centroid, vec_multiply(DT, TEST_VELOCITY))));
+
+  for (size_t i = 0; i < 3; i++) {
+    body_free(bodies[i]);
+  }
+  body_store_free(store);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_static_and_kinematic_ignore_forces)
+  DO_TEST(test_body_sleeps_at_rest)
+  DO_TEST(test_sleeping_body_wakes)
+  DO_TEST(test_store_tick_matches_body_tick)
+  DO_TEST(test_store_remove_keeps_motion)
+
+  puts("body_test PASS");
+}
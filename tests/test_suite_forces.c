@@ -0,0 +1,223 @@
+#include "body.h"
+#include "collision_group.h"
+#include "contact_queue.h"
+#include "forces.h"
+#include "scene.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+/**
+ * The swept collision tests have a still character and an obstacle that
+ * starts to its right and moves left fast enough to pass through it in
+ * a single tick.
+ */
+const double BODY_SIZE = 10;
+const vector_t OBSTACLE_START = {100, 0};
+const vector_t OBSTACLE_VELOCITY = {-2000, 0};
+const double DT = 0.1;
+const size_t NUM_TICKS = 3;
+
+/**
+ * The obstacle's left edge starts 90 units from the character's right edge
+ * and moves 200 units per tick, so they touch 0.45 of the way through the
+ * tick in which the obstacle passes the character.
+ */
+const double CONTACT_TIME = 0.45;
+
+const color_t TEST_COLOR = {0, 0, 0};
+
+/**
+ * What the collision handlers saw.
+ */
+typedef struct {
+  size_t num_calls;
+  vector_t axis;
+  double time;
+} handler_record_t;
+
+/**
+ * Makes a square body centered on a point.
+ */
+static body_t *make_square(vector_t center) {
+  vector_t corners[] = {
+      {0, 0}, {BODY_SIZE, 0}, {BODY_SIZE, BODY_SIZE}, {0, BODY_SIZE}};
+  list_t *shape = list_init(4, free);
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(vector_t));
+    assert(v);
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  body_t *body = body_init(shape, 1, TEST_COLOR);
+  body_set_centroid(body, center);
+  return body;
+}
+
+static void record_collision(body_t *body1, body_t *body2, vector_t axis,
+                             void *aux, double force_const) {
+  handler_record_t *record = aux;
+  record->num_calls++;
+  record->axis = axis;
+}
+
+static void record_timed_collision(body_t *body1, body_t *body2,
+                                   vector_t axis, double time, void *aux,
+                                   double force_const) {
+  handler_record_t *record = aux;
+  record->num_calls++;
+  record->axis = axis;
+  record->time = time;
+}
+
+/**
+ * Adds the character and the obstacle to a scene.
+ */
+static void add_bodies(scene_t *scene, body_t **character,
+                       body_t **obstacle) {
+  *character = make_square(VEC_ZERO);
+  *obstacle = make_square(OBSTACLE_START);
+  body_set_velocity(*obstacle, OBSTACLE_VELOCITY);
+  scene_add_body(scene, *character);
+  scene_add_body(scene, *obstacle);
+}
+
+/**
+ * Ticks a scene until the obstacle is well past the character.
+ */
+static void run_ticks(scene_t *scene, body_t *character) {
+  for (size_t i = 0; i < NUM_TICKS; i++) {
+    scene_tick(scene, DT);
+  }
+  assert(vec_equal(body_get_centroid(character), VEC_ZERO));
+}
+
+void test_collision_misses_tunneling() {
+  scene_t *scene = scene_init();
+  body_t *character, *obstacle;
+  add_bodies(scene, &character, &obstacle);
+  handler_record_t record = {.num_calls = 0};
+  create_collision(scene, character, obstacle, record_collision, &record, 0,
+                   NULL);
+  run_ticks(scene, character);
+  assert(record.num_calls == 0);
+  scene_free(scene);
+}
+
+void test_swept_collision_catches_tunneling() {
+  scene_t *scene = scene_init();
+  body_t *character, *obstacle;
+  add_bodies(scene, &character, &obstacle);
+  handler_record_t record = {.num_calls = 0};
+  create_swept_collision(scene, character, obstacle, record_collision,
+                         &record, 0, NULL);
+  run_ticks(scene, character);
+  assert(record.num_calls == 1);
+  assert(vec_isclose(record.axis, (vector_t){1, 0}));
+  scene_free(scene);
+}
+
+void test_timed_swept_collision_time() {
+  scene_t *scene = scene_init();
+  body_t *character, *obstacle;
+  add_bodies(scene, &character, &obstacle);
+  handler_record_t record = {.num_calls = 0, .time = -1};
+  create_timed_swept_collision(scene, character, obstacle,
+                               record_timed_collision, &record, 0, NULL);
+  run_ticks(scene, character);
+  assert(record.num_calls == 1);
+  assert(vec_isclose(record.axis, (vector_t){1, 0}));
+  assert(isclose(record.time, CONTACT_TIME));
+  scene_free(scene);
+}
+
+void test_timed_swept_collision_overlapping() {
+  // Bodies that already overlap when the sweep starts touch at time 0
+  scene_t *scene = scene_init();
+  body_t *character = make_square(VEC_ZERO);
+  body_t *obstacle = make_square((vector_t){BODY_SIZE / 2, 0});
+  scene_add_body(scene, character);
+  scene_add_body(scene, obstacle);
+  handler_record_t record = {.num_calls = 0, .time = -1};
+  create_timed_swept_collision(scene, character, obstacle,
+                               record_timed_collision, &record, 0, NULL);
+  run_ticks(scene, character);
+  assert(record.num_calls == 1);
+  assert(record.time == 0);
+  scene_free(scene);
+}
+
+/**
+ * Counts the contact events of each type.
+ */
+static void count_contact_event(contact_event_t event, void *aux) {
+  size_t *counts = aux;
+  counts[event.type]++;
+}
+
+/**
+ * Ticks two overlapping bodies in a group contact pass, then separates
+ * them, and counts the events of each type that the pass pushed.
+ */
+static void count_contact_events(bool stay_events, size_t *counts) {
+  scene_t *scene = scene_init();
+  collision_group_t *group_a = collision_group_init();
+  collision_group_t *group_b = collision_group_init();
+  contact_queue_t *queue = contact_queue_init();
+  body_t *body1 = make_square(VEC_ZERO);
+  body_t *body2 = make_square((vector_t){BODY_SIZE / 2, 0});
+  scene_add_body(scene, body1);
+  scene_add_body(scene, body2);
+  collision_group_add(group_a, body1);
+  collision_group_add(group_b, body2);
+  create_group_contact_events(scene, group_a, group_b, queue, stay_events);
+
+  for (size_t i = 0; i < NUM_TICKS; i++) {
+    scene_tick(scene, DT);
+  }
+  body_set_centroid(body2, OBSTACLE_START);
+  scene_tick(scene, DT);
+  contact_queue_drain(queue, count_contact_event, counts);
+
+  scene_free(scene);
+  contact_queue_free(queue);
+  collision_group_free(group_a);
+  collision_group_free(group_b);
+}
+
+void test_contact_events_without_stay() {
+  size_t counts[3] = {0};
+  count_contact_events(false, counts);
+  assert(counts[CONTACT_BEGIN] == 1);
+  assert(counts[CONTACT_STAY] == 0);
+  assert(counts[CONTACT_END] == 1);
+}
+
+void test_contact_events_with_stay() {
+  size_t counts[3] = {0};
+  count_contact_events(true, counts);
+  assert(counts[CONTACT_BEGIN] == 1);
+  assert(counts[CONTACT_STAY] == NUM_TICKS - 1);
+  assert(counts[CONTACT_END] == 1);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_collision_misses_tunneling)
+  DO_TEST(test_swept_collision_catches_tunneling)
+  DO_TEST(test_timed_swept_collision_time)
+  DO_TEST(test_timed_swept_collision_overlapping)
+  DO_TEST(test_contact_events_without_stay)
+  DO_TEST(test_contact_events_with_stay)
+
+  puts("forces_test PASS");
+}
@@ -0,0 +1,227 @@
+#include "body.h"
+#include "jobs.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+/**
+ * These tests start real worker threads, so they are built natively
+ * (see NATIVE_TEST_LIBS in the Makefile); under node the pool runs every
+ * job inline.
+ */
+const size_t NUM_THREADS = 4;
+
+/**
+ * Not a multiple of any chunk size below, so the last chunk is short.
+ */
+const size_t NUM_INDICES = 10007;
+const size_t CHUNK_SIZES[] = {1, 7, 100, 4096, 20000};
+
+/**
+ * Makes later indices take longer, so threads finish their own chunks at
+ * different times and have to steal.
+ */
+const size_t WORK_PER_INDEX = 2;
+
+/**
+ * Bodies in the store test: several chunks of BODY_STORE_CHUNK_SIZE,
+ * plus a partial one.
+ */
+const size_t NUM_BODIES = 10000;
+const size_t NUM_TICKS = 100;
+const double DT = 1.0 / 120;
+const double BODY_RADIUS = 1;
+const double LEVEL_SIZE = 1000;
+const double MAX_SPEED = 100;
+const double MAX_FORCE = 50;
+
+const color_t TEST_COLOR = {0, 0, 0};
+
+/**
+ * What the jobs of one job_pool_parallel_for() call saw.
+ */
+typedef struct {
+  // How many times each index was handed to a job
+  size_t *visits;
+  // A value derived from each index, so the work is not optimized away
+  volatile size_t *results;
+} visit_record_t;
+
+static void visit_range(void *aux, size_t start, size_t end) {
+  visit_record_t *record = aux;
+  for (size_t i = start; i < end; i++) {
+    record->visits[i]++;
+    size_t result = 0;
+    for (size_t j = 0; j < i * WORK_PER_INDEX; j++) {
+      result += j;
+    }
+    record->results[i] = result;
+  }
+}
+
+/**
+ * Runs one parallel for over `NUM_INDICES` indices and checks that each
+ * index was visited exactly once.
+ */
+static void check_visits(job_pool_t *pool, size_t chunk_size) {
+  visit_record_t record = {.visits = calloc(NUM_INDICES, sizeof(size_t)),
+                           .results = malloc(sizeof(size_t) * NUM_INDICES)};
+  assert(record.visits && record.results);
+  job_pool_parallel_for(pool, NUM_INDICES, chunk_size, visit_range, &record);
+  for (size_t i = 0; i < NUM_INDICES; i++) {
+    assert(record.visits[i] == 1);
+  }
+  free(record.visits);
+  free((size_t *)record.results);
+}
+
+void test_parallel_for_visits_each_index_once() {
+  job_pool_t *pool = job_pool_init(NUM_THREADS);
+  assert(job_pool_num_threads(pool) == NUM_THREADS);
+  size_t num_chunk_sizes = sizeof(CHUNK_SIZES) / sizeof(CHUNK_SIZES[0]);
+  for (size_t i = 0; i < num_chunk_sizes; i++) {
+    check_visits(pool, CHUNK_SIZES[i]);
+  }
+  // An empty batch returns without running anything
+  job_pool_parallel_for(pool, 0, 1, visit_range, NULL);
+  job_pool_free(pool);
+}
+
+/**
+ * The ranges the jobs of one job_pool_parallel_for() call ran, in order.
+ */
+typedef struct {
+  pthread_t caller;
+  size_t num_ranges;
+  size_t *starts;
+  bool all_on_caller;
+} range_record_t;
+
+static void record_range(void *aux, size_t start, size_t end) {
+  range_record_t *record = aux;
+  if (!pthread_equal(pthread_self(), record->caller)) {
+    record->all_on_caller = false;
+  }
+  record->starts[record->num_ranges++] = start;
+}
+
+void test_single_threaded_runs_inline() {
+  job_pool_t *pool = job_pool_init(NUM_THREADS);
+  job_pool_set_single_threaded(pool, true);
+  assert(job_pool_num_threads(pool) == 1);
+
+  size_t chunk_size = 100;
+  size_t num_chunks = (NUM_INDICES + chunk_size - 1) / chunk_size;
+  range_record_t record = {.caller = pthread_self(),
+                           .num_ranges = 0,
+                           .starts = malloc(sizeof(size_t) * num_chunks),
+                           .all_on_caller = true};
+  assert(record.starts);
+  job_pool_parallel_for(pool, NUM_INDICES, chunk_size, record_range, &record);
+  assert(record.all_on_caller);
+  assert(record.num_ranges == num_chunks);
+  for (size_t i = 0; i < num_chunks; i++) {
+    assert(record.starts[i] == i * chunk_size);
+  }
+  free(record.starts);
+
+  // The worker threads are used again once it is switched back
+  job_pool_set_single_threaded(pool, false);
+  assert(job_pool_num_threads(pool) == NUM_THREADS);
+  check_visits(pool, chunk_size);
+  job_pool_free(pool);
+}
+
+/**
+ * Returns a random double in [min, max].
+ */
+static double rand_double(double min, double max) {
+  return min + (max - min) * rand() / (double)RAND_MAX;
+}
+
+/**
+ * Makes `NUM_BODIES` circles with random positions and velocities,
+ * the same ones each time it is called, and adds them to a store.
+ */
+static body_t **make_stored_bodies(body_store_t *store) {
+  srand(1);
+  body_t **bodies = malloc(sizeof(body_t *) * NUM_BODIES);
+  assert(bodies);
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    vector_t center = {rand_double(0, LEVEL_SIZE),
+                       rand_double(0, LEVEL_SIZE)};
+    vector_t velocity = {rand_double(-MAX_SPEED, MAX_SPEED),
+                         rand_double(-MAX_SPEED, MAX_SPEED)};
+    bodies[i] = body_init_circle(center, BODY_RADIUS, 1, TEST_COLOR, NULL,
+                                 NULL);
+    body_set_velocity(bodies[i], velocity);
+    body_store_add(store, bodies[i]);
+  }
+  return bodies;
+}
+
+/**
+ * Ticks a store's bodies with the same forces each time it is called.
+ */
+static void run_store_ticks(body_store_t *store, body_t **bodies,
+                            job_pool_t *pool) {
+  srand(2);
+  for (size_t t = 0; t < NUM_TICKS; t++) {
+    for (size_t i = 0; i < NUM_BODIES; i++) {
+      vector_t force = {rand_double(-MAX_FORCE, MAX_FORCE),
+                        rand_double(-MAX_FORCE, MAX_FORCE)};
+      body_add_force(bodies[i], force);
+    }
+    body_store_tick_with_jobs(store, DT, pool);
+  }
+}
+
+void test_threaded_store_tick_matches_unthreaded() {
+  body_store_t *inline_store = body_store_init();
+  body_t **inline_bodies = make_stored_bodies(inline_store);
+  run_store_ticks(inline_store, inline_bodies, NULL);
+
+  job_pool_t *pool = job_pool_init(NUM_THREADS);
+  body_store_t *threaded_store = body_store_init();
+  body_t **threaded_bodies = make_stored_bodies(threaded_store);
+  run_store_ticks(threaded_store, threaded_bodies, pool);
+
+  // Each body is integrated by the same code either way, so the results
+  // must match bit for bit
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    vector_t c1 = body_get_centroid(inline_bodies[i]);
+    vector_t c2 = body_get_centroid(threaded_bodies[i]);
+    vector_t v1 = body_get_velocity(inline_bodies[i]);
+    vector_t v2 = body_get_velocity(threaded_bodies[i]);
+    assert(memcmp(&c1, &c2, sizeof(vector_t)) == 0);
+    assert(memcmp(&v1, &v2, sizeof(vector_t)) == 0);
+  }
+
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    body_free(inline_bodies[i]);
+    body_free(threaded_bodies[i]);
+  }
+  free(inline_bodies);
+  free(threaded_bodies);
+  body_store_free(inline_store);
+  body_store_free(threaded_store);
+  job_pool_free(pool);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_parallel_for_visits_each_index_once)
+  DO_TEST(test_single_threaded_runs_inline)
+  DO_TEST(test_threaded_store_tick_matches_unthreaded)
+
+  puts("jobs_test PASS");
+}
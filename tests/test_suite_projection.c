@@ -0,0 +1,122 @@
+#include "projection.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+/**
+ * Checks every vertex count up to this, so each kernel's remainder loop
+ * runs with every possible number of leftover vertices.
+ */
+const size_t MAX_TEST_VERTICES = 33;
+const size_t NUM_RANDOM_TRIALS = 200;
+const double MAX_COORDINATE = 1000;
+
+/**
+ * Returns a random double in [min, max].
+ */
+static double rand_double(double min, double max) {
+  return min + (max - min) * rand() / (double)RAND_MAX;
+}
+
+/**
+ * Returns a random unit vector.
+ */
+static vector_t rand_unit_axis(void) {
+  double angle = rand_double(0, 2 * M_PI);
+  return (vector_t){cos(angle), sin(angle)};
+}
+
+/**
+ * The reference result: projects each vertex with vec_dot, one at a time.
+ */
+static vector_t project_one_by_one(const vector_t *vertices,
+                                   size_t num_vertices, vector_t unit_axis) {
+  double min = INFINITY;
+  double max = -INFINITY;
+  for (size_t i = 0; i < num_vertices; i++) {
+    double projection = vec_dot(vertices[i], unit_axis);
+    min = fmin(min, projection);
+    max = fmax(max, projection);
+  }
+  return (vector_t){min, max};
+}
+
+/**
+ * Checks project_vertices() against the reference on `num_vertices` random
+ * vertices starting at `vertices`.
+ */
+static void check_random(vector_t *vertices, size_t num_vertices) {
+  for (size_t i = 0; i < num_vertices; i++) {
+    vertices[i] = (vector_t){rand_double(-MAX_COORDINATE, MAX_COORDINATE),
+                             rand_double(-MAX_COORDINATE, MAX_COORDINATE)};
+  }
+  vector_t axis = rand_unit_axis();
+  vector_t expected = project_one_by_one(vertices, num_vertices, axis);
+  assert(vec_isclose(project_vertices(vertices, num_vertices, axis), expected));
+}
+
+void test_square() {
+  vector_t square[] = {{0, 0}, {2, 0}, {2, 2}, {0, 2}};
+  assert(vec_isclose(project_vertices(square, 4, (vector_t){1, 0}),
+                     (vector_t){0, 2}));
+  assert(vec_isclose(project_vertices(square, 4, (vector_t){0, -1}),
+                     (vector_t){-2, 0}));
+  double diagonal = sqrt(2) / 2;
+  assert(vec_isclose(
+      project_vertices(square, 4, (vector_t){diagonal, diagonal}),
+      (vector_t){0, 2 * sqrt(2)}));
+}
+
+void test_single_vertex() {
+  vector_t point[] = {{3, -4}};
+  assert(vec_isclose(project_vertices(point, 1, (vector_t){0, 1}),
+                     (vector_t){-4, -4}));
+}
+
+void test_extreme_in_each_lane() {
+  // Put the extremes at every index, so each SIMD lane and the scalar tail
+  // all have to report them
+  vector_t vertices[MAX_TEST_VERTICES];
+  for (size_t n = 1; n <= MAX_TEST_VERTICES; n++) {
+    for (size_t extreme = 0; extreme < n; extreme++) {
+      for (size_t i = 0; i < n; i++) {
+        vertices[i] = (vector_t){(double)i / n, 0};
+      }
+      vertices[extreme] = (vector_t){-5, 0};
+      vector_t result = project_vertices(vertices, n, (vector_t){1, 0});
+      assert(isclose(result.x, -5));
+      vertices[extreme] = (vector_t){5, 0};
+      result = project_vertices(vertices, n, (vector_t){1, 0});
+      assert(isclose(result.y, 5));
+    }
+  }
+}
+
+void test_random_polygons() {
+  vector_t vertices[MAX_TEST_VERTICES];
+  for (size_t trial = 0; trial < NUM_RANDOM_TRIALS; trial++) {
+    for (size_t n = 1; n <= MAX_TEST_VERTICES; n++) {
+      check_random(vertices, n);
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  srand(1);
+  DO_TEST(test_square)
+  DO_TEST(test_single_vertex)
+  DO_TEST(test_extreme_in_each_lane)
+  DO_TEST(test_random_polygons)
+
+  puts("projection_test PASS");
+}
@@ -0,0 +1,643 @@
+#include "body.h"
+#include "collision.h"
+#include "scene.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The query tests scatter moving bodies over a level, with the spatial hash
+ * enabled, and check each query's results against a search of every body.
+ */
+const double CELL_SIZE = 100;
+const double LEVEL_SIZE = 1000;
+const double MAX_BODY_SIZE = 80;
+const double MAX_SPEED = 300;
+const size_t NUM_BODIES = 200;
+const size_t NUM_CHANGED = 10;
+const size_t NUM_QUERIES = 20;
+const size_t NUM_TICKS = 30;
+const double DT = 0.05;
+
+/**
+ * Queries in the tests store at most this many bodies.
+ */
+#define MAX_RESULTS 256
+
+const color_t TEST_COLOR = {0, 0, 0};
+
+/**
+ * Returns a random double in [min, max].
+ */
+static double rand_double(double min, double max) {
+  return min + (max - min) * rand() / (double)RAND_MAX;
+}
+
+/**
+ * Makes a square body centered on a point.
+ */
+static body_t *make_square(vector_t center, double size) {
+  vector_t corners[] = {{0, 0}, {size, 0}, {size, size}, {0, size}};
+  list_t *shape = list_init(4, free);
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(vector_t));
+    assert(v);
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  body_t *body = body_init(shape, 1, TEST_COLOR);
+  body_set_centroid(body, center);
+  return body;
+}
+
+/**
+ * Makes a square or circle with a random position, size and velocity.
+ */
+static body_t *make_random_body() {
+  vector_t center = {rand_double(0, LEVEL_SIZE), rand_double(0, LEVEL_SIZE)};
+  double size = rand_double(1, MAX_BODY_SIZE);
+  body_t *body = rand() % 2
+                     ? make_square(center, size)
+                     : body_init_circle(center, size / 2, 1, TEST_COLOR,
+                                        NULL, NULL);
+  body_set_velocity(body, (vector_t){rand_double(-MAX_SPEED, MAX_SPEED),
+                                     rand_double(-MAX_SPEED, MAX_SPEED)});
+  return body;
+}
+
+/**
+ * Returns whether a body is in an array of query results.
+ */
+static bool contains(body_t **results, size_t num_results, body_t *body) {
+  for (size_t i = 0; i < num_results; i++) {
+    if (results[i] == body) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Checks that a query of a region finds exactly the bodies, not marked for
+ * removal, whose bounding boxes overlap it.
+ */
+static void check_query(scene_t *scene, aabb_t region) {
+  body_t *results[MAX_RESULTS];
+  size_t num_results = scene_query_aabb(scene, region, results, MAX_RESULTS);
+  assert(num_results <= MAX_RESULTS);
+
+  size_t num_expected = 0;
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (!body_is_removed(body) &&
+        aabb_overlaps(body_get_aabb(body), region)) {
+      assert(contains(results, num_results, body));
+      num_expected++;
+    }
+  }
+  assert(num_results == num_expected);
+}
+
+/**
+ * Checks `NUM_QUERIES` queries of random regions of the level.
+ */
+static void check_random_queries(scene_t *scene) {
+  for (size_t i = 0; i < NUM_QUERIES; i++) {
+    vector_t min = {rand_double(-MAX_BODY_SIZE, LEVEL_SIZE),
+                    rand_double(-MAX_BODY_SIZE, LEVEL_SIZE)};
+    vector_t max = {min.x + rand_double(0, 3 * CELL_SIZE),
+                    min.y + rand_double(0, 3 * CELL_SIZE)};
+    check_query(scene, (aabb_t){min, max});
+  }
+}
+
+/**
+ * Makes a scene of random bodies with the spatial hash enabled.
+ */
+static scene_t *make_random_scene() {
+  srand(1);
+  scene_t *scene = scene_init();
+  scene_enable_spatial_hash(scene, CELL_SIZE);
+  for (size_t i = 0; i < NUM_BODIES; i++) {
+    scene_add_body(scene, make_random_body());
+  }
+  return scene;
+}
+
+void test_query_after_ticks() {
+  scene_t *scene = make_random_scene();
+  check_random_queries(scene);
+  for (size_t i = 0; i < NUM_TICKS; i++) {
+    scene_tick(scene, DT);
+    check_random_queries(scene);
+  }
+  scene_free(scene);
+}
+
+void test_query_after_removals_and_additions() {
+  scene_t *scene = make_random_scene();
+  for (size_t i = 0; i < NUM_TICKS; i++) {
+    for (size_t j = 0; j < NUM_CHANGED; j++) {
+      body_remove(scene_get_body(scene, rand() % scene_bodies(scene)));
+    }
+    // Removed bodies are skipped before the tick that frees them
+    check_random_queries(scene);
+    for (size_t j = 0; j < NUM_CHANGED; j++) {
+      scene_add_body(scene, make_random_body());
+    }
+    // Added bodies are found before the tick that indexes them
+    check_random_queries(scene);
+    scene_tick(scene, DT);
+    check_random_queries(scene);
+  }
+  scene_free(scene);
+}
+
+void test_query_after_teleport() {
+  scene_t *scene = make_random_scene();
+  scene_tick(scene, DT);
+  check_random_queries(scene);
+  for (size_t i = 0; i < NUM_TICKS; i++) {
+    for (size_t j = 0; j < NUM_CHANGED; j++) {
+      body_t *body = scene_get_body(scene, rand() % scene_bodies(scene));
+      body_set_centroid(body, (vector_t){rand_double(0, LEVEL_SIZE),
+                                         rand_double(0, LEVEL_SIZE)});
+    }
+    // A moved body is found at its new position after the next tick
+    scene_tick(scene, DT);
+    check_random_queries(scene);
+  }
+  scene_free(scene);
+}
+
+void test_query_follows_moving_body() {
+  // A body crossing many cells is found only where it is after each tick
+  scene_t *scene = scene_init();
+  scene_enable_spatial_hash(scene, CELL_SIZE);
+  body_t *body = make_square(VEC_ZERO, 1);
+  body_set_velocity(body, (vector_t){CELL_SIZE / DT, 0});
+  scene_add_body(scene, body);
+  body_t *results[1];
+  for (size_t i = 1; i <= NUM_TICKS; i++) {
+    scene_tick(scene, DT);
+    double x = body_get_centroid(body).x;
+    aabb_t here = {{x - 1, -1}, {x + 1, 1}};
+    aabb_t before = {{x - CELL_SIZE - 1, -1}, {x - CELL_SIZE + 1, 1}};
+    assert(isclose(x, i * CELL_SIZE));
+    assert(scene_query_aabb(scene, here, results, 1) == 1);
+    assert(results[0] == body);
+    assert(scene_query_aabb(scene, before, results, 1) == 0);
+  }
+  scene_free(scene);
+}
+
+/**
+ * The tag tests give the bodies of a scene one of a few tags, or none.
+ */
+const size_t NUM_TAGS = 3;
+#define NUM_TAGGED_BODIES 60
+
+/**
+ * What one scene_for_each_tagged() call saw.
+ */
+typedef struct {
+  scene_t *scene;
+  uint32_t tag;
+  size_t num_visits;
+  // Bodies visited, in order
+  body_t *visited[NUM_TAGGED_BODIES];
+  // Whether to remove the next body in the scene with the same tag after
+  // each body visited
+  bool remove_next;
+  // Whether to add a body with the same tag for each body visited
+  bool add_tagged;
+} tag_visit_t;
+
+/**
+ * Records a body visited by scene_for_each_tagged(), then changes the scene
+ * as the tag_visit_t asks.
+ */
+static void visit_tagged(body_t *body, void *aux) {
+  tag_visit_t *visit = aux;
+  assert(body_get_tag(body) == visit->tag);
+  assert(!body_is_removed(body));
+  visit->visited[visit->num_visits++] = body;
+  if (visit->remove_next) {
+    bool found = false;
+    for (size_t i = 0; i < scene_bodies(visit->scene); i++) {
+      body_t *other = scene_get_body(visit->scene, i);
+      if (found && body_get_tag(other) == visit->tag) {
+        body_remove(other);
+        break;
+      }
+      found = found || other == body;
+    }
+  }
+  if (visit->add_tagged) {
+    body_t *added = make_square(VEC_ZERO, 1);
+    body_set_tag(added, visit->tag);
+    scene_add_body(visit->scene, added);
+  }
+}
+
+/**
+ * Makes a scene whose bodies cycle through the tags and no tag.
+ */
+static scene_t *make_tagged_scene() {
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < NUM_TAGGED_BODIES; i++) {
+    body_t *body = make_square((vector_t){i, 0}, 1);
+    if (i % (NUM_TAGS + 1) < NUM_TAGS) {
+      body_set_tag(body, i % (NUM_TAGS + 1));
+    }
+    scene_add_body(scene, body);
+  }
+  return scene;
+}
+
+/**
+ * Counts the bodies of a scene with a tag that are not marked for removal.
+ */
+static size_t count_live_tagged(scene_t *scene, uint32_t tag) {
+  size_t count = 0;
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (!body_is_removed(body) && body_get_tag(body) == tag) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * Checks that scene_for_each_tagged() visits each live body with a tag
+ * exactly once, and no others.
+ */
+static void check_tagged_visits(scene_t *scene, uint32_t tag) {
+  tag_visit_t visit = {.scene = scene, .tag = tag};
+  scene_for_each_tagged(scene, tag, visit_tagged, &visit);
+  assert(visit.num_visits == count_live_tagged(scene, tag));
+  for (size_t i = 0; i < visit.num_visits; i++) {
+    for (size_t j = i + 1; j < visit.num_visits; j++) {
+      assert(visit.visited[i] != visit.visited[j]);
+    }
+  }
+}
+
+void test_tagged_visits_and_counts() {
+  scene_t *scene = make_tagged_scene();
+  for (uint32_t tag = 0; tag < NUM_TAGS; tag++) {
+    assert(scene_count_tagged(scene, tag) == count_live_tagged(scene, tag));
+    check_tagged_visits(scene, tag);
+  }
+  // Tags no body has, including ones past every bucket
+  assert(scene_count_tagged(scene, NUM_TAGS) == 0);
+  assert(scene_count_tagged(scene, BODY_TAG_NONE) == 0);
+  tag_visit_t visit = {.scene = scene, .tag = NUM_TAGS};
+  scene_for_each_tagged(scene, NUM_TAGS, visit_tagged, &visit);
+  assert(visit.num_visits == 0);
+  scene_free(scene);
+}
+
+void test_tagged_after_removals() {
+  scene_t *scene = make_tagged_scene();
+  size_t count_before = scene_count_tagged(scene, 1);
+  size_t num_removed = 0;
+  for (size_t i = 0; i < scene_bodies(scene); i += 3) {
+    body_t *body = scene_get_body(scene, i);
+    if (body_get_tag(body) == 1) {
+      num_removed++;
+    }
+    body_remove(body);
+  }
+  assert(num_removed > 0);
+  // Removed bodies are counted until the tick that frees them, but never
+  // visited
+  assert(scene_count_tagged(scene, 1) == count_before);
+  check_tagged_visits(scene, 1);
+  scene_tick(scene, DT);
+  assert(scene_count_tagged(scene, 1) == count_before - num_removed);
+  for (uint32_t tag = 0; tag < NUM_TAGS; tag++) {
+    assert(scene_count_tagged(scene, tag) == count_live_tagged(scene, tag));
+    check_tagged_visits(scene, tag);
+  }
+  scene_free(scene);
+}
+
+void test_tagged_func_adds_bodies() {
+  // Bodies added by the function are left for the next call
+  scene_t *scene = make_tagged_scene();
+  size_t count_before = scene_count_tagged(scene, 2);
+  tag_visit_t visit = {.scene = scene, .tag = 2, .add_tagged = true};
+  scene_for_each_tagged(scene, 2, visit_tagged, &visit);
+  assert(visit.num_visits == count_before);
+  assert(scene_count_tagged(scene, 2) == 2 * count_before);
+  check_tagged_visits(scene, 2);
+  scene_free(scene);
+}
+
+void test_tagged_func_removes_bodies() {
+  // Bodies removed by the function partway through are skipped, so each
+  // visit removes the body that would have been visited next
+  scene_t *scene = make_tagged_scene();
+  size_t count_before = scene_count_tagged(scene, 0);
+  tag_visit_t visit = {.scene = scene, .tag = 0, .remove_next = true};
+  scene_for_each_tagged(scene, 0, visit_tagged, &visit);
+  assert(visit.num_visits == (count_before + 1) / 2);
+  for (size_t i = 0; i < visit.num_visits; i++) {
+    assert(visit.visited[i] ==
+           scene_get_body(scene, 2 * i * (NUM_TAGS + 1)));
+  }
+  check_tagged_visits(scene, 0);
+  scene_free(scene);
+}
+
+/**
+ * The snapshot tests take a snapshot of a small scene with a force creator
+ * between each pair of neighbouring bodies, change the scene, restore it,
+ * and check that it is back the way it was.
+ */
+#define NUM_SNAPSHOT_BODIES 20
+const size_t NUM_ADDED = 10;
+const size_t REMOVED_INDICES[] = {3, 7, 19};
+
+/**
+ * A scene built by make_snapshot_scene(), and what it was like when the
+ * snapshot was taken.
+ */
+typedef struct {
+  scene_t *scene;
+  scene_snapshot_t *snapshot;
+  body_t *bodies[NUM_SNAPSHOT_BODIES];
+  body_handle_t handles[NUM_SNAPSHOT_BODIES];
+  body_state_t states[NUM_SNAPSHOT_BODIES];
+  // How many times the force creator after each body has run
+  size_t creator_calls[NUM_SNAPSHOT_BODIES];
+  // How many times the force creators added after the snapshot have run
+  size_t added_creator_calls;
+} snapshot_test_t;
+
+/**
+ * A force creator that counts its calls in the size_t its aux points to.
+ */
+static void count_calls(void *aux, list_t *bodies) { (*(size_t *)aux)++; }
+
+/**
+ * Adds a force creator acting on two bodies that counts its calls.
+ */
+static void add_counting_creator(scene_t *scene, body_t *body1,
+                                 body_t *body2, size_t *calls) {
+  list_t *bodies = list_init(2, NULL);
+  list_add(bodies, body1);
+  list_add(bodies, body2);
+  scene_add_force_creator(scene, count_calls, calls, bodies, NULL);
+}
+
+/**
+ * Makes a scene of bodies in different states, ticks it and takes a
+ * snapshot of it.
+ */
+static snapshot_test_t *make_snapshot_scene() {
+  snapshot_test_t *test = calloc(1, sizeof(snapshot_test_t));
+  assert(test);
+  test->scene = scene_init();
+  for (size_t i = 0; i < NUM_SNAPSHOT_BODIES; i++) {
+    body_t *body = make_square((vector_t){i * MAX_BODY_SIZE, i}, i + 1);
+    body_set_velocity(body, (vector_t){i, -(double)i});
+    body_set_rotation(body, i * 0.1);
+    body_set_tag(body, i % 2);
+    if (i % 5 == 0) {
+      body_set_motion(body, BODY_KINEMATIC);
+    }
+    test->bodies[i] = body;
+    test->handles[i] = scene_add_body(test->scene, body);
+  }
+  for (size_t i = 0; i < NUM_SNAPSHOT_BODIES; i++) {
+    add_counting_creator(test->scene, test->bodies[i],
+                         test->bodies[(i + 1) % NUM_SNAPSHOT_BODIES],
+                         &test->creator_calls[i]);
+  }
+  scene_tick(test->scene, DT);
+  for (size_t i = 0; i < NUM_SNAPSHOT_BODIES; i++) {
+    // Left over from the last tick, to check it is restored too
+    body_add_force(test->bodies[i], (vector_t){1, 2});
+    test->states[i] = body_get_state(test->bodies[i]);
+  }
+  test->snapshot = scene_snapshot(test->scene);
+  return test;
+}
+
+/**
+ * Returns whether two body states are the same.
+ */
+static bool states_equal(body_state_t state1, body_state_t state2) {
+  return vec_equal(state1.centroid, state2.centroid) &&
+         vec_equal(state1.velocity, state2.velocity) &&
+         vec_equal(state1.force, state2.force) &&
+         vec_equal(state1.impulse, state2.impulse) &&
+         state1.rotation == state2.rotation &&
+         state1.motion == state2.motion &&
+         state1.sleeping == state2.sleeping &&
+         state1.removed == state2.removed;
+}
+
+/**
+ * Checks that a restored scene has the snapshot's bodies, in order, in
+ * their saved states, and that their handles resolve to them.
+ */
+static void check_restored_bodies(snapshot_test_t *test) {
+  assert(scene_bodies(test->scene) == NUM_SNAPSHOT_BODIES);
+  for (size_t i = 0; i < NUM_SNAPSHOT_BODIES; i++) {
+    body_t *body = test->bodies[i];
+    assert(scene_get_body(test->scene, i) == body);
+    assert(scene_resolve(test->scene, test->handles[i]) == body);
+    assert(states_equal(body_get_state(body), test->states[i]));
+  }
+  assert(scene_count_tagged(test->scene, 0) == NUM_SNAPSHOT_BODIES / 2);
+  assert(scene_count_tagged(test->scene, 1) == NUM_SNAPSHOT_BODIES / 2);
+}
+
+/**
+ * Checks that exactly the snapshot's force creators run after a restore,
+ * and that they are still linked to their bodies: removing a body drops
+ * the two creators acting on it and no others.
+ */
+static void check_restored_creators(snapshot_test_t *test) {
+  memset(test->creator_calls, 0, sizeof(test->creator_calls));
+  test->added_creator_calls = 0;
+  scene_tick(test->scene, DT);
+  for (size_t i = 0; i < NUM_SNAPSHOT_BODIES; i++) {
+    assert(test->creator_calls[i] == 1);
+  }
+  assert(test->added_creator_calls == 0);
+
+  // The tick that frees a removed body still runs its creators
+  size_t removed = NUM_SNAPSHOT_BODIES / 2;
+  body_remove(test->bodies[removed]);
+  scene_tick(test->scene, DT);
+  scene_tick(test->scene, DT);
+  for (size_t i = 0; i < NUM_SNAPSHOT_BODIES; i++) {
+    bool linked = i == removed || i == removed - 1;
+    assert(test->creator_calls[i] == (linked ? 2 : 3));
+  }
+}
+
+/**
+ * Frees a snapshot test's snapshot and scene.
+ */
+static void free_snapshot_scene(snapshot_test_t *test) {
+  scene_snapshot_free(test->snapshot);
+  scene_free(test->scene);
+  free(test);
+}
+
+void test_restore_after_additions() {
+  snapshot_test_t *test = make_snapshot_scene();
+  body_handle_t added[NUM_ADDED];
+  for (size_t i = 0; i < NUM_ADDED; i++) {
+    body_t *body = make_square((vector_t){-(double)i, i}, 1);
+    body_set_tag(body, 0);
+    added[i] = scene_add_body(test->scene, body);
+    add_counting_creator(test->scene, body, test->bodies[i],
+                         &test->added_creator_calls);
+  }
+  scene_tick(test->scene, DT);
+  assert(test->added_creator_calls == NUM_ADDED);
+
+  scene_restore(test->scene, test->snapshot);
+  check_restored_bodies(test);
+  for (size_t i = 0; i < NUM_ADDED; i++) {
+    assert(scene_resolve(test->scene, added[i]) == NULL);
+  }
+  check_restored_creators(test);
+  free_snapshot_scene(test);
+}
+
+void test_restore_after_removals() {
+  snapshot_test_t *test = make_snapshot_scene();
+  size_t num_removed = sizeof(REMOVED_INDICES) / sizeof(REMOVED_INDICES[0]);
+  for (size_t i = 0; i < num_removed; i++) {
+    size_t index = REMOVED_INDICES[i];
+    // Remove some bodies directly and some through their handles
+    if (i % 2 == 0) {
+      body_remove(test->bodies[index]);
+    } else {
+      assert(scene_remove_handle(test->scene, test->handles[index]));
+    }
+  }
+  scene_tick(test->scene, DT);
+  assert(scene_bodies(test->scene) == NUM_SNAPSHOT_BODIES - num_removed);
+  assert(scene_resolve(test->scene, test->handles[REMOVED_INDICES[0]]) ==
+         NULL);
+
+  scene_restore(test->scene, test->snapshot);
+  check_restored_bodies(test);
+  check_restored_creators(test);
+  free_snapshot_scene(test);
+}
+
+void test_restore_after_ticks() {
+  snapshot_test_t *test = make_snapshot_scene();
+  // The snapshot can be restored any number of times
+  for (size_t i = 0; i < 2; i++) {
+    for (size_t j = 0; j < NUM_TICKS; j++) {
+      scene_tick(test->scene, DT);
+    }
+    assert(!vec_equal(body_get_centroid(test->bodies[1]),
+                      test->states[1].centroid));
+    scene_restore(test->scene, test->snapshot);
+    check_restored_bodies(test);
+  }
+  check_restored_creators(test);
+  free_snapshot_scene(test);
+}
+
+void test_restore_after_clear() {
+  snapshot_test_t *test = make_snapshot_scene();
+  for (size_t i = 0; i < NUM_SNAPSHOT_BODIES; i++) {
+    body_remove(test->bodies[i]);
+  }
+  scene_tick(test->scene, DT);
+  assert(scene_bodies(test->scene) == 0);
+  assert(scene_count_tagged(test->scene, 0) == 0);
+
+  scene_restore(test->scene, test->snapshot);
+  check_restored_bodies(test);
+  check_restored_creators(test);
+  free_snapshot_scene(test);
+}
+
+/**
+ * The interpolation tests tick a scene once and draw a frame a quarter of
+ * the way into the next tick.
+ */
+const double INTERPOLATION_ALPHA = 0.25;
+const vector_t INTERPOLATION_VELOCITY = {10, 0};
+const vector_t JUMP_TARGET = {5, 5};
+
+void test_interpolation_between_ticks() {
+  scene_t *scene = scene_init();
+  body_t *moving = make_square(VEC_ZERO, 2);
+  body_t *turning = make_square(VEC_ZERO, 2);
+  body_t *jumping = make_square(VEC_ZERO, 2);
+  body_set_velocity(moving, INTERPOLATION_VELOCITY);
+  body_set_rotation(turning, 1);
+  scene_add_body(scene, moving);
+  scene_add_body(scene, turning);
+  scene_add_body(scene, jumping);
+  scene_tick(scene, DT);
+  // Game code run after the tick counts as part of it
+  body_set_rotation(turning, 2);
+  body_set_centroid(jumping, JUMP_TARGET);
+  body_reset_interpolation(jumping);
+  vector_t centroid = body_get_centroid(moving);
+
+  scene_begin_interpolation(scene, INTERPOLATION_ALPHA);
+  vector_t drawn = vec_multiply(INTERPOLATION_ALPHA, centroid);
+  assert(vec_isclose(body_get_centroid(moving), drawn));
+  assert(isclose(body_get_aabb(moving).min.x, drawn.x - 1));
+  assert(isclose(body_get_rotation(turning), 1 + INTERPOLATION_ALPHA));
+  assert(vec_equal(body_get_centroid(jumping), JUMP_TARGET));
+  scene_end_interpolation(scene);
+
+  assert(vec_equal(body_get_centroid(moving), centroid));
+  assert(isclose(body_get_aabb(moving).min.x, centroid.x - 1));
+  assert(body_get_rotation(turning) == 2);
+
+  // A body added since the last tick is drawn where it is
+  body_t *added = make_square(JUMP_TARGET, 2);
+  scene_add_body(scene, added);
+  scene_begin_interpolation(scene, INTERPOLATION_ALPHA);
+  assert(vec_equal(body_get_centroid(added), JUMP_TARGET));
+  scene_end_interpolation(scene);
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_query_after_ticks)
+  DO_TEST(test_query_after_removals_and_additions)
+  DO_TEST(test_query_after_teleport)
+  DO_TEST(test_query_follows_moving_body)
+  DO_TEST(test_tagged_visits_and_counts)
+  DO_TEST(test_tagged_after_removals)
+  DO_TEST(test_tagged_func_adds_bodies)
+  DO_TEST(test_tagged_func_removes_bodies)
+  DO_TEST(test_restore_after_additions)
+  DO_TEST(test_restore_after_removals)
+  DO_TEST(test_restore_after_ticks)
+  DO_TEST(test_restore_after_clear)
+  DO_TEST(test_interpolation_between_ticks)
+
+  puts("scene_test PASS");
+}
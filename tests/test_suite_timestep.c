@@ -0,0 +1,93 @@
+#include "test_util.h"
+#include "timestep.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const double STEP = 0.01;
+const size_t MAX_STEPS = 3;
+
+/**
+ * The carry over test feeds in frames of random length up to this many
+ * steps, but never more than MAX_STEPS, so no time is dropped.
+ */
+const size_t NUM_FRAMES = 1000;
+const double MAX_FRAME_STEPS = 2.5;
+
+void test_advance_whole_steps() {
+  timestep_t *timestep = timestep_init(STEP, MAX_STEPS);
+  assert(timestep_get_step(timestep) == STEP);
+  assert(timestep_get_alpha(timestep) == 0);
+
+  assert(timestep_advance(timestep, 2.5 * STEP) == 2);
+  assert(isclose(timestep_get_alpha(timestep), 0.5));
+  // Less than a step, so it is carried over again
+  assert(timestep_advance(timestep, 0.4 * STEP) == 0);
+  assert(isclose(timestep_get_alpha(timestep), 0.9));
+  assert(timestep_advance(timestep, 0.2 * STEP) == 1);
+  assert(isclose(timestep_get_alpha(timestep), 0.1));
+  timestep_free(timestep);
+}
+
+void test_carry_over_adds_up() {
+  srand(5);
+  timestep_t *timestep = timestep_init(STEP, MAX_STEPS);
+  double total_time = 0;
+  size_t total_steps = 0;
+  for (size_t i = 0; i < NUM_FRAMES; i++) {
+    double dt = MAX_FRAME_STEPS * STEP * rand() / RAND_MAX;
+    total_time += dt;
+    total_steps += timestep_advance(timestep, dt);
+    double alpha = timestep_get_alpha(timestep);
+    assert(alpha >= 0 && alpha < 1);
+    // The steps taken and the time carried over make up all the time fed
+    // in so far
+    assert(fabs((total_steps + alpha) * STEP - total_time) < 1e-9);
+  }
+  timestep_free(timestep);
+}
+
+void test_max_steps_drops_backlog() {
+  timestep_t *timestep = timestep_init(STEP, MAX_STEPS);
+  assert(timestep_advance(timestep, 10.5 * STEP) == MAX_STEPS);
+  // The steps that did not fit are dropped, not left for the next frame
+  assert(isclose(timestep_get_alpha(timestep), 0.5));
+  assert(timestep_advance(timestep, 0) == 0);
+  assert(timestep_advance(timestep, 0.5 * STEP) == 1);
+  timestep_free(timestep);
+}
+
+void test_set_step_and_reset() {
+  timestep_t *timestep = timestep_init(STEP, MAX_STEPS);
+  assert(timestep_advance(timestep, 0.75 * STEP) == 0);
+  // Time carried over is kept, but stays short of the new step
+  timestep_set_step(timestep, 2 * STEP);
+  assert(timestep_get_step(timestep) == 2 * STEP);
+  assert(isclose(timestep_get_alpha(timestep), 0.375));
+  timestep_set_step(timestep, 0.5 * STEP);
+  assert(isclose(timestep_get_alpha(timestep), 0.5));
+  assert(timestep_advance(timestep, 0.3 * STEP) == 1);
+
+  timestep_reset(timestep);
+  assert(timestep_get_alpha(timestep) == 0);
+  assert(timestep_advance(timestep, 0.25 * STEP) == 0);
+  timestep_free(timestep);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_advance_whole_steps)
+  DO_TEST(test_carry_over_adds_up)
+  DO_TEST(test_max_steps_drops_backlog)
+  DO_TEST(test_set_step_and_reset)
+
+  puts("timestep_test PASS");
+}
@@ -0,0 +1,69 @@
+#include "test_util.h"
+
+#include <assert.h>
+#include <math.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdlib.h>
+
+/**
+ * The largest difference isclose() and vec_isclose() allow.
+ */
+const double TEST_EPSILON = 1e-7;
+
+bool within(double epsilon, double d1, double d2) {
+  return fabs(d1 - d2) < epsilon;
+}
+
+bool isclose(double d1, double d2) { return within(TEST_EPSILON, d1, d2); }
+
+bool vec_equal(vector_t v1, vector_t v2) {
+  return v1.x == v2.x && v1.y == v2.y;
+}
+
+bool vec_within(double epsilon, vector_t v1, vector_t v2) {
+  return within(epsilon, v1.x, v2.x) && within(epsilon, v1.y, v2.y);
+}
+
+bool vec_isclose(vector_t v1, vector_t v2) {
+  return vec_within(TEST_EPSILON, v1, v2);
+}
+
+void read_testname(char *filename, char *testname, size_t testname_size) {
+  FILE *testname_file = fopen(filename, "r");
+  if (testname_file == NULL) {
+    printf("Couldn't open file %s\n", filename);
+    exit(1);
+  }
+  char *read = fgets(testname, testname_size, testname_file);
+  if (read == NULL) {
+    printf("Couldn't read test name from file %s\n", filename);
+    exit(1);
+  }
+  // Strip the trailing newline, if any
+  testname[strcspn(testname, "\n")] = '\0';
+  fclose(testname_file);
+}
+
+/**
+ * Where test_assert_fail() resumes when `run` aborts.
+ */
+static jmp_buf env;
+
+/**
+ * Jumps back into test_assert_fail() on SIGABRT.
+ */
+static void handle_abort(int signal) {
+  (void)signal;
+  longjmp(env, 1);
+}
+
+bool test_assert_fail(void (*run)(void *aux), void *aux) {
+  void (*old_handler)(int) = signal(SIGABRT, handle_abort);
+  bool failed = setjmp(env) != 0;
+  if (!failed) {
+    run(aux);
+  }
+  signal(SIGABRT, old_handler);
+  return failed;
+}